@@ -83,6 +83,11 @@ void Application::TriggerResize()
 	render.Resize();
 }
 
+void Application::TriggerGUIToggle()
+{
+	render.ToggleGUI();
+}
+
 void Application::KeyCallback(GLFWwindow * window, int key, int scancode, int action, int mods)
 {
 	// Reload the shaders
@@ -90,6 +95,10 @@ void Application::KeyCallback(GLFWwindow * window, int key, int scancode, int ac
 	{
 		static_cast<Application*>(glfwGetWindowUserPointer(window))->TriggerShaderReload();
 	}
+	else if (key == KEY_BINDINGS::TOGGLE_GUI && action == GLFW_PRESS)
+	{
+		static_cast<Application*>(glfwGetWindowUserPointer(window))->TriggerGUIToggle();
+	}
 	else if(key == GLFW_KEY_SPACE && action == GLFW_PRESS)
 	{
 		static_cast<Application*>(glfwGetWindowUserPointer(window))->broadcastCursor = !static_cast<Application*>(glfwGetWindowUserPointer(window))->broadcastCursor;
@@ -17,6 +17,7 @@ public:
 
 	void TriggerShaderReload();
 	void TriggerResize();
+	void TriggerGUIToggle();
 
 	static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 	static void MouseCallback(GLFWwindow* window, int button, int action, int mods);
@@ -40,7 +41,8 @@ private:
 		LEFT = GLFW_KEY_A,
 		DOWN = GLFW_KEY_S,
 		RIGHT = GLFW_KEY_D,
-		RELOAD = GLFW_KEY_R
+		RELOAD = GLFW_KEY_R,
+		TOGGLE_GUI = GLFW_KEY_F1
 	};
 
 	Camera *_Camera;
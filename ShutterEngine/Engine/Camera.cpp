@@ -67,12 +67,27 @@ CameraUniformData Camera::GetUniformData()
 }
 
 glm::mat4 Camera::GetProjection() const
+{
+	glm::mat4 proj = GetUnjitteredProjection();
+
+	// Shift the clip space by a fraction of a pixel
+	proj[2][0] += _Jitter.x * 2.0f / float(_Width);
+	proj[2][1] += _Jitter.y * 2.0f / float(_Height);
+	return proj;
+}
+
+glm::mat4 Camera::GetUnjitteredProjection() const
 {
 	glm::mat4 proj = glm::perspective(glm::radians(_FOV), float(_Width) / float(_Height), 0.1f, 100.0f);
 	proj[1][1] *= -1;
 	return proj;
 }
 
+void Camera::SetJitter(const glm::vec2 & jitter)
+{
+	_Jitter = jitter;
+}
+
 glm::mat4 Camera::GetView() const
 {
 	return glm::lookAt(_Position, _Position + _Front, _Up);
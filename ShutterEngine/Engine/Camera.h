@@ -26,14 +26,25 @@ public:
 	CameraUniformData GetUniformData();
 
 	glm::mat4 GetProjection() const;
+	glm::mat4 GetUnjitteredProjection() const;
 	glm::mat4 GetView() const;
 
+	// Vertical field of view, in degrees
+	float GetFOV() const {
+		return _FOV;
+	}
+
+	// Sub-pixel offset applied to the projection, in pixels
+	void SetJitter(const glm::vec2 &jitter);
+
 	uint16_t _Width;
 	uint16_t _Height;
 
 private:
 	float _FOV;
 
+	glm::vec2 _Jitter = glm::vec2(0.0f, 0.0f);
+
 	glm::vec3 _Front;
 	glm::vec3 _Up;
 	glm::vec3 _Right;
@@ -0,0 +1,149 @@
+#include "ClusterCulling.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+
+Frustum::Frustum(const glm::mat4 &matrix)
+{
+	// glm is column major
+	const glm::vec4 row0(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+	const glm::vec4 row1(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+	const glm::vec4 row2(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+	const glm::vec4 row3(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+
+	// The near plane is OpenGL's, looser than the one of a zero to one depth range so right with both
+	_Planes = { { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 } };
+
+	for (auto &plane : _Planes) {
+		const float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f) {
+			plane /= length;
+		}
+	}
+}
+
+bool Frustum::Intersects(const glm::vec3 &center, const float radius) const
+{
+	for (const auto &plane : _Planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ClusterCuller::Cull(const std::vector<ClusterCullJob> &jobs, const glm::mat4 &viewProjection, const glm::vec3 &eye, uint32_t nbThreads)
+{
+	size_t nbMeshlets = 0;
+	for (const auto &job : jobs) {
+		nbMeshlets += job._Object->_Mesh->_Lods[job._Object->GetLod()]._NbMeshlets;
+	}
+
+	if (nbThreads == 0) {
+		nbThreads = nbMeshlets < PARALLEL_THRESHOLD ? 1 : std::max(1u, std::thread::hardware_concurrency());
+	}
+	nbThreads = static_cast<uint32_t>(std::min<size_t>(nbThreads, jobs.size()));
+
+	if (nbThreads <= 1) {
+		CullJobs(jobs.data(), jobs.size(), viewProjection, eye);
+		return;
+	}
+
+	// Shares of about the same amount of meshlets rather than objects, their sizes vary a lot
+	const size_t share = (nbMeshlets + nbThreads - 1) / nbThreads;
+
+	std::vector<std::pair<size_t, size_t>> ranges;
+	size_t start = 0, count = 0;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		count += jobs[i]._Object->_Mesh->_Lods[jobs[i]._Object->GetLod()]._NbMeshlets;
+		if (count >= share || i + 1 == jobs.size()) {
+			ranges.push_back({ start, i + 1 - start });
+			start = i + 1;
+			count = 0;
+		}
+	}
+
+	// The calling thread takes the first share
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < ranges.size(); ++i) {
+		workers.emplace_back(&ClusterCuller::CullJobs, jobs.data() + ranges[i].first, ranges[i].second, std::cref(viewProjection), std::cref(eye));
+	}
+
+	CullJobs(jobs.data() + ranges[0].first, ranges[0].second, viewProjection, eye);
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void ClusterCuller::CullJobs(const ClusterCullJob *jobs, const size_t nbJobs, const glm::mat4 &viewProjection, const glm::vec3 &eye)
+{
+	for (size_t i = 0; i < nbJobs; ++i) {
+		CullObject(jobs[i], viewProjection, eye);
+	}
+}
+
+void ClusterCuller::CullObject(const ClusterCullJob &job, const glm::mat4 &viewProjection, const glm::vec3 &eye)
+{
+	const Object &object = *job._Object;
+	const Mesh &mesh = *object._Mesh;
+	const MeshLod &lod = mesh._Lods[object.GetLod()];
+
+	ClusterDraws &draws = *job._Draws;
+	draws._Culled = true;
+	draws._Count = 0;
+	draws._NbTriangles = 0;
+
+	const glm::mat4 &model = object.GetModelMatrix();
+	const Frustum frustum(viewProjection * model);
+	if (!frustum.Intersects(mesh._Center, mesh._Radius)) {
+		return;
+	}
+
+	// Both tests run in object space. The cones only stand for faces the pipeline would cull anyway, and only keep their
+	// angles under a uniform scale. A mirroring transform turns the faces inside out, the cones then point the wrong way.
+	const glm::mat3 linear(model);
+	const float scaleX = glm::length(linear[0]), scaleY = glm::length(linear[1]), scaleZ = glm::length(linear[2]);
+	const float maxScale = std::max(scaleX, std::max(scaleY, scaleZ));
+	const float minScale = std::min(scaleX, std::min(scaleY, scaleZ));
+	const bool cones = job._BackFaceCulling && maxScale - minScale <= maxScale * UNIFORM_SCALE_TOLERANCE && glm::determinant(linear) > 0.0f;
+	const glm::vec3 localEye = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+
+	// Built aside, the commands go to write-combined memory that is slow to read back
+	vk::DrawIndexedIndirectCommand command(0, 1, 0, 0, 0);
+
+	for (uint32_t i = lod._FirstMeshlet; i < lod._FirstMeshlet + lod._NbMeshlets; ++i) {
+		const Meshlet &meshlet = mesh._Meshlets[i];
+
+		if (!frustum.Intersects(meshlet._Center, meshlet._Radius)) {
+			continue;
+		}
+
+		if (cones) {
+			const glm::vec3 toCenter = meshlet._Center - localEye;
+			if (glm::dot(toCenter, meshlet._ConeAxis) >= meshlet._ConeCutoff * glm::length(toCenter) + meshlet._Radius) {
+				continue;
+			}
+		}
+
+		// Meshlets of a level follow each other in the index buffer, visible neighbours share a command
+		if (command.indexCount > 0 && command.firstIndex + command.indexCount == meshlet._FirstIndex) {
+			command.indexCount += meshlet._NbIndices;
+		}
+		else {
+			if (command.indexCount > 0) {
+				job._Commands[draws._Count++] = command;
+			}
+			command.firstIndex = meshlet._FirstIndex;
+			command.indexCount = meshlet._NbIndices;
+		}
+
+		draws._NbTriangles += meshlet._NbIndices / 3;
+	}
+
+	if (command.indexCount > 0) {
+		job._Commands[draws._Count++] = command;
+	}
+}
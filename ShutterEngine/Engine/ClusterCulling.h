@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include "Object.h"
+
+// Planes of a clip space matrix, in the space it transforms from: with view projection * model,
+// the tests run in object space without transforming any bound
+struct Frustum {
+	explicit Frustum(const glm::mat4 &matrix);
+
+	bool Intersects(const glm::vec3 &center, const float radius) const;
+
+	// Normalized, inside where dot(plane, vec4(p, 1)) >= 0
+	std::array<glm::vec4, 6> _Planes;
+};
+
+// Draw commands of the visible meshlets of an object, in the draw command buffer of the frame
+struct ClusterDraws {
+	// Drawn through the commands, otherwise the object's level is drawn whole
+	bool _Culled = false;
+
+	uint32_t _Offset = 0;
+	uint32_t _Count = 0;
+
+	// Triangles the commands draw
+	uint32_t _NbTriangles = 0;
+};
+
+// An object to cull, with room for one command per meshlet of its level
+struct ClusterCullJob {
+	const Object *_Object;
+	vk::DrawIndexedIndirectCommand *_Commands;
+	ClusterDraws *_Draws;
+
+	// The pipeline drawing the object culls back faces, so can the meshlet cones
+	bool _BackFaceCulling;
+};
+
+class ClusterCuller {
+public:
+	// Cull the jobs seen from the eye through viewProjection, split over worker threads when there are enough meshlets
+	static void Cull(const std::vector<ClusterCullJob> &jobs, const glm::mat4 &viewProjection, const glm::vec3 &eye, uint32_t nbThreads = 0);
+
+	// Write a command for each run of consecutive visible meshlets of the object's level
+	static void CullObject(const ClusterCullJob &job, const glm::mat4 &viewProjection, const glm::vec3 &eye);
+
+private:
+	static void CullJobs(const ClusterCullJob *jobs, const size_t nbJobs, const glm::mat4 &viewProjection, const glm::vec3 &eye);
+
+	// Under this amount of meshlets, spawning threads costs more than it saves
+	static const size_t PARALLEL_THRESHOLD = 4096;
+
+	// Relative difference between the axis scales still treated as a uniform scale
+	static constexpr float UNIFORM_SCALE_TOLERANCE = 1e-3f;
+};
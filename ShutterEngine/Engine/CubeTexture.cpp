@@ -1,25 +1,37 @@
 #include "CubeTexture.h"
 #include "Renderer/Helpers.h"
 #include <algorithm>
+#include <stdexcept>
+#include <vector>
 
-void CubeTexture::Load(const std::array<std::string, 6> &filename, bool generateMips)
+void CubeTexture::Load(const std::array<std::string, 6> &filename, UploadContext &upload, bool generateMips)
 {
-	_Filenames = filename;
+	std::array<DecodedImage, 6> faces;
 
-	int width;
-	int height;
-	int channels;
+	ImageDecoder decoder(std::vector<std::string>(filename.begin(), filename.end()));
+	DecodedImage face;
+	while (decoder.Next(face)) {
+		faces.at(face.Index) = std::move(face);
+	}
 
-	for (uint8_t i = 0; i < 6; ++i) {
-		stbi_uc* image = stbi_load(_Filenames.at(i).c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	Create(filename, faces, upload, generateMips);
+}
 
-		_Dimensions = vk::Extent3D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
-		_Buffers.at(i) = Buffer(_Device, vk::BufferUsageFlagBits::eTransferSrc, width * height * 4);
-		_Buffers.at(i).Copy(image, width * height * 4);
+void CubeTexture::Create(const std::array<std::string, 6> &filename, const std::array<DecodedImage, 6> &faces, UploadContext &upload, bool generateMips)
+{
+	_Filenames = filename;
 
-		stbi_image_free(image);
+	for (uint8_t i = 0; i < 6; ++i) {
+		if (!faces.at(i).Pixels) {
+			throw std::runtime_error("Could not read the cube face " + _Filenames.at(i));
+		}
+		if (faces.at(i).Width != faces.front().Width || faces.at(i).Height != faces.front().Height) {
+			throw std::runtime_error("The cube faces differ in size: " + _Filenames.at(i));
+		}
 	}
 
+	_Dimensions = vk::Extent3D{ faces.front().Width, faces.front().Height, 1 };
+
 	_Image = Image(
 		_Device,
 		_Dimensions,
@@ -29,37 +41,16 @@ void CubeTexture::Load(const std::array<std::string, 6> &filename, bool generate
 		generateMips
 	);
 
-	CreateSampler();
-}
-
-void CubeTexture::TransferBufferToImage(const vk::CommandPool &cmdPool)
-{
-	for (uint8_t i = 0; i < 6; ++i) {
-		std::array<vk::BufferImageCopy, 1> regions = {};
-		regions[0].bufferOffset = 0;
-		regions[0].bufferRowLength = 0;
-		regions[0].bufferImageHeight = 0;
-		regions[0].imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-		regions[0].imageSubresource.mipLevel = 0;
-		regions[0].imageSubresource.baseArrayLayer = i;
-		regions[0].imageSubresource.layerCount = 1;
-		regions[0].imageOffset = { 0,0,0 };
-		regions[0].imageExtent = _Dimensions;
-
-		_Image.TransitionLayout(cmdPool, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+	_Image.SetAsset(_Filenames.front().substr(0, _Filenames.front().find_last_of('/')));
 
-		vk::CommandBuffer cmdBuffer = BeginSingleUseCommandBuffer(*_Device, cmdPool);
+	// All the faces go in the same batch, with a single transition on each side
+	_Image.TransitionLayout(upload.GetCommandBuffer(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
 
-		cmdBuffer.copyBufferToImage(
-			_Buffers.at(i).GetBuffer(),
-			_Image.GetImage(),
-			vk::ImageLayout::eTransferDstOptimal,
-			regions
-		);
+	for (uint8_t i = 0; i < 6; ++i) {
+		upload.CopyToImage(faces.at(i).Pixels.get(), faces.at(i).GetSize(), _Image, _Dimensions, i);
+	}
 
-		EndSingleUseCommandBuffer(cmdBuffer, *_Device, cmdPool);
+	upload.Release(_Image, vk::ImageLayout::eShaderReadOnlyOptimal);
 
-		_Image.TransitionLayout(cmdPool, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
-		_Buffers.at(i).Clean();
-	}
+	CreateSampler();
 }
@@ -6,18 +6,19 @@
 #include "Renderer/Image.h"
 #include "Renderer/Buffer.h"
 #include "Renderer/DeviceHandler.h"
-#include "stb_image.h"
+#include "ImageDecoder.h"
 
 class CubeTexture: public Texture {
 public:
 	CubeTexture() {}
 	explicit CubeTexture(Device *device) : Texture(device) {};
 
-	void Load(const std::array<std::string, 6> &filename, bool generateMips = false);
+	// The faces are decoded in parallel
+	void Load(const std::array<std::string, 6> &filename, UploadContext &upload, bool generateMips = false);
 
-	void TransferBufferToImage(const vk::CommandPool &cmdPool) override;
+	// Same with faces decoded beforehand, all of the same size
+	void Create(const std::array<std::string, 6> &filename, const std::array<DecodedImage, 6> &faces, UploadContext &upload, bool generateMips = false);
 
 private:
 	std::array<std::string, 6> _Filenames;
-	std::array<Buffer, 6> _Buffers;
 };
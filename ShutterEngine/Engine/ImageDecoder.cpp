@@ -0,0 +1,93 @@
+#include "ImageDecoder.h"
+#include <algorithm>
+
+const size_t ImageDecoder::DEFAULT_MAX_PENDING;
+
+ImageDecoder::ImageDecoder(const std::vector<std::string> &filenames, size_t maxPending) :
+	_Filenames(filenames),
+	_Pool(WorkerPool::GetShared())
+{
+	_MaxPending = std::max<size_t>(maxPending, 1);
+	Schedule();
+}
+
+ImageDecoder::~ImageDecoder()
+{
+	// The decodes already handed to the pool still write to this object
+	std::unique_lock<std::mutex> lock(_Mutex);
+	_Stopping = true;
+	_Decoded.wait(lock, [this]() { return _NbDecoding == 0; });
+}
+
+bool ImageDecoder::Next(DecodedImage &image)
+{
+	{
+		std::unique_lock<std::mutex> lock(_Mutex);
+		if (_NbReturned == _Filenames.size()) {
+			return false;
+		}
+
+		_Decoded.wait(lock, [this]() { return !_Pending.empty(); });
+		Take(image);
+	}
+
+	Schedule();
+	return true;
+}
+
+bool ImageDecoder::TryNext(DecodedImage &image)
+{
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		if (_Pending.empty()) {
+			return false;
+		}
+
+		Take(image);
+	}
+
+	Schedule();
+	return true;
+}
+
+void ImageDecoder::Take(DecodedImage &image)
+{
+	image = std::move(_Pending.front());
+	_Pending.pop_front();
+	++_NbReturned;
+}
+
+void ImageDecoder::Schedule()
+{
+	// Submitted unlocked, a pool without workers runs the decode right away
+	std::vector<size_t> files;
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		while (!_Stopping && _NextFile < _Filenames.size() && _Pending.size() + _NbDecoding < _MaxPending) {
+			files.push_back(_NextFile++);
+			++_NbDecoding;
+		}
+	}
+
+	for (const size_t index : files) {
+		_Pool.Submit([this, index]() { Decode(index); });
+	}
+}
+
+void ImageDecoder::Decode(const size_t index)
+{
+	DecodedImage image;
+	image.Index = index;
+
+	int width, height, channels;
+	image.Pixels.reset(stbi_load(_Filenames[index].c_str(), &width, &height, &channels, STBI_rgb_alpha));
+	if (image.Pixels) {
+		image.Width = static_cast<uint32_t>(width);
+		image.Height = static_cast<uint32_t>(height);
+	}
+
+	std::lock_guard<std::mutex> lock(_Mutex);
+	--_NbDecoding;
+	_Pending.push_back(std::move(image));
+	_Decoded.notify_all();
+}
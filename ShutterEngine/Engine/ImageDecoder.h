@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "stb_image.h"
+#include "WorkerPool.h"
+
+// RGBA8 pixels of an image file, released with the object
+struct DecodedImage {
+	// Position of the file in the list given to the decoder
+	size_t Index = 0;
+
+	// Null if the file could not be decoded
+	std::unique_ptr<stbi_uc, void(*)(void*)> Pixels{ nullptr, stbi_image_free };
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+
+	size_t GetSize() const {
+		return size_t(Width) * Height * 4;
+	}
+};
+
+// Decode image files on the shared worker pool, handed back one at a time in the order they complete.
+// At most maxPending images are decoded or being decoded but not taken yet, so the pixels only live
+// between their decode and their upload and the decodes leave room on the pool for other work.
+class ImageDecoder {
+public:
+	explicit ImageDecoder(const std::vector<std::string> &filenames, size_t maxPending = DEFAULT_MAX_PENDING);
+	~ImageDecoder();
+
+	ImageDecoder(const ImageDecoder &decoder) = delete;
+	ImageDecoder &operator=(const ImageDecoder &decoder) = delete;
+
+	// Wait for the next decoded image, false once every file has been returned
+	bool Next(DecodedImage &image);
+
+	// Take a decoded image if one is ready, without waiting
+	bool TryNext(DecodedImage &image);
+
+	static const size_t DEFAULT_MAX_PENDING = 4;
+
+private:
+	// Hand the next files to the pool, as far as the pending limit allows
+	void Schedule();
+	void Decode(const size_t index);
+
+	// Called with the mutex held
+	void Take(DecodedImage &image);
+
+private:
+	std::vector<std::string> _Filenames;
+	WorkerPool &_Pool;
+
+	std::mutex _Mutex;
+	std::condition_variable _Decoded;
+
+	std::deque<DecodedImage> _Pending;
+	size_t _MaxPending = 0;
+	size_t _NbDecoding = 0;
+	size_t _NextFile = 0;
+	size_t _NbReturned = 0;
+	bool _Stopping = false;
+};
@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string &filename)
+{
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	_File = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		return;
+	}
+
+	_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_Mapping) {
+		return;
+	}
+
+	_Data = static_cast<const char*>(MapViewOfFile(_Mapping, FILE_MAP_READ, 0, 0, 0));
+	_Size = _Data ? static_cast<size_t>(size.QuadPart) : 0;
+}
+
+MappedFile::~MappedFile()
+{
+	if (_Data) {
+		UnmapViewOfFile(_Data);
+	}
+	if (_Mapping) {
+		CloseHandle(_Mapping);
+	}
+	if (_File) {
+		CloseHandle(_File);
+	}
+}
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile(const std::string &filename)
+{
+	_File = open(filename.c_str(), O_RDONLY);
+	if (_File < 0) {
+		return;
+	}
+
+	struct stat status;
+	if (fstat(_File, &status) != 0 || status.st_size == 0) {
+		return;
+	}
+
+	void *data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, _File, 0);
+	if (data == MAP_FAILED) {
+		return;
+	}
+
+	// The whole file is read front to back
+	madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+	_Data = static_cast<const char*>(data);
+	_Size = static_cast<size_t>(status.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+	if (_Data) {
+		munmap(const_cast<char*>(_Data), _Size);
+	}
+	if (_File >= 0) {
+		close(_File);
+	}
+}
+#endif
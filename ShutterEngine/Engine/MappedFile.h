@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read-only view of a whole file mapped in memory, unmapped on destruction
+class MappedFile {
+public:
+	MappedFile() {}
+	explicit MappedFile(const std::string &filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	// False if the file is missing or empty
+	bool IsOpen() const {
+		return _Data != nullptr;
+	}
+
+	const char *GetData() const {
+		return _Data;
+	}
+
+	size_t GetSize() const {
+		return _Size;
+	}
+
+private:
+	const char *_Data = nullptr;
+	size_t _Size = 0;
+
+#ifdef _WIN32
+	void *_File = nullptr;
+	void *_Mapping = nullptr;
+#else
+	int _File = -1;
+#endif
+};
@@ -1,127 +1,82 @@
 #include "Mesh.h"
 #include "Renderer/Helpers.h"
-#include <fstream>
 
 Mesh::Mesh(Device * device) : 
 	_Device(device)
 {
 }
 
-std::unordered_map<std::string, Mesh> Mesh::Load(Device *device, const std::string &filename, const std::string &root, const vk::CommandPool &cmdPool)
+void Mesh::Load(MeshData &&data, UploadContext &upload)
 {
-	//std::ofstream file(filename + ".txt");
-
-	std::unordered_map<std::string, Mesh> meshes;
-
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-
-	std::string err;
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename.c_str(), (root + "models/").c_str());
-
-	for (size_t i = 0; i < shapes.size(); ++i) {
-		Mesh tempMesh(device);
-		tempMesh.Load(shapes.at(i), attrib, cmdPool);
-
-
-
-		//file << "  - name: " << shapes[i].name << "\n";
-		//file << "    model: " << shapes[i].name << "\n";
-		//file << "    material: basic\n";
+	_Name = std::move(data._Name);
+	_Vertices = std::move(data._Vertices);
+	_Indices = std::move(data._Indices);
+	_NbVertices = static_cast<uint32_t>(_Vertices.size());
+	_NbIndices = static_cast<uint32_t>(_Indices.size());
+	_SubMeshes = std::move(data._SubMeshes);
+	_Lods = std::move(data._Lods);
+	_Meshlets = std::move(data._Meshlets);
+	if (_Lods.empty()) {
+		_Lods.push_back({ 0, static_cast<uint32_t>(_Indices.size()), 0.0f });
+	}
 
-		//if (shapes.at(i).mesh.material_ids.front() < materials.size()) {
-		//	if (materials.at(shapes.at(i).mesh.material_ids.front()).ambient_texname != "") {
-		//		file << "    textures:\n";
-		//		file << "      - slot: 1\n";
-		//		std::string path = materials.at(shapes.at(i).mesh.material_ids.front()).ambient_texname;
-		//		file << "        texture: " << path << "\n";
-		//	}
-		//}
-		//file << "    position: [0.0,0.0,0.0]\n";
-		//file << "    rotation: [0.0,0.0,0.0]\n";
-		//file << "    scale: [0.1,0.1,0.1]\n";
+	if (!_Vertices.empty()) {
+		glm::vec3 min = _Vertices.front().position;
+		glm::vec3 max = _Vertices.front().position;
+		for (const auto &vertex : _Vertices) {
+			min = glm::min(min, vertex.position);
+			max = glm::max(max, vertex.position);
+		}
 
-		meshes.insert(std::pair<std::string, Mesh>(shapes[i].name, tempMesh));
+		_Center = (min + max) * 0.5f;
+		_Radius = glm::length(max - min) * 0.5f;
 	}
+	_Quantization = data._Quantization;
 
-	//file.close();
-
-	return meshes;
+	_IndexBuffer = Buffer(_Device, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst, sizeof(uint32_t) * _Indices.size(), vk::SharingMode::eExclusive, vk::MemoryPropertyFlagBits::eDeviceLocal);
+	_IndexBuffer.SetAsset(_Name);
+	upload.CopyToBuffer(_Indices.data(), sizeof(uint32_t) * _Indices.size(), _IndexBuffer);
+	upload.Release(_IndexBuffer);
 }
 
-void Mesh::Load(const tinyobj::shape_t &shape, const tinyobj::attrib_t attrib, const vk::CommandPool &cmdPool)
+void Mesh::Upload(const E_VERTEX_LAYOUT layout, const bool positionOnly, UploadContext &upload)
 {
-	for (const auto& index : shape.mesh.indices) {
-		Vertex vertex = {};
+	const size_t nbStreams = positionOnly ? 1 : VERTEX_STREAM_COUNT;
 
-		vertex.position = {
-			attrib.vertices[3 * index.vertex_index + 0],
-			attrib.vertices[3 * index.vertex_index + 1],
-			attrib.vertices[3 * index.vertex_index + 2]
-		};
+	for (size_t i = 0; i < nbStreams; ++i) {
+		const E_VERTEX_STREAM stream = static_cast<E_VERTEX_STREAM>(i);
 
-		if (attrib.normals.size() > 0) {
-			vertex.normal = {
-				attrib.normals[3 * index.normal_index + 0],
-				attrib.normals[3 * index.normal_index + 1],
-				attrib.normals[3 * index.normal_index + 2]
-			};
+		Buffer &buffer = _VertexStreams[layout][stream];
+		if (buffer.GetBuffer()) {
+			continue;
 		}
 
-		if (attrib.texcoords.size() > 0) {
-			vertex.texCoord = {
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
+		if (!HasCpuData()) {
+			throw std::runtime_error("The vertices of " + _Name + " were released, the mesh has to be retained to upload another layout.");
 		}
 
-		_Vertices.push_back(vertex);
-		_Indices.push_back(_Indices.size());
-	}
-
-	GenerateTangents();
-
-	Buffer stagingBuffer = Buffer(_Device, vk::BufferUsageFlagBits::eVertexBuffer, sizeof(Vertex) * _Vertices.size());
-	stagingBuffer.Copy(_Vertices.data(), sizeof(Vertex) * _Vertices.size());
-
-	_VertexBuffer = Buffer(_Device, vk::BufferUsageFlagBits::eVertexBuffer, sizeof(Vertex) * _Vertices.size(), vk::SharingMode::eExclusive, vk::MemoryPropertyFlagBits::eDeviceLocal);
-	stagingBuffer.Transfer(_VertexBuffer, cmdPool);
+		std::vector<char> data = EncodeVertexStream(_Vertices, layout, stream, _Quantization);
 
-	stagingBuffer.Clean();
+		buffer = Buffer(_Device, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, data.size(), vk::SharingMode::eExclusive, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		buffer.SetAsset(_Name);
+		upload.CopyToBuffer(data.data(), data.size(), buffer);
+		upload.Release(buffer);
+	}
 }
 
-void Mesh::Clean()
+void Mesh::ReleaseCpuData()
 {
-	//_VertexBuffer.Clean();
+	// Swapped out, clear alone keeps the capacity
+	std::vector<Vertex>().swap(_Vertices);
+	std::vector<uint32_t>().swap(_Indices);
 }
 
-void Mesh::GenerateTangents()
+void Mesh::Clean()
 {
-	for (int i = 0; i < _Vertices.size(); i += 3) {
-		glm::vec3 & v0 = _Vertices[i + 0].position;
-		glm::vec3 & v1 = _Vertices[i + 1].position;
-		glm::vec3 & v2 = _Vertices[i + 2].position;
-
-		// Shortcuts for UVs
-		glm::vec2 & uv0 = _Vertices[i + 0].texCoord;
-		glm::vec2 & uv1 = _Vertices[i + 1].texCoord;
-		glm::vec2 & uv2 = _Vertices[i + 2].texCoord;
-
-		// Edges of the triangle : position delta
-		glm::vec3 deltaPos1 = v1 - v0;
-		glm::vec3 deltaPos2 = v2 - v0;
-
-		// UV delta
-		glm::vec2 deltaUV1 = uv1 - uv0;
-		glm::vec2 deltaUV2 = uv2 - uv0;
-
-		float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-		_Vertices[i + 0].tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
-		_Vertices[i + 0].bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
-		_Vertices[i + 1].tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
-		_Vertices[i + 1].bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
-		_Vertices[i + 2].tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
-		_Vertices[i + 2].bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
+	for (auto &streams : _VertexStreams) {
+		for (auto &buffer : streams) {
+			buffer.Clean();
+		}
 	}
+	_IndexBuffer.Clean();
 }
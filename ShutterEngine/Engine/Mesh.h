@@ -3,52 +3,82 @@
 #include <glm/glm.hpp>
 #include <array>
 #include <vector>
-#include <unordered_map>
-#include "tiny_obj_loader.h"
 #include "Renderer/DeviceHandler.h"
 #include "Renderer/Buffer.h"
+#include "Renderer/UploadContext.h"
+#include "VertexLayout.h"
+#include "MeshData.h"
 
-struct Vertex {
-	glm::vec3 position;
-	glm::vec3 normal;
-	glm::vec2 texCoord;
-	glm::vec3 tangent;
-	glm::vec3 bitangent;
+class Mesh {
+public:
+	Mesh(){}
+	Mesh(Device *device);
+	void Load(MeshData &&data, UploadContext &upload);
+
+	// Create the vertex streams of this layout not yet uploaded, the attributes only if asked for.
+	// Throw if the CPU copy of the vertices was released.
+	void Upload(const E_VERTEX_LAYOUT layout, const bool positionOnly, UploadContext &upload);
+
+	// Free the CPU copy of the vertices and indices, the counts and bounds stay
+	void ReleaseCpuData();
 
-	static vk::VertexInputBindingDescription GetBindingDescription() {
-		return vk::VertexInputBindingDescription(0, sizeof(Vertex), vk::VertexInputRate::eVertex);
+	bool HasCpuData() const {
+		return _Vertices.size() == _NbVertices && _Indices.size() == _NbIndices;
 	}
 
-	static std::array<vk::VertexInputAttributeDescription, 5> GetAttributeDescriptions() {
-		std::array<vk::VertexInputAttributeDescription, 5> attributeDescriptions;
+	void Clean();
 
-		attributeDescriptions[0] = vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, position));
-		attributeDescriptions[1] = vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, normal));
-		attributeDescriptions[2] = vk::VertexInputAttributeDescription(2, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, texCoord));
-		attributeDescriptions[3] = vk::VertexInputAttributeDescription(3, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, tangent));
-		attributeDescriptions[4] = vk::VertexInputAttributeDescription(4, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, bitangent));
+	const Buffer &GetVertexStream(const E_VERTEX_LAYOUT layout, const E_VERTEX_STREAM stream) const {
+		return _VertexStreams[layout][stream];
+	}
 
-		return attributeDescriptions;
+	const std::string &GetName() const {
+		return _Name;
 	}
-};
 
-class Mesh {
-public:
-	Mesh(){}
-	Mesh(Device *device);
-	static std::unordered_map<std::string, Mesh> Load(Device  *device, const std::string &filename, const std::string &root, const vk::CommandPool &cmdPool);
-	void Load(const tinyobj::shape_t &shape, const tinyobj::attrib_t attrib, const vk::CommandPool &cmdPool);
+	const VertexQuantization &GetQuantization() const {
+		return _Quantization;
+	}
 
-	void Clean();
+	uint32_t GetHandle() const {
+		return _Handle;
+	}
+
+	uint32_t GetVertexCount() const {
+		return _NbVertices;
+	}
+
+	uint32_t GetIndexCount() const {
+		return _NbIndices;
+	}
 
 public:
+	// Only until the upload, unless the registry retains the mesh
 	std::vector<Vertex> _Vertices;
 	std::vector<uint32_t> _Indices;
+	std::vector<SubMesh> _SubMeshes;
+	std::vector<MeshLod> _Lods;
+	std::vector<Meshlet> _Meshlets;
+
+	// Bounding sphere in object space, for the LOD selection
+	glm::vec3 _Center = glm::vec3(0.0f);
+	float _Radius = 0.0f;
+
+	Buffer _IndexBuffer;
 
-	Buffer _VertexBuffer;
+	// Keep the CPU copy after the upload, for the meshes read back or uploaded in new layouts later
+	bool _Retained = false;
 
 private:
-	Device *_Device;
+	friend class MeshRegistry;
+
+	Device *_Device = nullptr;
+	std::string _Name;
+	uint32_t _Handle = ~0u;
+
+	uint32_t _NbVertices = 0;
+	uint32_t _NbIndices = 0;
 
-	void GenerateTangents();
+	std::array<std::array<Buffer, VERTEX_STREAM_COUNT>, VERTEX_LAYOUT_COUNT> _VertexStreams;
+	VertexQuantization _Quantization = {};
 };
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	const char MAGIC[4] = { 'S', 'H', 'M', 'C' };
+
+	struct Header {
+		char Magic[4];
+		uint32_t Version;
+		uint64_t SourceHash;
+		uint32_t VertexSize;
+		uint32_t NbMeshes;
+	};
+
+	// Followed by the name padded to 4 bytes, the vertices, the indices of every level, the levels then the meshlets
+	struct Entry {
+		uint32_t NameLength;
+		uint32_t NbVertices;
+		uint32_t NbIndices;
+		uint32_t NbLods;
+		uint32_t NbMeshlets;
+		uint32_t Padding;
+		VertexQuantization Quantization;
+	};
+
+	size_t PaddedLength(const size_t length)
+	{
+		return (length + 3) & ~size_t(3);
+	}
+
+	// Walk through the mapped file without ever reading past its end
+	class Reader {
+	public:
+		Reader(const char *data, const size_t size) :
+			_Data(data),
+			_Size(size)
+		{
+		}
+
+		const char *Take(const size_t size) {
+			if (size > _Size - _Offset) {
+				return nullptr;
+			}
+
+			const char *data = _Data + _Offset;
+			_Offset += size;
+			return data;
+		}
+
+		template <typename T>
+		bool Read(T &value) {
+			const char *data = Take(sizeof(T));
+			if (!data) {
+				return false;
+			}
+
+			std::memcpy(&value, data, sizeof(T));
+			return true;
+		}
+
+	private:
+		const char *_Data;
+		size_t _Size;
+		size_t _Offset = 0;
+	};
+}
+
+std::vector<MeshData> MeshCache::Load(const std::string &filename)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const uint64_t hash = HashFile(filename);
+	const std::string path = GetCachePath(filename);
+
+	std::vector<MeshData> meshes;
+	if (hash != 0 && Read(path, hash, meshes)) {
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << filename << ": " << meshes.size() << " meshes read from the cache in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+		return meshes;
+	}
+
+	meshes = MeshData::LoadObj(filename);
+
+	if (hash != 0 && !Write(path, hash, meshes)) {
+		std::cerr << "Could not write the mesh cache: " << path << std::endl;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	std::cout << filename << ": " << meshes.size() << " meshes parsed in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+	return meshes;
+}
+
+bool MeshCache::Read(const std::string &path, const uint64_t sourceHash, std::vector<MeshData> &meshes)
+{
+	MappedFile file(path);
+	if (!file.IsOpen()) {
+		return false;
+	}
+
+	Reader reader(file.GetData(), file.GetSize());
+
+	Header header;
+	if (!reader.Read(header)
+		|| std::memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header.Version != VERSION
+		|| header.SourceHash != sourceHash
+		|| header.VertexSize != sizeof(Vertex)
+		|| header.NbMeshes > file.GetSize() / sizeof(Entry)) {
+		return false;
+	}
+
+	std::vector<MeshData> result(header.NbMeshes);
+	for (auto &mesh : result) {
+		Entry entry;
+		if (!reader.Read(entry)) {
+			return false;
+		}
+
+		const char *name = reader.Take(PaddedLength(entry.NameLength));
+		const char *vertices = reader.Take(size_t(entry.NbVertices) * sizeof(Vertex));
+		const char *indices = reader.Take(size_t(entry.NbIndices) * sizeof(uint32_t));
+		const char *lods = reader.Take(size_t(entry.NbLods) * sizeof(MeshLod));
+		const char *meshlets = reader.Take(size_t(entry.NbMeshlets) * sizeof(Meshlet));
+		if (!name || !vertices || !indices || !lods || !meshlets) {
+			return false;
+		}
+
+		mesh._Name.assign(name, entry.NameLength);
+		mesh._Quantization = entry.Quantization;
+
+		mesh._Vertices.resize(entry.NbVertices);
+		std::memcpy(mesh._Vertices.data(), vertices, size_t(entry.NbVertices) * sizeof(Vertex));
+
+		mesh._Indices.resize(entry.NbIndices);
+		std::memcpy(mesh._Indices.data(), indices, size_t(entry.NbIndices) * sizeof(uint32_t));
+
+		mesh._Lods.resize(entry.NbLods);
+		std::memcpy(mesh._Lods.data(), lods, size_t(entry.NbLods) * sizeof(MeshLod));
+		for (const auto &lod : mesh._Lods) {
+			if (lod._FirstIndex > entry.NbIndices || lod._NbIndices > entry.NbIndices - lod._FirstIndex
+				|| lod._FirstMeshlet > entry.NbMeshlets || lod._NbMeshlets > entry.NbMeshlets - lod._FirstMeshlet) {
+				return false;
+			}
+		}
+
+		mesh._Meshlets.resize(entry.NbMeshlets);
+		std::memcpy(mesh._Meshlets.data(), meshlets, size_t(entry.NbMeshlets) * sizeof(Meshlet));
+		for (const auto &meshlet : mesh._Meshlets) {
+			if (meshlet._FirstIndex > entry.NbIndices || meshlet._NbIndices > entry.NbIndices - meshlet._FirstIndex) {
+				return false;
+			}
+		}
+	}
+
+	meshes.swap(result);
+	return true;
+}
+
+bool MeshCache::Write(const std::string &path, const uint64_t sourceHash, const std::vector<MeshData> &meshes)
+{
+	// Written aside then renamed, so an interrupted write never leaves a valid looking cache
+	const std::string temporary = path + ".tmp";
+
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+
+		Header header;
+		std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+		header.Version = VERSION;
+		header.SourceHash = sourceHash;
+		header.VertexSize = sizeof(Vertex);
+		header.NbMeshes = static_cast<uint32_t>(meshes.size());
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (const auto &mesh : meshes) {
+			Entry entry = {};
+			entry.NameLength = static_cast<uint32_t>(mesh._Name.size());
+			entry.NbVertices = static_cast<uint32_t>(mesh._Vertices.size());
+			entry.NbIndices = static_cast<uint32_t>(mesh._Indices.size());
+			entry.NbLods = static_cast<uint32_t>(mesh._Lods.size());
+			entry.NbMeshlets = static_cast<uint32_t>(mesh._Meshlets.size());
+			entry.Quantization = mesh._Quantization;
+			file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+			std::string name = mesh._Name;
+			name.resize(PaddedLength(name.size()), '\0');
+			file.write(name.data(), name.size());
+
+			file.write(reinterpret_cast<const char*>(mesh._Vertices.data()), mesh._Vertices.size() * sizeof(Vertex));
+			file.write(reinterpret_cast<const char*>(mesh._Indices.data()), mesh._Indices.size() * sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(mesh._Lods.data()), mesh._Lods.size() * sizeof(MeshLod));
+			file.write(reinterpret_cast<const char*>(mesh._Meshlets.data()), mesh._Meshlets.size() * sizeof(Meshlet));
+		}
+
+		if (!file) {
+			return false;
+		}
+	}
+
+	std::remove(path.c_str());
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+uint64_t MeshCache::HashFile(const std::string &filename)
+{
+	MappedFile file(filename);
+	if (!file.IsOpen()) {
+		return 0;
+	}
+
+	uint64_t hash = 14695981039346656037ull;
+	const unsigned char *data = reinterpret_cast<const unsigned char*>(file.GetData());
+	for (size_t i = 0; i < file.GetSize(); ++i) {
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
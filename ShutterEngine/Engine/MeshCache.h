@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MeshData.h"
+
+// Binary copy of the processed meshes of an OBJ file, stored next to it and keyed by
+// a hash of its content, so later starts skip the parsing and processing
+class MeshCache {
+public:
+	// Read the meshes from the cache when it matches the file, otherwise parse it and write the cache
+	static std::vector<MeshData> Load(const std::string &filename);
+
+	static bool Read(const std::string &path, const uint64_t sourceHash, std::vector<MeshData> &meshes);
+	static bool Write(const std::string &path, const uint64_t sourceHash, const std::vector<MeshData> &meshes);
+
+	// FNV-1a of the file content, 0 if it cannot be read
+	static uint64_t HashFile(const std::string &filename);
+
+	static std::string GetCachePath(const std::string &filename) {
+		return filename + ".meshcache";
+	}
+
+	// Increase whenever the format or the mesh processing changes
+	static const uint32_t VERSION = 4;
+};
@@ -0,0 +1,267 @@
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "WorkerPool.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+std::vector<MeshData> MeshData::LoadObj(const std::string &filename, uint32_t nbThreads, std::ostream &log)
+{
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+
+	if (!ObjParser::Load(filename, attrib, shapes, nbThreads)) {
+		log << "Could not read " << filename << std::endl;
+		return {};
+	}
+
+	std::vector<MeshData> meshes(shapes.size());
+	std::vector<std::ostringstream> logs(shapes.size());
+
+	// Shapes are handed out one at a time, their sizes vary too much to split them evenly
+	if (nbThreads == 1) {
+		for (size_t i = 0; i < shapes.size(); ++i) {
+			meshes[i].Build(shapes[i], attrib, logs[i]);
+		}
+	}
+	else {
+		WorkerPool::GetShared().ParallelFor(shapes.size(), [&](size_t i) {
+			meshes[i].Build(shapes[i], attrib, logs[i]);
+		});
+	}
+
+	for (const auto &shapeLog : logs) {
+		log << shapeLog.str();
+	}
+
+	return meshes;
+}
+
+void MeshData::Build(const tinyobj::shape_t &shape, const tinyobj::attrib_t &attrib, std::ostream &log)
+{
+	_Name = shape.name;
+
+	for (const auto& index : shape.mesh.indices) {
+		Vertex vertex = {};
+
+		vertex.position = {
+			attrib.vertices[3 * index.vertex_index + 0],
+			attrib.vertices[3 * index.vertex_index + 1],
+			attrib.vertices[3 * index.vertex_index + 2]
+		};
+
+		if (attrib.normals.size() > 0) {
+			vertex.normal = {
+				attrib.normals[3 * index.normal_index + 0],
+				attrib.normals[3 * index.normal_index + 1],
+				attrib.normals[3 * index.normal_index + 2]
+			};
+		}
+
+		if (attrib.texcoords.size() > 0) {
+			vertex.texCoord = {
+				attrib.texcoords[2 * index.texcoord_index + 0],
+				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+			};
+		}
+
+		_Vertices.push_back(vertex);
+		_Indices.push_back(_Indices.size());
+	}
+
+	// Tangents are computed per triangle, so they are part of what makes two vertices identical
+	GenerateTangents();
+	Deduplicate(log);
+	Optimize(log);
+	GenerateLods(log);
+	BuildMeshlets();
+
+	log << _Name << ": " << _Meshlets.size() << " meshlets" << std::endl;
+
+	_Quantization = ComputeVertexQuantization(_Vertices);
+}
+
+void MeshData::GenerateTangents()
+{
+	for (int i = 0; i < _Vertices.size(); i += 3) {
+		glm::vec3 & v0 = _Vertices[i + 0].position;
+		glm::vec3 & v1 = _Vertices[i + 1].position;
+		glm::vec3 & v2 = _Vertices[i + 2].position;
+
+		// Shortcuts for UVs
+		glm::vec2 & uv0 = _Vertices[i + 0].texCoord;
+		glm::vec2 & uv1 = _Vertices[i + 1].texCoord;
+		glm::vec2 & uv2 = _Vertices[i + 2].texCoord;
+
+		// Edges of the triangle : position delta
+		glm::vec3 deltaPos1 = v1 - v0;
+		glm::vec3 deltaPos2 = v2 - v0;
+
+		// UV delta
+		glm::vec2 deltaUV1 = uv1 - uv0;
+		glm::vec2 deltaUV2 = uv2 - uv0;
+
+		float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
+		_Vertices[i + 0].tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
+		_Vertices[i + 0].bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
+		_Vertices[i + 1].tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
+		_Vertices[i + 1].bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
+		_Vertices[i + 2].tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
+		_Vertices[i + 2].bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
+	}
+}
+
+namespace {
+	// Levels are halved each time, and stop when that no longer pays
+	const float LOD_REDUCTION = 0.5f;
+	const float LOD_MIN_REDUCTION = 0.9f;
+	const size_t LOD_MIN_TRIANGLES = 64;
+
+	// Largest error of a level relative to the size of the mesh, beyond that it is not worth drawing
+	const float LOD_MAX_ERROR = 0.05f;
+
+	// Hash of the attributes telling vertices apart, the bitangent follows the tangent
+	struct VertexHash {
+		size_t operator()(const Vertex &vertex) const {
+			const float values[11] = {
+				vertex.position.x, vertex.position.y, vertex.position.z,
+				vertex.normal.x, vertex.normal.y, vertex.normal.z,
+				vertex.texCoord.x, vertex.texCoord.y,
+				vertex.tangent.x, vertex.tangent.y, vertex.tangent.z
+			};
+
+			// FNV-1a over the bits, matching the bitwise comparison
+			uint64_t hash = 14695981039346656037ull;
+			for (const float value : values) {
+				uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				hash = (hash ^ bits) * 1099511628211ull;
+			}
+
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct VertexEqual {
+		bool operator()(const Vertex &a, const Vertex &b) const {
+			return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+}
+
+void MeshData::Deduplicate(std::ostream &log)
+{
+	std::vector<Vertex> vertices;
+	vertices.reserve(_Vertices.size());
+
+	std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique;
+	unique.reserve(_Vertices.size());
+
+	for (size_t i = 0; i < _Vertices.size(); ++i) {
+		auto result = unique.emplace(_Vertices[i], static_cast<uint32_t>(vertices.size()));
+		if (result.second) {
+			vertices.push_back(_Vertices[i]);
+		}
+		_Indices[i] = result.first->second;
+	}
+
+	const size_t before = _Vertices.size() * sizeof(Vertex);
+	const size_t after = vertices.size() * sizeof(Vertex) + _Indices.size() * sizeof(uint32_t);
+
+	log << _Name << ": " << _Vertices.size() << " -> " << vertices.size() << " vertices ("
+		<< (vertices.empty() ? 0.0f : float(_Vertices.size()) / float(vertices.size())) << "x), "
+		<< (static_cast<long long>(before) - static_cast<long long>(after)) / 1024 << " KB saved" << std::endl;
+
+	_Vertices.swap(vertices);
+}
+
+void MeshData::Optimize(std::ostream &log)
+{
+	const MeshOptimizer::Statistics before = MeshOptimizer::AnalyzeVertexCache(_Indices.data(), _Indices.size(), _Vertices.size());
+
+	_Vertices.resize(MeshOptimizer::Optimize(_Vertices.data(), _Vertices.size(), sizeof(Vertex), _Indices.data(), _Indices.size()));
+
+	const MeshOptimizer::Statistics after = MeshOptimizer::AnalyzeVertexCache(_Indices.data(), _Indices.size(), _Vertices.size());
+
+	log << _Name << ": ACMR " << before.ACMR << " -> " << after.ACMR << ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
+}
+
+void MeshData::GenerateLods(std::ostream &log)
+{
+	_Lods.assign(1, { 0, static_cast<uint32_t>(_Indices.size()), 0.0f });
+	if (_Vertices.empty()) {
+		return;
+	}
+
+	glm::vec3 min = _Vertices.front().position;
+	glm::vec3 max = _Vertices.front().position;
+	for (const auto &vertex : _Vertices) {
+		min = glm::min(min, vertex.position);
+		max = glm::max(max, vertex.position);
+	}
+	const float maxError = glm::length(max - min) * LOD_MAX_ERROR;
+
+	log << _Name << ": LOD 0 " << _Indices.size() / 3 << " triangles";
+
+	std::vector<uint32_t> previous(_Indices);
+	while (_Lods.size() < MAX_LODS) {
+		const size_t target = size_t(previous.size() / 3 * LOD_REDUCTION) * 3;
+		if (target < LOD_MIN_TRIANGLES * 3) {
+			break;
+		}
+
+		const float budget = maxError - _Lods.back()._Error;
+		if (!(budget > 0.0f)) {
+			break;
+		}
+
+		std::vector<uint32_t> indices(previous.size());
+		float error = 0.0f;
+		indices.resize(MeshOptimizer::Simplify(indices.data(), previous.data(), previous.size(), _Vertices.data(), _Vertices.size(), sizeof(Vertex), target, budget, &error));
+
+		if (indices.size() > previous.size() * LOD_MIN_REDUCTION) {
+			break;
+		}
+
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), _Vertices.size());
+
+		// Each level is simplified from the previous one, so the errors add up
+		_Lods.push_back({ static_cast<uint32_t>(_Indices.size()), static_cast<uint32_t>(indices.size()), _Lods.back()._Error + error });
+		_Indices.insert(_Indices.end(), indices.begin(), indices.end());
+
+		log << ", LOD " << _Lods.size() - 1 << " " << indices.size() / 3 << " (error " << _Lods.back()._Error << ")";
+		previous.swap(indices);
+	}
+
+	log << std::endl;
+}
+
+void MeshData::BuildMeshlets()
+{
+	_Meshlets.clear();
+
+	for (auto &lod : _Lods) {
+		const std::vector<MeshOptimizer::Cluster> clusters = MeshOptimizer::BuildClusters(
+			_Indices.data() + lod._FirstIndex, lod._NbIndices, _Vertices.data(), _Vertices.size(), sizeof(Vertex),
+			MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES
+		);
+
+		lod._FirstMeshlet = static_cast<uint32_t>(_Meshlets.size());
+		lod._NbMeshlets = static_cast<uint32_t>(clusters.size());
+
+		for (const auto &cluster : clusters) {
+			Meshlet meshlet;
+			meshlet._FirstIndex = lod._FirstIndex + cluster.FirstIndex;
+			meshlet._NbIndices = cluster.NbIndices;
+			meshlet._Center = glm::vec3(cluster.Center[0], cluster.Center[1], cluster.Center[2]);
+			meshlet._Radius = cluster.Radius;
+			meshlet._ConeAxis = glm::vec3(cluster.ConeAxis[0], cluster.ConeAxis[1], cluster.ConeAxis[2]);
+			meshlet._ConeCutoff = cluster.ConeCutoff;
+			_Meshlets.push_back(meshlet);
+		}
+	}
+}
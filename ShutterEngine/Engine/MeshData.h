@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <iostream>
+#include "tiny_obj_loader.h"
+#include "VertexLayout.h"
+
+// Range of a merged mesh coming from one source object, kept for picking and culling
+struct SubMesh {
+	std::string _Name;
+	uint32_t _FirstIndex = 0;
+	uint32_t _NbIndices = 0;
+
+	// World space bounds
+	glm::vec3 _Min = glm::vec3(0.0f);
+	glm::vec3 _Max = glm::vec3(0.0f);
+};
+
+// Level of detail, a range of the index buffer over the vertices shared by every level
+struct MeshLod {
+	uint32_t _FirstIndex;
+	uint32_t _NbIndices;
+
+	// Largest distance between this level and the full detail surface, in object space
+	float _Error;
+
+	// Meshlets splitting the range, none when the level is always drawn whole
+	uint32_t _FirstMeshlet;
+	uint32_t _NbMeshlets;
+};
+
+// Cluster of a level's triangles, drawn or culled as a whole. Its indices are a contiguous range.
+struct Meshlet {
+	uint32_t _FirstIndex;
+	uint32_t _NbIndices;
+
+	// Bounding sphere, in object space
+	glm::vec3 _Center;
+	float _Radius;
+
+	// Normal cone, see MeshOptimizer::Cluster
+	glm::vec3 _ConeAxis;
+	float _ConeCutoff;
+};
+
+// Processed geometry of a mesh, built without a device so the tools can produce it too
+class MeshData {
+public:
+	MeshData() {}
+
+	// Every shape of an OBJ file, parsed and processed in parallel on the shared worker pool, nbThreads = 1 keeps to the calling thread.
+	// What the processing reports goes to log once every shape is done.
+	static std::vector<MeshData> LoadObj(const std::string &filename, uint32_t nbThreads = 0, std::ostream &log = std::cout);
+
+	// Expand the shape, then deduplicate and optimize its vertices, reporting to log
+	void Build(const tinyobj::shape_t &shape, const tinyobj::attrib_t &attrib, std::ostream &log);
+
+	// Split every level in meshlets, once the indices are final
+	void BuildMeshlets();
+
+public:
+	std::string _Name;
+	std::vector<Vertex> _Vertices;
+	std::vector<uint32_t> _Indices;
+	VertexQuantization _Quantization = {};
+
+	// Only set on merged meshes
+	std::vector<SubMesh> _SubMeshes;
+
+	// The full detail level comes first, then coarser and coarser ones
+	std::vector<MeshLod> _Lods;
+
+	static const size_t MAX_LODS = 5;
+
+	// Meshlets of every level, in the order of the levels
+	std::vector<Meshlet> _Meshlets;
+
+	static const size_t MESHLET_MAX_VERTICES = 64;
+	static const size_t MESHLET_MAX_TRIANGLES = 124;
+
+private:
+	void GenerateTangents();
+
+	// Merge the identical vertices and index them, report what was saved
+	void Deduplicate(std::ostream &log);
+
+	// Reorder triangles and vertices for the caches and overdraw, report the cache statistics
+	void Optimize(std::ostream &log);
+
+	// Simplify each level from the previous one, appending its indices after the full detail ones
+	void GenerateLods(std::ostream &log);
+};
@@ -0,0 +1,767 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/glm.hpp>
+
+namespace {
+	// Cache modelled by the ordering, larger than the hardware one so the scores stay meaningful
+	const uint32_t SCORE_CACHE_SIZE = 32;
+	const uint32_t INVALID = ~0u;
+
+	float VertexScore(const int cachePosition, const uint32_t liveTriangles)
+	{
+		if (liveTriangles == 0) {
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			// The last triangle's vertices get a fixed score so its neighbours are not preferred over strips
+			if (cachePosition < 3) {
+				score = 0.75f;
+			}
+			else {
+				score = std::pow(1.0f - float(cachePosition - 3) / float(SCORE_CACHE_SIZE - 3), 1.5f);
+			}
+		}
+
+		// Favour vertices with few triangles left, to finish them off
+		return score + 2.0f / std::sqrt(float(liveTriangles));
+	}
+
+	const glm::vec3 &Position(const void *vertices, const size_t vertexSize, const uint32_t index)
+	{
+		return *reinterpret_cast<const glm::vec3*>(static_cast<const char*>(vertices) + index * vertexSize);
+	}
+
+	// Past this angle between the axis and a normal, the cone is too wide to cull anything worthwhile
+	const float CONE_MIN_DOT = 0.1f;
+
+	// Borders weigh more than faces, so the silhouette of open meshes holds longer
+	const double BORDER_WEIGHT = 10.0;
+
+	// Sum of weighted squared distances to planes, Q(p) = pAp + 2bp + c. Doubles, since
+	// the constant term grows with the square of the coordinates.
+	struct Quadric {
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		// Plane normal.p + distance = 0, the normal is unit length
+		void AddPlane(const glm::vec3 &normal, const float distance, const double w) {
+			const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+			a00 += w * x * x; a11 += w * y * y; a22 += w * z * z;
+			a01 += w * x * y; a02 += w * x * z; a12 += w * y * z;
+			b0 += w * x * d; b1 += w * y * d; b2 += w * z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric &other) {
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		double Evaluate(const glm::vec3 &p) const {
+			const double x = p.x, y = p.y, z = p.z;
+			const double q = x * (a00 * x + a01 * y + a02 * z)
+				+ y * (a01 * x + a11 * y + a12 * z)
+				+ z * (a02 * x + a12 * y + a22 * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::abs(q);
+		}
+	};
+
+	struct Collapse {
+		uint32_t From;
+		uint32_t To;
+		// Mean squared distance to the planes of both ends
+		double Error;
+	};
+
+	// Triangles around each position, rebuilt after every pass
+	struct Adjacency {
+		std::vector<uint32_t> Offsets;
+		std::vector<uint32_t> Triangles;
+
+		void Build(const std::vector<uint32_t> &positions, const size_t nbPositions) {
+			Offsets.assign(nbPositions + 1, 0);
+			for (const uint32_t p : positions) {
+				++Offsets[p + 1];
+			}
+			for (size_t p = 0; p < nbPositions; ++p) {
+				Offsets[p + 1] += Offsets[p];
+			}
+
+			Triangles.resize(positions.size());
+			std::vector<uint32_t> cursors(Offsets.begin(), Offsets.end() - 1);
+			for (size_t i = 0; i < positions.size(); ++i) {
+				Triangles[cursors[positions[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		// Triangles using both positions, 1 on a border, more than 2 on a non-manifold edge
+		uint32_t CountEdge(const std::vector<uint32_t> &positions, const uint32_t a, const uint32_t b) const {
+			uint32_t count = 0;
+			for (uint32_t i = Offsets[a]; i < Offsets[a + 1]; ++i) {
+				const uint32_t t = Triangles[i];
+				count += positions[t * 3 + 0] == b || positions[t * 3 + 1] == b || positions[t * 3 + 2] == b;
+			}
+			return count;
+		}
+	};
+}
+
+MeshOptimizer::Statistics MeshOptimizer::AnalyzeVertexCache(const uint32_t *indices, const size_t nbIndices, const size_t nbVertices, const uint32_t cacheSize)
+{
+	Statistics statistics;
+	if (nbIndices < 3 || nbVertices == 0) {
+		return statistics;
+	}
+
+	// A vertex is in the cache while less than cacheSize misses happened since it was loaded
+	std::vector<uint32_t> timestamps(nbVertices, 0);
+	uint32_t time = cacheSize + 1;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < nbIndices; ++i) {
+		if (time - timestamps[indices[i]] > cacheSize) {
+			timestamps[indices[i]] = time++;
+			++misses;
+		}
+	}
+
+	statistics.ACMR = float(misses) / float(nbIndices / 3);
+	statistics.ATVR = float(misses) / float(nbVertices);
+
+	return statistics;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t *indices, const size_t nbIndices, const size_t nbVertices)
+{
+	const size_t nbTriangles = nbIndices / 3;
+	if (nbTriangles == 0) {
+		return;
+	}
+
+	// Triangles using each vertex, the live ones are kept at the front of each range
+	std::vector<uint32_t> offsets(nbVertices + 1, 0);
+	for (size_t i = 0; i < nbIndices; ++i) {
+		++offsets[indices[i] + 1];
+	}
+	for (size_t v = 0; v < nbVertices; ++v) {
+		offsets[v + 1] += offsets[v];
+	}
+
+	std::vector<uint32_t> adjacency(nbIndices);
+	std::vector<uint32_t> liveTriangles(nbVertices, 0);
+	for (size_t i = 0; i < nbIndices; ++i) {
+		const uint32_t v = indices[i];
+		adjacency[offsets[v] + liveTriangles[v]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<float> vertexScores(nbVertices);
+	for (size_t v = 0; v < nbVertices; ++v) {
+		vertexScores[v] = VertexScore(-1, liveTriangles[v]);
+	}
+
+	std::vector<float> triangleScores(nbTriangles);
+	uint32_t best = 0;
+	for (size_t t = 0; t < nbTriangles; ++t) {
+		triangleScores[t] = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[best]) {
+			best = static_cast<uint32_t>(t);
+		}
+	}
+
+	std::vector<bool> emitted(nbTriangles, false);
+	std::vector<uint32_t> output;
+	output.reserve(nbIndices);
+
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(SCORE_CACHE_SIZE + 3);
+	newCache.reserve(SCORE_CACHE_SIZE + 3);
+
+	size_t cursor = 0;
+	while (true) {
+		// Nothing left around the cache, restart from the next triangle in the input order
+		if (best == INVALID) {
+			while (cursor < nbTriangles && emitted[cursor]) {
+				++cursor;
+			}
+			if (cursor == nbTriangles) {
+				break;
+			}
+			best = static_cast<uint32_t>(cursor);
+		}
+
+		emitted[best] = true;
+
+		newCache.clear();
+		for (int k = 0; k < 3; ++k) {
+			const uint32_t v = indices[best * 3 + k];
+			output.push_back(v);
+
+			uint32_t *triangles = &adjacency[offsets[v]];
+			for (uint32_t j = 0; j < liveTriangles[v]; ++j) {
+				if (triangles[j] == best) {
+					triangles[j] = triangles[--liveTriangles[v]];
+					break;
+				}
+			}
+
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+				newCache.push_back(v);
+			}
+		}
+
+		for (const uint32_t v : cache) {
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+				newCache.push_back(v);
+			}
+		}
+
+		// Update the scores of everything that moved in the cache, or fell out of it
+		for (size_t i = 0; i < newCache.size(); ++i) {
+			const uint32_t v = newCache[i];
+			const float score = VertexScore(i < SCORE_CACHE_SIZE ? static_cast<int>(i) : -1, liveTriangles[v]);
+			const float delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			for (uint32_t j = 0; j < liveTriangles[v]; ++j) {
+				triangleScores[adjacency[offsets[v] + j]] += delta;
+			}
+		}
+
+		if (newCache.size() > SCORE_CACHE_SIZE) {
+			newCache.resize(SCORE_CACHE_SIZE);
+		}
+		cache.swap(newCache);
+
+		best = INVALID;
+		float bestScore = -1.0f;
+		for (const uint32_t v : cache) {
+			for (uint32_t j = 0; j < liveTriangles[v]; ++j) {
+				const uint32_t t = adjacency[offsets[v] + j];
+				if (triangleScores[t] > bestScore) {
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t *indices, const size_t nbIndices, const void *vertices, const size_t nbVertices, const size_t vertexSize, const float threshold)
+{
+	const size_t nbTriangles = nbIndices / 3;
+	if (nbTriangles < 2) {
+		return;
+	}
+
+	const float meshACMR = AnalyzeVertexCache(indices, nbIndices, nbVertices).ACMR;
+
+	// Cut where the order restarts with a triangle missing all its vertices, or where the
+	// current cluster is already about as cache efficient as the mesh
+	std::vector<uint32_t> clusters;
+	{
+		const uint32_t cacheSize = 16;
+		std::vector<uint32_t> timestamps(nbVertices, 0);
+		uint32_t time = cacheSize + 1;
+
+		size_t clusterMisses = 0;
+		size_t clusterTriangles = 0;
+
+		for (size_t t = 0; t < nbTriangles; ++t) {
+			// Clusters get drawn in any order, so each one starts with a cold cache
+			const bool soft = clusterTriangles > 0 && float(clusterMisses) / float(clusterTriangles) <= threshold * meshACMR;
+			if (soft) {
+				time += cacheSize + 1;
+			}
+
+			uint32_t misses = 0;
+			for (int k = 0; k < 3; ++k) {
+				const uint32_t v = indices[t * 3 + k];
+				if (time - timestamps[v] > cacheSize) {
+					timestamps[v] = time++;
+					++misses;
+				}
+			}
+
+			if (t == 0 || misses == 3 || soft) {
+				clusters.push_back(static_cast<uint32_t>(t));
+				clusterMisses = 0;
+				clusterTriangles = 0;
+			}
+
+			clusterMisses += misses;
+			++clusterTriangles;
+		}
+	}
+	clusters.push_back(static_cast<uint32_t>(nbTriangles));
+
+	const size_t nbClusters = clusters.size() - 1;
+	if (nbClusters < 2) {
+		return;
+	}
+
+	// Area weighted centroid and normal of each cluster
+	std::vector<glm::vec3> centroids(nbClusters, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(nbClusters, glm::vec3(0.0f));
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < nbClusters; ++c) {
+		float clusterArea = 0.0f;
+
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			const glm::vec3 &p0 = Position(vertices, vertexSize, indices[t * 3 + 0]);
+			const glm::vec3 &p1 = Position(vertices, vertexSize, indices[t * 3 + 1]);
+			const glm::vec3 &p2 = Position(vertices, vertexSize, indices[t * 3 + 2]);
+
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(normal);
+
+			centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			normals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += centroids[c];
+		meshArea += clusterArea;
+
+		centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : Position(vertices, vertexSize, indices[clusters[c] * 3]);
+	}
+
+	if (meshArea > 0.0f) {
+		meshCentroid /= meshArea;
+	}
+
+	// Clusters facing away from the centre are more likely to occlude the others
+	std::vector<float> keys(nbClusters);
+	std::vector<uint32_t> order(nbClusters);
+	for (size_t c = 0; c < nbClusters; ++c) {
+		const float length = glm::length(normals[c]);
+		keys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+		order[c] = static_cast<uint32_t>(c);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&keys](const uint32_t a, const uint32_t b) {
+		return keys[a] > keys[b];
+	});
+
+	std::vector<uint32_t> output;
+	output.reserve(nbTriangles * 3);
+	for (const uint32_t c : order) {
+		output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(void *vertices, const size_t nbVertices, const size_t vertexSize, uint32_t *indices, const size_t nbIndices)
+{
+	std::vector<uint32_t> remap(nbVertices, INVALID);
+	std::vector<char> reordered(nbVertices * vertexSize);
+	uint32_t count = 0;
+
+	for (size_t i = 0; i < nbIndices; ++i) {
+		uint32_t &target = remap[indices[i]];
+		if (target == INVALID) {
+			target = count++;
+			std::memcpy(&reordered[target * vertexSize], static_cast<const char*>(vertices) + indices[i] * vertexSize, vertexSize);
+		}
+		indices[i] = target;
+	}
+
+	std::memcpy(vertices, reordered.data(), count * vertexSize);
+
+	return count;
+}
+
+size_t MeshOptimizer::Optimize(void *vertices, const size_t nbVertices, const size_t vertexSize, uint32_t *indices, const size_t nbIndices)
+{
+	OptimizeVertexCache(indices, nbIndices, nbVertices);
+	OptimizeOverdraw(indices, nbIndices, vertices, nbVertices, vertexSize);
+	return OptimizeVertexFetch(vertices, nbVertices, vertexSize, indices, nbIndices);
+}
+
+size_t MeshOptimizer::Simplify(uint32_t *destination, const uint32_t *indices, const size_t nbIndices, const void *vertices, const size_t nbVertices, const size_t vertexSize, const size_t targetIndexCount, const float targetError, float *resultError)
+{
+	// Vertices at the same place collapse together, whatever their other attributes
+	std::vector<uint32_t> positionIds(nbVertices);
+	std::vector<uint32_t> representatives;
+	{
+		std::vector<uint32_t> order(nbVertices);
+		for (uint32_t v = 0; v < nbVertices; ++v) {
+			order[v] = v;
+		}
+
+		auto compare = [vertices, vertexSize](const uint32_t a, const uint32_t b) {
+			return std::memcmp(&Position(vertices, vertexSize, a), &Position(vertices, vertexSize, b), sizeof(glm::vec3)) < 0;
+		};
+		std::sort(order.begin(), order.end(), compare);
+
+		for (size_t i = 0; i < nbVertices; ++i) {
+			if (i == 0 || compare(order[i - 1], order[i])) {
+				representatives.push_back(order[i]);
+			}
+			positionIds[order[i]] = static_cast<uint32_t>(representatives.size() - 1);
+		}
+	}
+
+	const size_t nbPositions = representatives.size();
+	auto position = [&](const uint32_t id) -> const glm::vec3& {
+		return Position(vertices, vertexSize, representatives[id]);
+	};
+
+	// Triangles without area would only get in the way of the edge counts
+	std::vector<uint32_t> corners, positions;
+	corners.reserve(nbIndices);
+	positions.reserve(nbIndices);
+	for (size_t t = 0; t < nbIndices / 3; ++t) {
+		const uint32_t p0 = positionIds[indices[t * 3 + 0]], p1 = positionIds[indices[t * 3 + 1]], p2 = positionIds[indices[t * 3 + 2]];
+		if (p0 == p1 || p1 == p2 || p0 == p2) {
+			continue;
+		}
+
+		corners.insert(corners.end(), indices + t * 3, indices + t * 3 + 3);
+		positions.insert(positions.end(), { p0, p1, p2 });
+	}
+
+	Adjacency adjacency;
+	adjacency.Build(positions, nbPositions);
+
+	// Planes of the faces weighted by area, and of the borders, perpendicular to their face
+	std::vector<Quadric> quadrics(nbPositions);
+	for (size_t t = 0; t < positions.size() / 3; ++t) {
+		const glm::vec3 &p0 = position(positions[t * 3 + 0]);
+		const glm::vec3 &p1 = position(positions[t * 3 + 1]);
+		const glm::vec3 &p2 = position(positions[t * 3 + 2]);
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float length = glm::length(normal);
+		if (!(length > 0.0f)) {
+			continue;
+		}
+		normal /= length;
+
+		for (int k = 0; k < 3; ++k) {
+			quadrics[positions[t * 3 + k]].AddPlane(normal, -glm::dot(normal, p0), length * 0.5);
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			const uint32_t a = positions[t * 3 + k];
+			const uint32_t b = positions[t * 3 + (k + 1) % 3];
+			if (adjacency.CountEdge(positions, a, b) != 1) {
+				continue;
+			}
+
+			const glm::vec3 edge = position(b) - position(a);
+			glm::vec3 border = glm::cross(edge, normal);
+			const float borderLength = glm::length(border);
+			if (!(borderLength > 0.0f)) {
+				continue;
+			}
+			border /= borderLength;
+
+			const double weight = glm::dot(edge, edge) * BORDER_WEIGHT;
+			quadrics[a].AddPlane(border, -glm::dot(border, position(a)), weight);
+			quadrics[b].AddPlane(border, -glm::dot(border, position(a)), weight);
+		}
+	}
+
+	const size_t targetTriangles = targetIndexCount / 3;
+	const double maxError = double(targetError) * double(targetError);
+	double error = 0.0;
+
+	std::vector<Collapse> collapses;
+	std::vector<char> border(nbPositions), locked(nbPositions), passLocked(nbPositions);
+	std::vector<uint32_t> wedges(nbVertices);
+
+	size_t nbTriangles = corners.size() / 3;
+	while (nbTriangles > targetTriangles) {
+		// Borders may only collapse along themselves, non-manifold places and border junctions stay
+		std::fill(border.begin(), border.end(), 0);
+		std::fill(locked.begin(), locked.end(), 0);
+		for (uint32_t a = 0; a < nbPositions; ++a) {
+			uint32_t nbBorders = 0;
+			for (uint32_t i = adjacency.Offsets[a]; i < adjacency.Offsets[a + 1]; ++i) {
+				const uint32_t t = adjacency.Triangles[i];
+				for (int k = 0; k < 3; ++k) {
+					// A border edge has a single triangle, so it is counted once
+					const uint32_t b = positions[t * 3 + k];
+					if (b == a) {
+						continue;
+					}
+
+					const uint32_t count = adjacency.CountEdge(positions, a, b);
+					if (count > 2) {
+						locked[a] = 1;
+					}
+					nbBorders += count == 1;
+				}
+			}
+
+			border[a] = nbBorders > 0;
+			if (nbBorders != 0 && nbBorders != 2) {
+				locked[a] = 1;
+			}
+		}
+
+		collapses.clear();
+		for (size_t t = 0; t < nbTriangles; ++t) {
+			for (int k = 0; k < 3; ++k) {
+				const uint32_t ends[2] = { positions[t * 3 + k], positions[t * 3 + (k + 1) % 3] };
+
+				for (int direction = 0; direction < 2; ++direction) {
+					const uint32_t from = ends[direction];
+					const uint32_t to = ends[1 - direction];
+					if (locked[from] || (border[from] && adjacency.CountEdge(positions, from, to) != 1)) {
+						continue;
+					}
+
+					const double weight = quadrics[from].weight + quadrics[to].weight;
+					const double cost = (quadrics[from].Evaluate(position(to)) + quadrics[to].Evaluate(position(to))) / std::max(weight, 1e-30);
+					collapses.push_back({ from, to, cost });
+				}
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+			return a.Error < b.Error;
+		});
+
+		std::fill(passLocked.begin(), passLocked.end(), 0);
+		for (uint32_t v = 0; v < nbVertices; ++v) {
+			wedges[v] = v;
+		}
+
+		size_t removed = 0;
+		for (const auto &collapse : collapses) {
+			if (collapse.Error > maxError || nbTriangles - removed <= targetTriangles) {
+				break;
+			}
+
+			const uint32_t from = collapse.From;
+			const uint32_t to = collapse.To;
+			if (passLocked[from] || passLocked[to]) {
+				continue;
+			}
+
+			// Refuse to fold a remaining triangle over
+			bool flips = false;
+			for (uint32_t i = adjacency.Offsets[from]; i < adjacency.Offsets[from + 1] && !flips; ++i) {
+				const uint32_t t = adjacency.Triangles[i];
+				const uint32_t *p = &positions[t * 3];
+				if (p[0] == to || p[1] == to || p[2] == to) {
+					continue;
+				}
+
+				glm::vec3 before[3], after[3];
+				for (int k = 0; k < 3; ++k) {
+					before[k] = position(p[k]);
+					after[k] = p[k] == from ? position(to) : before[k];
+				}
+
+				const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				flips = !(glm::dot(normalBefore, normalAfter) > 0.25f * glm::length(normalBefore) * glm::length(normalAfter));
+			}
+			if (flips) {
+				continue;
+			}
+
+			// Each vertex of a seam follows the one across the collapsed edge on its side
+			uint32_t fallback = INVALID;
+			for (uint32_t i = adjacency.Offsets[from]; i < adjacency.Offsets[from + 1]; ++i) {
+				const uint32_t t = adjacency.Triangles[i];
+				int kFrom = -1, kTo = -1;
+				for (int k = 0; k < 3; ++k) {
+					kFrom = positions[t * 3 + k] == from ? k : kFrom;
+					kTo = positions[t * 3 + k] == to ? k : kTo;
+				}
+				if (kTo < 0) {
+					continue;
+				}
+
+				++removed;
+				const uint32_t wedge = corners[t * 3 + kFrom];
+				if (wedges[wedge] == wedge) {
+					wedges[wedge] = corners[t * 3 + kTo];
+				}
+				if (fallback == INVALID) {
+					fallback = corners[t * 3 + kTo];
+				}
+			}
+
+			for (uint32_t i = adjacency.Offsets[from]; i < adjacency.Offsets[from + 1]; ++i) {
+				const uint32_t t = adjacency.Triangles[i];
+				for (int k = 0; k < 3; ++k) {
+					const uint32_t wedge = corners[t * 3 + k];
+					if (positions[t * 3 + k] == from && wedges[wedge] == wedge) {
+						wedges[wedge] = fallback;
+					}
+				}
+
+				// Nothing around may move before the next pass, the checks above would be outdated
+				for (int k = 0; k < 3; ++k) {
+					passLocked[positions[t * 3 + k]] = 1;
+				}
+			}
+
+			quadrics[to].Add(quadrics[from]);
+			error = std::max(error, collapse.Error);
+		}
+
+		if (removed == 0) {
+			break;
+		}
+
+		// Apply the collapses and drop the triangles left without area
+		size_t count = 0;
+		for (size_t t = 0; t < nbTriangles; ++t) {
+			uint32_t triangle[3];
+			for (int k = 0; k < 3; ++k) {
+				triangle[k] = wedges[corners[t * 3 + k]];
+			}
+
+			const uint32_t p0 = positionIds[triangle[0]], p1 = positionIds[triangle[1]], p2 = positionIds[triangle[2]];
+			if (p0 == p1 || p1 == p2 || p0 == p2) {
+				continue;
+			}
+
+			for (int k = 0; k < 3; ++k) {
+				corners[count * 3 + k] = triangle[k];
+				positions[count * 3 + k] = positionIds[triangle[k]];
+			}
+			++count;
+		}
+
+		nbTriangles = count;
+		corners.resize(count * 3);
+		positions.resize(count * 3);
+		adjacency.Build(positions, nbPositions);
+	}
+
+	std::copy(corners.begin(), corners.end(), destination);
+
+	if (resultError) {
+		*resultError = static_cast<float>(std::sqrt(error));
+	}
+
+	return corners.size();
+}
+
+std::vector<MeshOptimizer::Cluster> MeshOptimizer::BuildClusters(const uint32_t *indices, const size_t nbIndices, const void *vertices, const size_t nbVertices, const size_t vertexSize, const size_t maxVertices, const size_t maxTriangles)
+{
+	std::vector<Cluster> clusters;
+
+	auto normal = [&](const size_t i) {
+		const glm::vec3 &p0 = Position(vertices, vertexSize, indices[i]);
+		return glm::cross(Position(vertices, vertexSize, indices[i + 1]) - p0, Position(vertices, vertexSize, indices[i + 2]) - p0);
+	};
+
+	auto finish = [&](Cluster &cluster) {
+		const uint32_t *first = indices + cluster.FirstIndex;
+		const uint32_t *last = first + cluster.NbIndices;
+
+		glm::vec3 min = Position(vertices, vertexSize, *first);
+		glm::vec3 max = min;
+		for (const uint32_t *index = first; index < last; ++index) {
+			min = glm::min(min, Position(vertices, vertexSize, *index));
+			max = glm::max(max, Position(vertices, vertexSize, *index));
+		}
+
+		const glm::vec3 center = (min + max) * 0.5f;
+		float radius = 0.0f;
+		for (const uint32_t *index = first; index < last; ++index) {
+			radius = std::max(radius, glm::length(Position(vertices, vertexSize, *index) - center));
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			cluster.Center[k] = center[k];
+		}
+		cluster.Radius = radius;
+
+		// Degenerate triangles are never rasterized, they do not widen the cone
+		glm::vec3 axis(0.0f);
+		for (size_t i = cluster.FirstIndex; i < cluster.FirstIndex + cluster.NbIndices; i += 3) {
+			const glm::vec3 n = normal(i);
+			const float length = glm::length(n);
+			if (length > 0.0f) {
+				axis += n / length;
+			}
+		}
+
+		const float axisLength = glm::length(axis);
+		if (!(axisLength > 0.0f)) {
+			return;
+		}
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (size_t i = cluster.FirstIndex; i < cluster.FirstIndex + cluster.NbIndices; i += 3) {
+			const glm::vec3 n = normal(i);
+			const float length = glm::length(n);
+			if (length > 0.0f) {
+				minDot = std::min(minDot, glm::dot(axis, n) / length);
+			}
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			cluster.ConeAxis[k] = axis[k];
+		}
+		if (minDot > CONE_MIN_DOT) {
+			cluster.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+		}
+	};
+
+	// Cluster each vertex was last counted in
+	std::vector<uint32_t> stamps(nbVertices, INVALID);
+
+	auto countNew = [&](const size_t i, const uint32_t stamp) {
+		const uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		return size_t(stamps[a] != stamp) + size_t(stamps[b] != stamp && b != a) + size_t(stamps[c] != stamp && c != a && c != b);
+	};
+
+	Cluster cluster;
+	size_t nbClusterVertices = 0;
+
+	for (size_t i = 0; i + 2 < nbIndices; i += 3) {
+		uint32_t stamp = static_cast<uint32_t>(clusters.size());
+		size_t nbNew = countNew(i, stamp);
+
+		if (cluster.NbIndices > 0 && (nbClusterVertices + nbNew > maxVertices || cluster.NbIndices / 3 >= maxTriangles)) {
+			finish(cluster);
+			clusters.push_back(cluster);
+
+			cluster = Cluster();
+			cluster.FirstIndex = static_cast<uint32_t>(i);
+			nbClusterVertices = 0;
+
+			stamp = static_cast<uint32_t>(clusters.size());
+			nbNew = countNew(i, stamp);
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			stamps[indices[i + k]] = stamp;
+		}
+		nbClusterVertices += nbNew;
+		cluster.NbIndices += 3;
+	}
+
+	if (cluster.NbIndices > 0) {
+		finish(cluster);
+		clusters.push_back(cluster);
+	}
+
+	return clusters;
+}
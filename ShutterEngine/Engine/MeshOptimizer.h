@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Reorder indexed triangle lists so they cost less to draw, usable at load or bake time.
+// Vertices are opaque blocks of vertexSize bytes, starting with three floats of position.
+class MeshOptimizer {
+public:
+	struct Statistics {
+		// Average cache miss ratio, transformed vertices per triangle
+		float ACMR = 0.0f;
+		// Average transformed to vertex ratio, 1.0 is the best possible
+		float ATVR = 0.0f;
+	};
+
+	// Run of consecutive triangles of an index buffer, with the bounds to cull them as a whole
+	struct Cluster {
+		uint32_t FirstIndex = 0;
+		uint32_t NbIndices = 0;
+
+		// Bounding sphere
+		float Center[3] = { 0.0f, 0.0f, 0.0f };
+		float Radius = 0.0f;
+
+		// Every triangle faces away from an eye where dot(center - eye, axis) >= cutoff * |center - eye| + radius.
+		// A cutoff of 1 never passes, when the normals are spread too wide for the test to be worth it.
+		float ConeAxis[3] = { 0.0f, 0.0f, 0.0f };
+		float ConeCutoff = 1.0f;
+	};
+
+	// Simulate a FIFO post-transform cache of the given size
+	static Statistics AnalyzeVertexCache(const uint32_t *indices, const size_t nbIndices, const size_t nbVertices, const uint32_t cacheSize = 16);
+
+	// Reorder the triangles for the post-transform cache, following Forsyth's linear-speed algorithm
+	static void OptimizeVertexCache(uint32_t *indices, const size_t nbIndices, const size_t nbVertices);
+
+	// Split the cache-friendly order into clusters and draw those facing outwards first.
+	// A cluster is cut when its ACMR is within threshold of the whole mesh's.
+	static void OptimizeOverdraw(uint32_t *indices, const size_t nbIndices, const void *vertices, const size_t nbVertices, const size_t vertexSize, const float threshold = 1.05f);
+
+	// Store the vertices in the order of their first use, drop the unused ones and return how many remain
+	static size_t OptimizeVertexFetch(void *vertices, const size_t nbVertices, const size_t vertexSize, uint32_t *indices, const size_t nbIndices);
+
+	// All the above in order, return the new vertex count
+	static size_t Optimize(void *vertices, const size_t nbVertices, const size_t vertexSize, uint32_t *indices, const size_t nbIndices);
+
+	// Collapse edges by increasing quadric error until targetIndexCount is reached, or until the next
+	// collapse would move the surface further than targetError in the units of the positions. Vertices
+	// are only merged, never moved, so the result indexes the same vertex buffer. Attribute seams are
+	// collapsed with their position, borders only along themselves. Return the new index count and
+	// write the largest error reached to resultError.
+	static size_t Simplify(uint32_t *destination, const uint32_t *indices, const size_t nbIndices, const void *vertices, const size_t nbVertices, const size_t vertexSize, const size_t targetIndexCount, const float targetError, float *resultError = nullptr);
+
+	// Cut the triangles in order into clusters of at most maxVertices unique vertices and maxTriangles
+	// triangles. The order is kept, so a cache optimized buffer gives compact clusters and each one is
+	// a contiguous range of the indices, drawable as it is.
+	static std::vector<Cluster> BuildClusters(const uint32_t *indices, const size_t nbIndices, const void *vertices, const size_t nbVertices, const size_t vertexSize, const size_t maxVertices = 64, const size_t maxTriangles = 124);
+};
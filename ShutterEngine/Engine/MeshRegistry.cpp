@@ -0,0 +1,56 @@
+#include "MeshRegistry.h"
+#include "MeshCache.h"
+
+void MeshRegistry::Init(Device *device)
+{
+	_Device = device;
+}
+
+std::vector<MeshHandle> MeshRegistry::LoadObj(const std::string &filename, UploadContext &upload, const bool retain)
+{
+	std::vector<MeshHandle> handles;
+
+	std::vector<MeshData> data = MeshCache::Load(filename);
+	for (auto &shape : data) {
+		const MeshHandle existing = Find(shape._Name);
+		handles.push_back(existing != INVALID_MESH_HANDLE ? existing : Add(std::move(shape), upload, retain));
+	}
+
+	return handles;
+}
+
+MeshHandle MeshRegistry::Add(MeshData &&data, UploadContext &upload, const bool retain)
+{
+	const MeshHandle handle = static_cast<MeshHandle>(_Meshes.size());
+
+	_Meshes.emplace_back(_Device);
+	Mesh &mesh = _Meshes.back();
+	mesh.Load(std::move(data), upload);
+	mesh._Handle = handle;
+	mesh._Retained = retain;
+
+	_Names.emplace(mesh.GetName(), handle);
+
+	return handle;
+}
+
+MeshHandle MeshRegistry::Find(const std::string &name) const
+{
+	auto it = _Names.find(name);
+	return it != _Names.end() ? it->second : INVALID_MESH_HANDLE;
+}
+
+void MeshRegistry::ReleaseCpuData()
+{
+	for (auto &mesh : _Meshes) {
+		if (!mesh._Retained) {
+			mesh.ReleaseCpuData();
+		}
+	}
+}
+
+void MeshRegistry::Clear()
+{
+	_Meshes.clear();
+	_Names.clear();
+}
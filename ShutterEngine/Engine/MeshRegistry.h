@@ -0,0 +1,56 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Renderer/DeviceHandler.h"
+#include "Renderer/UploadContext.h"
+#include "Mesh.h"
+#include "MeshData.h"
+
+// Index of a mesh in its registry, valid until the registry is cleared
+typedef uint32_t MeshHandle;
+static const MeshHandle INVALID_MESH_HANDLE = ~0u;
+
+// Owns every mesh of a scene, each loaded once whatever the amount of objects placing it.
+// Meshes never move once added, so objects keep a plain pointer to the one they draw.
+class MeshRegistry {
+public:
+	MeshRegistry() {}
+
+	void Init(Device *device);
+
+	// Every shape of an OBJ file, through the mesh cache. A name already registered keeps its first mesh.
+	std::vector<MeshHandle> LoadObj(const std::string &filename, UploadContext &upload, const bool retain = false);
+
+	// Upload the indices now, the vertex streams wait for Mesh::Upload with the layouts in use
+	MeshHandle Add(MeshData &&data, UploadContext &upload, const bool retain = false);
+
+	// INVALID_MESH_HANDLE when no mesh has this name
+	MeshHandle Find(const std::string &name) const;
+
+	Mesh &Get(const MeshHandle handle) {
+		return _Meshes.at(handle);
+	}
+
+	const Mesh &Get(const MeshHandle handle) const {
+		return _Meshes.at(handle);
+	}
+
+	size_t GetCount() const {
+		return _Meshes.size();
+	}
+
+	// Free the CPU vertices and indices of the meshes not retained, once every stream in use is uploaded
+	void ReleaseCpuData();
+
+	// Release the meshes, their buffers are destroyed once the GPU is done with them
+	void Clear();
+
+private:
+	Device *_Device = nullptr;
+
+	// Growing a deque at the end never moves its elements
+	std::deque<Mesh> _Meshes;
+	std::unordered_map<std::string, MeshHandle> _Names;
+};
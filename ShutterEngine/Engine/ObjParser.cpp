@@ -0,0 +1,347 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
+#include <algorithm>
+
+namespace {
+	enum E_RELATIVE_INDEX
+	{
+		RELATIVE_POSITION = 1,
+		RELATIVE_NORMAL = 2,
+		RELATIVE_TEXCOORD = 4
+	};
+
+	bool IsSpace(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	bool IsDigit(const char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	void SkipSpaces(const char *&cursor, const char *end)
+	{
+		while (cursor < end && IsSpace(*cursor)) {
+			++cursor;
+		}
+	}
+
+	// Locale independent, the mapped file is not null terminated so strtof cannot be used either
+	float ParseFloat(const char *&cursor, const char *end)
+	{
+		SkipSpaces(cursor, end);
+
+		bool negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+			negative = *cursor == '-';
+			++cursor;
+		}
+
+		double mantissa = 0.0;
+		while (cursor < end && IsDigit(*cursor)) {
+			mantissa = mantissa * 10.0 + (*cursor++ - '0');
+		}
+
+		int exponent = 0;
+		if (cursor < end && *cursor == '.') {
+			++cursor;
+			while (cursor < end && IsDigit(*cursor)) {
+				mantissa = mantissa * 10.0 + (*cursor++ - '0');
+				--exponent;
+			}
+		}
+
+		if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+			++cursor;
+			bool negativeExponent = false;
+			if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+				negativeExponent = *cursor == '-';
+				++cursor;
+			}
+
+			int value = 0;
+			while (cursor < end && IsDigit(*cursor)) {
+				value = std::min(value * 10 + (*cursor++ - '0'), 1000);
+			}
+			exponent += negativeExponent ? -value : value;
+		}
+
+		// Anything else is not a number, like tinyobj the value is then 0
+		while (cursor < end && !IsSpace(*cursor) && *cursor != '\n') {
+			++cursor;
+		}
+
+		double scale = 1.0;
+		double power = 10.0;
+		for (int e = std::abs(exponent); e > 0; e >>= 1) {
+			if (e & 1) {
+				scale *= power;
+			}
+			power *= power;
+		}
+
+		const double value = exponent < 0 ? mantissa / scale : mantissa * scale;
+		return static_cast<float>(negative ? -value : value);
+	}
+
+	// Same as atoi, stopping at the first character that is not part of the number
+	int ParseInt(const char *&cursor, const char *end)
+	{
+		bool negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+			negative = *cursor == '-';
+			++cursor;
+		}
+
+		int value = 0;
+		while (cursor < end && IsDigit(*cursor)) {
+			value = value * 10 + (*cursor++ - '0');
+		}
+
+		return negative ? -value : value;
+	}
+
+	// OBJ indices start at 1 and count backwards from the last element when negative
+	int FixIndex(const int index, const int count, unsigned char &relative, const unsigned char flag)
+	{
+		if (index > 0) {
+			return index - 1;
+		}
+		if (index == 0) {
+			return 0;
+		}
+
+		relative |= flag;
+		return count + index;
+	}
+
+	// First word after the keyword, empty if there is none
+	std::string ParseName(const char *&cursor, const char *end)
+	{
+		SkipSpaces(cursor, end);
+		const char *start = cursor;
+		while (cursor < end && !IsSpace(*cursor) && *cursor != '\n') {
+			++cursor;
+		}
+
+		return std::string(start, cursor);
+	}
+
+	bool IsKeyword(const char *cursor, const char *end, const char *keyword, const size_t length)
+	{
+		return size_t(end - cursor) > length && std::equal(keyword, keyword + length, cursor) && IsSpace(cursor[length]);
+	}
+}
+
+bool ObjParser::Load(const std::string &filename, tinyobj::attrib_t &attrib, std::vector<tinyobj::shape_t> &shapes, uint32_t nbThreads)
+{
+	MappedFile file(filename);
+	if (!file.IsOpen()) {
+		return false;
+	}
+
+	Parse(file.GetData(), file.GetSize(), attrib, shapes, nbThreads);
+	return true;
+}
+
+void ObjParser::Parse(const char *data, const size_t size, tinyobj::attrib_t &attrib, std::vector<tinyobj::shape_t> &shapes, uint32_t nbThreads)
+{
+	WorkerPool &pool = WorkerPool::GetShared();
+	if (nbThreads == 0) {
+		nbThreads = pool.GetThreadCount() + 1;
+	}
+	nbThreads = static_cast<uint32_t>(std::min<size_t>(nbThreads, size / MIN_CHUNK_SIZE + 1));
+
+	// Chunks end right after a line break, so no line is split
+	std::vector<const char*> bounds(1, data);
+	for (uint32_t i = 1; i < nbThreads; ++i) {
+		const char *cursor = std::max(bounds.back(), data + size * i / nbThreads);
+		cursor = std::find(cursor, data + size, '\n');
+		bounds.push_back(cursor == data + size ? cursor : cursor + 1);
+	}
+	bounds.push_back(data + size);
+
+	const size_t nbChunks = bounds.size() - 1;
+	std::vector<Chunk> chunks(nbChunks);
+
+	pool.ParallelFor(nbChunks, [&](size_t i) {
+		ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+	});
+
+	// Concatenate the attributes in file order
+	size_t nbPositions = 0, nbNormals = 0, nbTexCoords = 0;
+	std::vector<int> positionOffsets(nbChunks), normalOffsets(nbChunks), texCoordOffsets(nbChunks);
+	for (size_t i = 0; i < nbChunks; ++i) {
+		positionOffsets[i] = static_cast<int>(nbPositions / 3);
+		normalOffsets[i] = static_cast<int>(nbNormals / 3);
+		texCoordOffsets[i] = static_cast<int>(nbTexCoords / 2);
+
+		nbPositions += chunks[i].Positions.size();
+		nbNormals += chunks[i].Normals.size();
+		nbTexCoords += chunks[i].TexCoords.size();
+	}
+
+	attrib.vertices.clear();
+	attrib.normals.clear();
+	attrib.texcoords.clear();
+	attrib.vertices.reserve(nbPositions);
+	attrib.normals.reserve(nbNormals);
+	attrib.texcoords.reserve(nbTexCoords);
+
+	for (const auto &chunk : chunks) {
+		attrib.vertices.insert(attrib.vertices.end(), chunk.Positions.begin(), chunk.Positions.end());
+		attrib.normals.insert(attrib.normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+		attrib.texcoords.insert(attrib.texcoords.end(), chunk.TexCoords.begin(), chunk.TexCoords.end());
+	}
+
+	pool.ParallelFor(nbChunks, [&](size_t i) {
+		ResolveChunk(chunks[i], positionOffsets[i], normalOffsets[i], texCoordOffsets[i]);
+	});
+
+	// A shape runs from one 'o' or 'g' to the next and may span several chunks, empty ones are dropped
+	shapes.clear();
+	tinyobj::shape_t shape;
+
+	for (auto &chunk : chunks) {
+		size_t start = 0;
+		for (const auto &next : chunk.Shapes) {
+			shape.mesh.indices.insert(shape.mesh.indices.end(), chunk.Indices.begin() + start, chunk.Indices.begin() + next.Index);
+			start = next.Index;
+
+			if (!shape.mesh.indices.empty()) {
+				shapes.push_back(std::move(shape));
+			}
+			shape = tinyobj::shape_t();
+			shape.name = next.Name;
+		}
+
+		shape.mesh.indices.insert(shape.mesh.indices.end(), chunk.Indices.begin() + start, chunk.Indices.end());
+		chunk = Chunk();
+	}
+
+	if (!shape.mesh.indices.empty()) {
+		shapes.push_back(std::move(shape));
+	}
+}
+
+void ObjParser::ParseChunk(const char *begin, const char *end, Chunk &chunk)
+{
+	// Rough guess from the usual line lengths, avoids most of the reallocations
+	const size_t estimate = (end - begin) / 40;
+	chunk.Positions.reserve(estimate);
+	chunk.Indices.reserve(estimate);
+	chunk.Relative.reserve(estimate);
+
+	std::vector<tinyobj::index_t> face;
+	std::vector<unsigned char> faceRelative;
+
+	const char *cursor = begin;
+	while (cursor < end) {
+		SkipSpaces(cursor, end);
+		const char *line = cursor;
+
+		if (IsKeyword(line, end, "v", 1)) {
+			cursor += 2;
+			for (int i = 0; i < 3; ++i) {
+				chunk.Positions.push_back(ParseFloat(cursor, end));
+			}
+		}
+		else if (IsKeyword(line, end, "vn", 2)) {
+			cursor += 3;
+			for (int i = 0; i < 3; ++i) {
+				chunk.Normals.push_back(ParseFloat(cursor, end));
+			}
+		}
+		else if (IsKeyword(line, end, "vt", 2)) {
+			cursor += 3;
+			for (int i = 0; i < 2; ++i) {
+				chunk.TexCoords.push_back(ParseFloat(cursor, end));
+			}
+		}
+		else if (IsKeyword(line, end, "f", 1)) {
+			cursor += 2;
+
+			const int nbPositions = static_cast<int>(chunk.Positions.size() / 3);
+			const int nbNormals = static_cast<int>(chunk.Normals.size() / 3);
+			const int nbTexCoords = static_cast<int>(chunk.TexCoords.size() / 2);
+
+			face.clear();
+			faceRelative.clear();
+
+			SkipSpaces(cursor, end);
+			while (cursor < end && *cursor != '\n') {
+				tinyobj::index_t index;
+				index.vertex_index = -1;
+				index.normal_index = -1;
+				index.texcoord_index = -1;
+				unsigned char relative = 0;
+
+				// i, i/j, i//k or i/j/k
+				index.vertex_index = FixIndex(ParseInt(cursor, end), nbPositions, relative, RELATIVE_POSITION);
+				if (cursor < end && *cursor == '/') {
+					++cursor;
+					if (cursor < end && *cursor != '/') {
+						index.texcoord_index = FixIndex(ParseInt(cursor, end), nbTexCoords, relative, RELATIVE_TEXCOORD);
+					}
+					if (cursor < end && *cursor == '/') {
+						++cursor;
+						index.normal_index = FixIndex(ParseInt(cursor, end), nbNormals, relative, RELATIVE_NORMAL);
+					}
+				}
+
+				// Skip whatever is left of a malformed triple
+				while (cursor < end && !IsSpace(*cursor) && *cursor != '\n') {
+					++cursor;
+				}
+				SkipSpaces(cursor, end);
+
+				face.push_back(index);
+				faceRelative.push_back(relative);
+			}
+
+			// Polygons become triangle fans
+			for (size_t k = 2; k < face.size(); ++k) {
+				chunk.Indices.push_back(face[0]);
+				chunk.Indices.push_back(face[k - 1]);
+				chunk.Indices.push_back(face[k]);
+
+				chunk.Relative.push_back(faceRelative[0]);
+				chunk.Relative.push_back(faceRelative[k - 1]);
+				chunk.Relative.push_back(faceRelative[k]);
+			}
+		}
+		else if (IsKeyword(line, end, "o", 1) || IsKeyword(line, end, "g", 1)) {
+			cursor += 2;
+			chunk.Shapes.push_back({ chunk.Indices.size(), ParseName(cursor, end) });
+		}
+
+		// Materials, smoothing groups and comments are not used by the engine
+		cursor = std::find(cursor, end, '\n');
+		if (cursor < end) {
+			++cursor;
+		}
+	}
+}
+
+void ObjParser::ResolveChunk(Chunk &chunk, const int positionOffset, const int normalOffset, const int texCoordOffset)
+{
+	for (size_t i = 0; i < chunk.Indices.size(); ++i) {
+		const unsigned char relative = chunk.Relative[i];
+		if (relative == 0) {
+			continue;
+		}
+
+		tinyobj::index_t &index = chunk.Indices[i];
+		if (relative & RELATIVE_POSITION) {
+			index.vertex_index += positionOffset;
+		}
+		if (relative & RELATIVE_NORMAL) {
+			index.normal_index += normalOffset;
+		}
+		if (relative & RELATIVE_TEXCOORD) {
+			index.texcoord_index += texCoordOffset;
+		}
+	}
+}
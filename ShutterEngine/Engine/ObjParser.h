@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "tiny_obj_loader.h"
+
+// Multithreaded replacement for tinyobj::LoadObj on the geometry only.
+// The mapped file is split in line aligned chunks parsed in parallel, then merged in order.
+// Shapes are cut on 'o' and 'g' like tinyobj and faces are triangulated as fans, materials
+// are ignored so only the names and indices of the shapes are filled.
+class ObjParser {
+public:
+	// Return false if the file cannot be read. The chunks run on the shared worker pool, nbThreads = 0 makes one per thread of it.
+	static bool Load(const std::string &filename, tinyobj::attrib_t &attrib, std::vector<tinyobj::shape_t> &shapes, uint32_t nbThreads = 0);
+
+	// Same on a buffer already in memory
+	static void Parse(const char *data, const size_t size, tinyobj::attrib_t &attrib, std::vector<tinyobj::shape_t> &shapes, uint32_t nbThreads = 0);
+
+private:
+	// Start of a shape inside a chunk, at an index of its triangulated indices
+	struct ShapeStart {
+		size_t Index;
+		std::string Name;
+	};
+
+	struct Chunk {
+		std::vector<float> Positions;
+		std::vector<float> Normals;
+		std::vector<float> TexCoords;
+
+		std::vector<tinyobj::index_t> Indices;
+		// Per index, one bit per component given relatively to the end of the chunk's own arrays
+		std::vector<unsigned char> Relative;
+
+		std::vector<ShapeStart> Shapes;
+	};
+
+	static void ParseChunk(const char *begin, const char *end, Chunk &chunk);
+
+	// Turn the relative indices into absolute ones, with the amount of elements in the previous chunks
+	static void ResolveChunk(Chunk &chunk, const int positionOffset, const int normalOffset, const int texCoordOffset);
+
+	// Under this size, the file is parsed by a single thread
+	static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+};
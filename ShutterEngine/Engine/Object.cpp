@@ -1,11 +1,13 @@
 #include "Object.h"
+#include <algorithm>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Renderer/Helpers.h"
 
 Object::Object(Device *device, const Mesh &mesh, Material *material, const uint32_t nbImages) :
 	SceneObject("object"),
 	_Device(device),
-	_Mesh(mesh),
+	_Mesh(&mesh),
 	_Material(material),
 	_NbImages(nbImages)
 {
@@ -13,10 +15,10 @@ Object::Object(Device *device, const Mesh &mesh, Material *material, const uint3
 
 void Object::AddTexture(const uint32_t binding, const Texture &texture)
 {
-	_Textures.emplace(binding, texture);
+	_Textures.emplace(binding, &texture);
 }
 
-void Object::CreateDescriptorSet()
+void Object::CreateDescriptorSet(const vk::Buffer &uniformBuffer)
 {
 	std::vector<vk::DescriptorSetLayout> layouts(_NbImages, _Material->GetDescriptorSetLayout());
 
@@ -39,21 +41,33 @@ void Object::CreateDescriptorSet()
 			vk::DescriptorType::eUniformBufferDynamic,
 			nullptr,
 			&vk::DescriptorBufferInfo(
-				DynamicBuffer.GetBuffer(),
+				uniformBuffer,
 				0,
-				sizeof(uboDynamic)
+				sizeof(glm::mat4)
 			),
 			nullptr
 		));
 
+		_Device->GetDevice().updateDescriptorSets(descriptorWrites, {});
+		i++;
+	}
+
+	UpdateTextureDescriptors();
+}
+
+void Object::UpdateTextureDescriptors()
+{
+	for (const auto &descSet : _DescriptorSets) {
+		std::vector<vk::WriteDescriptorSet> descriptorWrites;
+
 		std::vector<vk::DescriptorImageInfo> textureDescriptors;
 		textureDescriptors.resize(_Textures.size());
 
 		size_t j = 0;
 		for (const auto &texture : _Textures) {
 			textureDescriptors.at(j) = vk::DescriptorImageInfo(
-				texture.second.GetSampler(),
-				texture.second.GetImage().GetImageView(),
+				texture.second->GetSampler(),
+				texture.second->GetImage().GetImageView(),
 				vk::ImageLayout::eShaderReadOnlyOptimal
 			);
 			descriptorWrites.push_back(vk::WriteDescriptorSet(
@@ -70,23 +84,62 @@ void Object::CreateDescriptorSet()
 		}
 
 		_Device->GetDevice().updateDescriptorSets(descriptorWrites, {});
-		i++;
 	}
 }
 
-const glm::mat4 Object::GetModelMatrix() const
+void Object::BindTransform(TransformSystem *transforms)
+{
+	_Transforms = transforms;
+	_TransformId = _Transforms->Add(_Position, TransformSystem::FromEuler(_Rotation), _Scale);
+}
+
+void Object::MarkDirty()
+{
+	_MatrixDirty = true;
+
+	if (_Transforms) {
+		_Transforms->Set(_TransformId, _Position, TransformSystem::FromEuler(_Rotation), _Scale);
+	}
+}
+
+void Object::SelectLod(const glm::vec3 &eye, const float pixelsPerUnit)
 {
-	glm::mat4 model;
+	const std::vector<MeshLod> &lods = _Mesh->_Lods;
+	if (lods.size() < 2) {
+		_Lod = 0;
+		return;
+	}
+
+	const float scale = std::max(std::abs(_Scale.x), std::max(std::abs(_Scale.y), std::abs(_Scale.z)));
+	const glm::vec3 center = glm::vec3(GetModelMatrix() * glm::vec4(_Mesh->_Center, 1.0f));
 
-	model = glm::translate(glm::mat4(1.0f), _Position);
-	model = glm::rotate(model, glm::radians(_Rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-	model = glm::rotate(model, glm::radians(_Rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-	model = glm::rotate(model, glm::radians(_Rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-	model = glm::scale(model, _Scale);
+	// From the closest point of the bounding sphere, so the error is never underestimated
+	const float distance = std::max(glm::length(center - eye) - _Mesh->_Radius * scale, 1e-3f);
+	const float pixels = pixelsPerUnit * scale / distance;
 
-	return model;
+	uint32_t lod = 0;
+	for (uint32_t i = 1; i < lods.size(); ++i) {
+		const float threshold = i > _Lod ? LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS) : LOD_PIXEL_ERROR;
+		if (lods[i]._Error * pixels > threshold) {
+			break;
+		}
+		lod = i;
+	}
+
+	_Lod = lod;
 }
 
-Buffer Object::DynamicBuffer = Buffer();
-uint32_t Object::dynamicAlignement = 0;
-Object::UboDynamic Object::uboDynamic = {};
\ No newline at end of file
+const glm::mat4 &Object::GetModelMatrix() const
+{
+	if (_MatrixDirty) {
+		_ModelMatrix = glm::translate(glm::mat4(1.0f), _Position);
+		_ModelMatrix = glm::rotate(_ModelMatrix, glm::radians(_Rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		_ModelMatrix = glm::rotate(_ModelMatrix, glm::radians(_Rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		_ModelMatrix = glm::rotate(_ModelMatrix, glm::radians(_Rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		_ModelMatrix = glm::scale(_ModelMatrix, _Scale);
+
+		_MatrixDirty = false;
+	}
+
+	return _ModelMatrix;
+}
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Texture.h"
 #include "Renderer/Material.h"
 #include "Engine/SceneObject.h"
+#include "Engine/TransformSystem.h"
 
 class Object : public SceneObject {
 public:
@@ -16,42 +17,72 @@ public:
 
 	void AddTexture(const uint32_t binding, const Texture &texture);
 
-	void CreateDescriptorSet();
+	void CreateDescriptorSet(const vk::Buffer &uniformBuffer);
+
+	// Point the descriptor sets at the current image of each texture, after one got recreated
+	void UpdateTextureDescriptors();
 
 	Material *GetMaterial() {
 		return _Material;
 	}
+	const std::map<uint32_t, const Texture*> &GetTextures() const {
+		return _Textures;
+	}
 	const vk::DescriptorSet &GetDescriptorSet(const uint32_t id) const {
 		return _DescriptorSets.at(id);
 	}
 
-	const glm::mat4 GetModelMatrix() const;
+	// Cached until the transform is marked dirty
+	const glm::mat4 &GetModelMatrix() const;
+
+	// Register the current transform, the system then holds the copy used for rendering
+	void BindTransform(TransformSystem *transforms);
+
+	// To call after changing _Position, _Rotation or _Scale
+	void MarkDirty();
+
+	// Keep the coarsest level whose error stays under LOD_PIXEL_ERROR on screen, pixelsPerUnit being
+	// the size on screen of one unit at a distance of one
+	void SelectLod(const glm::vec3 &eye, const float pixelsPerUnit);
+
+	uint32_t GetLod() const {
+		return _Lod;
+	}
+
+	static constexpr float LOD_PIXEL_ERROR = 1.0f;
+
+	// Share of the error budget a coarser level must fit in before switching, against popping
+	static constexpr float LOD_HYSTERESIS = 0.25f;
 
 private:
 	Material *_Material;
 
 
 public:
-	Mesh _Mesh;
+	// Owned by the scene
+	const Mesh *_Mesh = nullptr;
 	glm::vec3 _Rotation;
 	glm::vec3 _Scale;
-	uint32_t _DynamicIndex;
 
-	static Buffer DynamicBuffer;
-	static uint32_t dynamicAlignement;
+	// Never moves after loading, so it may be merged with the objects sharing its material and textures
+	bool _Static = false;
 
-	static struct UboDynamic {
-		glm::mat4 *model = nullptr;
-	} uboDynamic;
+	uint32_t _TransformId = 0;
 private:
 
 	Device *_Device;
+	TransformSystem *_Transforms = nullptr;
 
 	uint32_t _NbImages;
 
-	// Map containing the relation between a texture and its binding
-	std::map<uint32_t, Texture> _Textures;
+	// Map containing the relation between a texture and its binding, the textures are owned by the scene
+	std::map<uint32_t, const Texture*> _Textures;
 
 
 	std::vector<vk::DescriptorSet> _DescriptorSets;
+
+	uint32_t _Lod = 0;
+
+	mutable glm::mat4 _ModelMatrix;
+	mutable bool _MatrixDirty = true;
 };
\ No newline at end of file
@@ -1,5 +1,12 @@
 #include "Scene.h"
+#include "StaticBatch.h"
+#include "ImageDecoder.h"
 #include "yaml-cpp/yaml.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <set>
 
 namespace YAML {
 	template<>
@@ -25,8 +32,20 @@ namespace YAML {
 	};
 }
 
-void Scene::Load(const std::string &name, Device *device, const vk::CommandPool &cmdPool, const vk::RenderPass &renderPass, const vk::RenderPass &shadowPass, const Texture &shadow) {
-	CreateDynamic(device);
+namespace {
+	// A texture waiting for the images of its faces, one unless it is a cube map
+	struct PendingTexture {
+		std::string _Name;
+		std::array<std::string, 6> _Files;
+		std::array<DecodedImage, 6> _Faces;
+		uint32_t _NbFiles = 0;
+		uint32_t _NbDecoded = 0;
+		bool _Mipmap = false;
+		bool _Cube = false;
+	};
+}
+
+void Scene::Load(const std::string &name, Device *device, UploadContext &upload, const vk::RenderPass &renderPass, const vk::RenderPass &shadowPass, const Texture &shadow) {
 	std::string root = "Data/" + name + "/";
 
 	YAML::Node config = YAML::LoadFile(root + "info.yaml");
@@ -70,11 +89,42 @@ void Scene::Load(const std::string &name, Device *device, const vk::CommandPool
 
 		bool CastShadow = config["materials"][i]["castShadow"].IsDefined();
 
+		// The vertex shader has to be written for the layout
+		E_VERTEX_LAYOUT layout = E_VERTEX_LAYOUT::STANDARD;
+		if (config["materials"][i]["vertexLayout"].IsDefined()) {
+			std::string layoutName = config["materials"][i]["vertexLayout"].as<std::string>();
+			if (layoutName == "compact") {
+				layout = E_VERTEX_LAYOUT::COMPACT;
+			}
+			else if (layoutName != "standard") {
+				throw std::runtime_error("Unknown vertex layout: " + layoutName);
+			}
+		}
+
 		// Find the type
 		std::string pipeline = config["materials"][i]["pipeline"].as<std::string>();
+
+		// Depth-only and sky pipelines read the positions alone unless told otherwise
+		bool positionOnly = pipeline == "shadow" || pipeline == "cubemap";
+		if (config["materials"][i]["vertexStreams"].IsDefined()) {
+			std::string streams = config["materials"][i]["vertexStreams"].as<std::string>();
+			if (streams == "position") {
+				positionOnly = true;
+			}
+			else if (streams == "all") {
+				positionOnly = false;
+			}
+			else {
+				throw std::runtime_error("Unknown vertex streams: " + streams);
+			}
+		}
+
+		// The vertex shader has to read the model matrix from the instance attributes
+		bool instanced = config["materials"][i]["instancing"].IsDefined() && config["materials"][i]["instancing"].as<bool>();
+
 		if (pipeline == "basic") {
 			// Create the material
-			Material *mat = new Material(device, this, 1024, 768, 1024);
+			Material *mat = new Material(device, this, 1024, 768, 1024, layout, positionOnly, instanced);
 			mat->BindShader(vert);
 			mat->BindShader(frag);
 			mat->CreatePipeline(renderPass);
@@ -83,7 +133,7 @@ void Scene::Load(const std::string &name, Device *device, const vk::CommandPool
 		}
 		else if (pipeline == "cubemap") {
 			// Create the material
-			Cubemap *mat = new Cubemap(device, this, 1024, 768, 1024);
+			Cubemap *mat = new Cubemap(device, this, 1024, 768, 1024, layout, positionOnly, instanced);
 			mat->BindShader(vert);
 			mat->BindShader(frag);
 			mat->CreatePipeline(renderPass);
@@ -92,7 +142,7 @@ void Scene::Load(const std::string &name, Device *device, const vk::CommandPool
 		}
 		else if (pipeline == "shadow") {
 			// Create the material
-			Shadow *mat = new Shadow(device, this, 1024, 768, 1024);
+			Shadow *mat = new Shadow(device, this, 1024, 768, 1024, layout, positionOnly, instanced);
 			mat->BindShader(vert);
 			mat->BindShader(frag);
 			mat->CreatePipeline(shadowPass);
@@ -102,43 +152,103 @@ void Scene::Load(const std::string &name, Device *device, const vk::CommandPool
 		_Objects.insert(std::pair<std::string, std::vector<Object>>(name, std::vector<Object>()));
 	}
 
-	// Load the models
-	//_Models.resize(config["models"].size());
-	for (int i = 0; i < config["models"].size(); ++i) {
-		std::string filename = config["models"][i]["filename"].as<std::string>();
-		std::unordered_map<std::string, Mesh> temp = Mesh::Load(device, root + "models/" + filename, root, cmdPool);
-		_Models.insert(temp.begin(), temp.end());
-	}
-
-	// Load the textures
+	// Decode the textures on the shared worker pool while the models load on it too.
+	// The block compressed copy is used as it is when the device can sample it.
+	std::vector<PendingTexture> textures;
+	std::vector<std::string> images;
+	std::vector<std::pair<size_t, uint32_t>> imageFaces;
 	for (int i = 0; i < config["textures"].size(); ++i) {
 		std::string filename = config["textures"][i]["name"].as<std::string>();
 		std::string type = config["textures"][i]["type"].as<std::string>();
 		bool mipmap = config["textures"][i]["mipmap"].as<bool>();
 
+		PendingTexture texture;
+		texture._Name = filename;
+
 		if (type == "normal") {
-			Texture temp(device);
-			temp.Load(root + "textures/" + filename, mipmap);
-			temp.TransferBufferToImage(cmdPool);
+			const YAML::Node compressed = config["textures"][i]["compressed"];
+			if (compressed.IsDefined()) {
+				Texture temp(device);
+				if (temp.LoadCompressed(root + "textures/" + compressed.as<std::string>(), upload)) {
+					_Textures.emplace(filename, std::move(temp));
+					continue;
+				}
+			}
 
-			_Textures.insert(std::pair<std::string, Texture>(filename, temp));
+			texture._Files[0] = root + "textures/" + filename;
+			texture._NbFiles = 1;
+			texture._Mipmap = mipmap;
 		}
 		else if (type == "cube") {
-			CubeTexture temp(device);
-			temp.Load({
+			texture._Files = { {
 				root + "textures/" + filename + "/posx.jpg",
 				root + "textures/" + filename + "/negx.jpg",
 				root + "textures/" + filename + "/posy.jpg",
 				root + "textures/" + filename + "/negy.jpg",
 				root + "textures/" + filename + "/posz.jpg",
 				root + "textures/" + filename + "/negz.jpg"
-			});
-			temp.TransferBufferToImage(cmdPool);
+			} };
+			texture._NbFiles = 6;
+			texture._Cube = true;
+		}
+		else {
+			continue;
+		}
 
-			_Textures.insert(std::pair<std::string, Texture>(filename, temp));
+		for (uint32_t face = 0; face < texture._NbFiles; ++face) {
+			images.push_back(texture._Files[face]);
+			imageFaces.push_back({ textures.size(), face });
 		}
+		textures.push_back(std::move(texture));
 	}
 
+	// Upload the textures as their images come in, the pixels are released once staged
+	auto createTexture = [&](DecodedImage &image) {
+		if (!image.Pixels) {
+			throw std::runtime_error("Could not read the texture " + images[image.Index]);
+		}
+
+		PendingTexture &texture = textures[imageFaces[image.Index].first];
+		texture._Faces[imageFaces[image.Index].second] = std::move(image);
+		if (++texture._NbDecoded < texture._NbFiles) {
+			return;
+		}
+
+		if (texture._Cube) {
+			CubeTexture temp(device);
+			temp.Create(texture._Files, texture._Faces, upload);
+			_Textures.emplace(texture._Name, std::move(temp));
+		}
+		else {
+			Texture temp(device);
+			temp.Create(texture._Files[0], texture._Faces[0], upload, texture._Mipmap);
+			_Textures.emplace(texture._Name, std::move(temp));
+		}
+
+		for (auto &face : texture._Faces) {
+			face.Pixels.reset();
+		}
+	};
+
+	ImageDecoder decoder(images);
+	DecodedImage image;
+
+	// Load the models, their CPU copy is only kept when asked for
+	_Meshes.Init(device);
+	for (int i = 0; i < config["models"].size(); ++i) {
+		std::string filename = config["models"][i]["filename"].as<std::string>();
+		bool retain = config["models"][i]["retain"].IsDefined() && config["models"][i]["retain"].as<bool>();
+		_Meshes.LoadObj(root + "models/" + filename, upload, retain);
+
+		// Stage what was decoded meanwhile, the decoder only goes on once its images are taken
+		while (decoder.TryNext(image)) {
+			createTexture(image);
+		}
+	}
+
+	while (decoder.Next(image)) {
+		createTexture(image);
+	}
 
 	YAML::Node scene = YAML::LoadFile(root + "scene.yaml");
 
@@ -155,16 +265,22 @@ void Scene::Load(const std::string &name, Device *device, const vk::CommandPool
 		glm::vec3 rotation = scene["scene"][i]["rotation"].as<glm::vec3>();
 		glm::vec3 scale = scene["scene"][i]["scale"].as<glm::vec3>();
 
-		_Objects[material].push_back(Object(device, _Models.at(model), materialM, 2));
+		const MeshHandle mesh = _Meshes.Find(model);
+		if (mesh == INVALID_MESH_HANDLE) {
+			throw std::runtime_error("Unknown model " + model + " placed by " + name);
+		}
+
+		_Objects[material].push_back(Object(device, _Meshes.Get(mesh), materialM, 2));
 		_Objects[material].back()._Position = position;
 		_Objects[material].back()._Rotation = rotation;
 		_Objects[material].back()._Scale = scale;
+		_Objects[material].back()._Static = scene["scene"][i]["static"].IsDefined() && scene["scene"][i]["static"].as<bool>();
 
 		for (int j = 0; j < scene["scene"][i]["textures"].size(); ++j) {
 			if (scene["scene"][i]["textures"]) {
 				int slot = scene["scene"][i]["textures"][j]["slot"].as<int>();
 				std::string name = scene["scene"][i]["textures"][j]["texture"].as<std::string>();
-				Texture texture = _Textures.at(name);
+				const Texture &texture = _Textures.at(name);
 				_Objects[material].back().AddTexture(slot, texture);
 			}
 		}
@@ -173,12 +289,168 @@ void Scene::Load(const std::string &name, Device *device, const vk::CommandPool
 			_Objects[material].back().AddTexture(2, shadow);
 		}
 
-		_Objects[material].back()._DynamicIndex = AddToDynamic(_Objects[material].back());
-		_Objects[material].back().CreateDescriptorSet();
 		_Objects[material].back()._Name = name;
 	}
 
-	UploadDynamic();
+	MergeStaticObjects(device, upload);
+	GroupInstances();
+
+	for (auto &objects : _Objects) {
+		const Material *materialM = _Materials.at(objects.first);
+
+		for (auto &object : objects.second) {
+			// Only the layouts actually drawn get a vertex buffer
+			Mesh &mesh = _Meshes.Get(object._Mesh->GetHandle());
+			mesh.Upload(materialM->_VertexLayout, materialM->_PositionOnly, upload);
+			if (materialM->_CastShadow) {
+				const Material *shadowMaterial = _Materials.at("shadow");
+				mesh.Upload(shadowMaterial->_VertexLayout, shadowMaterial->_PositionOnly, upload);
+			}
+
+			// In the order of the groups, so the instances of each get consecutive matrices
+			object.BindTransform(&_Transforms);
+		}
+	}
+
+	// Every transform is known, the frame data can be sized before anything points at it
+	CreateFrameData();
+	for (auto &objects : _Objects) {
+		for (auto &object : objects.second) {
+			object.CreateDescriptorSet(_FrameAllocator.GetBuffer());
+		}
+	}
+
+	// Every stream drawn is staged, only the retained meshes keep their vertices in memory
+	_Meshes.ReleaseCpuData();
+
+	// At worst every meshlet of the largest level is its own command, in each pass
+	size_t nbCommands = 0;
+	for (const auto &objects : _Objects) {
+		for (const auto &object : objects.second) {
+			uint32_t nbMeshlets = 0;
+			for (const auto &lod : object._Mesh->_Lods) {
+				nbMeshlets = std::max(nbMeshlets, lod._NbMeshlets);
+			}
+			nbCommands += nbMeshlets;
+		}
+		_ClusterDraws[objects.first].resize(objects.second.size());
+	}
+	_DrawCommands.Init(device, std::max<size_t>(nbCommands, 1) * 2 * sizeof(vk::DrawIndexedIndirectCommand), _NbFrames, vk::BufferUsageFlagBits::eIndirectBuffer, "Draw commands");
+}
+
+void Scene::MergeStaticObjects(Device *device, UploadContext &upload)
+{
+	size_t nbBefore = 0, nbAfter = 0;
+
+	for (auto &objects : _Objects) {
+		nbBefore += objects.second.size();
+
+		std::vector<Object> batches;
+		std::set<const Object*> merged;
+		for (const auto &group : StaticBatch::Group(objects.second)) {
+			const std::string name = objects.first + " batch " + std::to_string(batches.size());
+
+			const Mesh &mesh = _Meshes.Get(_Meshes.Add(StaticBatch::Merge(group, name), upload));
+
+			// Already in world space
+			Object batch(device, mesh, group.front()->GetMaterial(), 2);
+			batch._Position = glm::vec3(0.0f);
+			batch._Rotation = glm::vec3(0.0f);
+			batch._Scale = glm::vec3(1.0f);
+			batch._Static = true;
+			batch._Name = name;
+			for (const auto &texture : group.front()->GetTextures()) {
+				batch.AddTexture(texture.first, *texture.second);
+			}
+
+			// The sources live on as sub-meshes of the batch
+			merged.insert(group.begin(), group.end());
+			batches.push_back(batch);
+		}
+
+		objects.second.erase(std::remove_if(objects.second.begin(), objects.second.end(), [&merged](const Object &object) {
+			return merged.count(&object) > 0;
+		}), objects.second.end());
+		objects.second.insert(objects.second.end(), batches.begin(), batches.end());
+
+		nbAfter += objects.second.size();
+	}
+
+	if (nbAfter != nbBefore) {
+		std::cout << _Name << ": static batching, " << nbBefore << " -> " << nbAfter << " draws" << std::endl;
+	}
+}
+
+void Scene::GroupInstances()
+{
+	auto shadow = _Materials.find("shadow");
+	const bool instancedShadows = shadow != _Materials.end() && shadow->second->_Instanced;
+
+	size_t nbObjects = 0, nbGroups = 0;
+
+	for (auto &objects : _Objects) {
+		const Material *material = _Materials.at(objects.first);
+
+		// Others keep the order of the scene file, it matters for blending
+		if (material->_Instanced || (material->_CastShadow && instancedShadows)) {
+			std::stable_sort(objects.second.begin(), objects.second.end(), [](const Object &a, const Object &b) {
+				if (a._Mesh != b._Mesh) {
+					return std::less<const Mesh*>()(a._Mesh, b._Mesh);
+				}
+				return a.GetTextures() < b.GetTextures();
+			});
+		}
+
+		std::vector<InstanceGroup> &groups = _InstanceGroups[objects.first];
+		groups.clear();
+
+		for (uint32_t i = 0; i < objects.second.size(); ++i) {
+			const Object &object = objects.second[i];
+
+			if (!groups.empty()) {
+				const Object &first = objects.second[groups.back()._First];
+				if (first._Mesh == object._Mesh && first.GetTextures() == object.GetTextures()) {
+					++groups.back()._Count;
+					continue;
+				}
+			}
+
+			groups.push_back({ i, 1 });
+		}
+
+		nbObjects += objects.second.size();
+		nbGroups += groups.size();
+	}
+
+	std::cout << _Name << ": " << nbObjects << " objects in " << nbGroups << " instance groups" << std::endl;
+}
+
+void Scene::Clean()
+{
+	_Objects.clear();
+	_InstanceGroups.clear();
+	_Textures.clear();
+	_Meshes.Clear();
+	_Transforms.Clear();
+
+	_FrameAllocator.Clean();
+	_DrawCommands.Clean();
+
+	if (_DescriptorPool) {
+		_Device->GetDevice().destroyDescriptorPool(_DescriptorPool);
+		_Device->GetDevice().destroyDescriptorSetLayout(_DescriptorSetLayout);
+		_DescriptorPool = nullptr;
+		_DescriptorSetLayout = nullptr;
+	}
+}
+
+void Scene::UpdateTextureDescriptors()
+{
+	for (auto &objects : _Objects) {
+		for (auto &object : objects.second) {
+			object.UpdateTextureDescriptors();
+		}
+	}
 }
 
 void Scene::Resize(const vk::RenderPass &renderPass, const vk::RenderPass &renderShadow, const vk::Extent2D & dimension)
@@ -197,35 +469,76 @@ void Scene::Resize(const vk::RenderPass &renderPass, const vk::RenderPass &rende
 	_Camera._Height = dimension.height;
 }
 
-void Scene::CreateDynamic(Device *device)
+void Scene::SetSampleCount(const vk::SampleCountFlagBits samples)
 {
-	uint32_t minAlignement = device->GetProperties().limits.minUniformBufferOffsetAlignment;
-	Object::dynamicAlignement = sizeof(glm::mat4);
-
-	if (minAlignement > 0) {
-		Object::dynamicAlignement = (Object::dynamicAlignement + minAlignement - 1) & ~(minAlignement - 1);
+	// The pipelines pick the new value on their next reload
+	for (auto &material : _Materials) {
+		material.second->_SampleCount = samples;
 	}
-
-	uint32_t bufferSize = 1024 * Object::dynamicAlignement;
-	Object::uboDynamic.model = (glm::mat4*)_aligned_malloc(bufferSize, Object::dynamicAlignement);
-
-	Object::DynamicBuffer = Buffer(device, vk::BufferUsageFlagBits::eUniformBuffer, bufferSize);
 }
 
-uint32_t Scene::AddToDynamic(const Object & object)
+void Scene::CreateDynamic(Device *device, const uint32_t nbImages)
 {
-	uint32_t oldIndex = dynamicIndex;
-	glm::mat4* modelPtr = (glm::mat4*)(((uint64_t)Object::uboDynamic.model + (oldIndex * Object::dynamicAlignement)));
-	*modelPtr = object.GetModelMatrix();
+	// The frame data itself waits for the load, its size depends on the number of objects
+	_NbFrames = nbImages;
 
-	dynamicIndex++;
-	return oldIndex;
+	const vk::DeviceSize alignment = std::max<vk::DeviceSize>(device->GetProperties().limits.minUniformBufferOffsetAlignment, 1);
+	_DynamicStride = static_cast<uint32_t>((sizeof(glm::mat4) + alignment - 1) / alignment * alignment);
 }
 
-void Scene::UploadDynamic()
+void Scene::CreateFrameData()
 {
-	uint32_t bufferSize = 1024 * Object::dynamicAlignement;
-	Object::DynamicBuffer.Copy(Object::uboDynamic.model, bufferSize);
+	// The matrices of every object then the scene block, in each slot
+	// Instanced draws read the object matrices as vertex data
+	const vk::DeviceSize frameSize = vk::DeviceSize(_DynamicStride) * _Transforms.GetCount() + sizeof(SceneDataObject::Data) * 3;
+	_FrameAllocator.Init(_Device, frameSize, _NbFrames, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eVertexBuffer, "Frame data");
+
+	// The actual position of the data is given by the dynamic offsets
+	for (size_t i = 0; i < _SceneDescriptorSets.size(); ++i)
+	{
+
+		vk::WriteDescriptorSet cameraDescriptor(
+			_SceneDescriptorSets.at(i),
+			0, 0, 1,
+			vk::DescriptorType::eUniformBufferDynamic,
+			nullptr,
+			&vk::DescriptorBufferInfo(
+				_FrameAllocator.GetBuffer(),
+				0,
+				sizeof(CameraUniformData)
+			),
+			nullptr
+		);
+
+		vk::WriteDescriptorSet shadowCameraDescriptor(
+			_SceneDescriptorSets.at(i),
+			1, 0, 1,
+			vk::DescriptorType::eUniformBufferDynamic,
+			nullptr,
+			&vk::DescriptorBufferInfo(
+				_FrameAllocator.GetBuffer(),
+				alignof(SceneDataObject::Data),
+				sizeof(CameraUniformData)
+			),
+			nullptr
+		);
+
+		vk::DescriptorBufferInfo lightInfo = {
+			_FrameAllocator.GetBuffer(),
+			alignof(SceneDataObject::Data) * 2,
+			sizeof(LightUniformData)
+		};
+
+		vk::WriteDescriptorSet lightDescriptor(
+			_SceneDescriptorSets.at(i),
+			2, 0, 1,
+			vk::DescriptorType::eUniformBufferDynamic,
+			nullptr,
+			&lightInfo
+		);
+
+		_Device->GetDevice().updateDescriptorSets({ cameraDescriptor, shadowCameraDescriptor, lightDescriptor }, nullptr);
+	}
 }
 
 void Scene::ReloadShader(const vk::RenderPass &renderPass, const vk::Extent2D &screenSize)
@@ -277,83 +590,113 @@ void Scene::CreateDescriptorSets(Device *device, const uint32_t nbImages)
 	));
 
 	_SceneDescriptorSets.resize(nbImages);
-	_SceneDataBuffers.resize(nbImages);
-	_SceneDataObjects.resize(nbImages);
 
-	for (size_t i = 0; i < nbImages; ++i)
-	{
-		_SceneDataBuffers.at(i) = Buffer(_Device, vk::BufferUsageFlagBits::eUniformBuffer, sizeof(SceneDataObject::Data) * 3);
+	CreateDynamic(device, nbImages);
+}
 
-		vk::WriteDescriptorSet cameraDescriptor(
-			_SceneDescriptorSets.at(i),
-			0, 0, 1,
-			vk::DescriptorType::eUniformBuffer,
-			nullptr,
-			&vk::DescriptorBufferInfo(
-				_SceneDataBuffers[i].GetBuffer(),
-				0,
-				sizeof(CameraUniformData)
-			),
-			nullptr
-		);
+void Scene::BeginFrame(const uint32_t image)
+{
+	_FrameAllocator.BeginFrame(image);
+	_DrawCommands.BeginFrame(image);
+	_FrameSlot = image;
+
+	// The layout of the slots changed, nothing in them can be reused
+	const size_t nbObjects = _Transforms.GetCount();
+	if (nbObjects != _NbDynamicObjects) {
+		_Transforms.MarkAllDirty();
+		_NbDynamicObjects = nbObjects;
+	}
 
-		vk::WriteDescriptorSet shadowCameraDescriptor(
-			_SceneDescriptorSets.at(i),
-			1, 0, 1,
-			vk::DescriptorType::eUniformBuffer,
-			nullptr,
-			&vk::DescriptorBufferInfo(
-				_SceneDataBuffers[i].GetBuffer(),
-				alignof(SceneDataObject::Data),
-				sizeof(CameraUniformData)
-			),
-			nullptr
-		);
+	if (nbObjects > 0) {
+		_ObjectData = _FrameAllocator.Allocate(_DynamicStride * nbObjects);
+	}
+}
 
-		vk::DescriptorBufferInfo lightInfo = {
-			_SceneDataBuffers.at(i).GetBuffer(),
-			alignof(SceneDataObject::Data) * 2,
-			sizeof(LightUniformData)
-		};
+void Scene::Update()
+{
+	// Prepare the camera
+	FrameAllocation sceneData = _FrameAllocator.Allocate(sizeof(SceneDataObject::Data) * 3);
+	SceneDataObject::Data *data = static_cast<SceneDataObject::Data*>(sceneData.Data);
 
-		vk::WriteDescriptorSet lightDescriptor(
-			_SceneDescriptorSets.at(i),
-			2, 0, 1,
-			vk::DescriptorType::eUniformBuffer,
-			nullptr,
-			&lightInfo
-		);
+	data[0]._CameraData = _Camera.GetUniformData();
+	data[1]._CameraData = _ShadowCamera.GetUniformData();
 
-		_Device->GetDevice().updateDescriptorSets({ cameraDescriptor, shadowCameraDescriptor, lightDescriptor }, nullptr);
+	data[2]._LightData[0] = _Lights[0].GetUniformData();
+	data[2]._LightData[1] = _Lights[1].GetUniformData();
+
+	_FrameAllocator.Flush(sceneData, 0, sizeof(SceneDataObject::Data) * 3);
+	_SceneDataOffsets.fill(sceneData.Offset);
+
+	// Both passes draw the levels picked from the main camera, so shadows match what is seen
+	const float pixelsPerUnit = _Camera._Height / (2.0f * std::tan(glm::radians(_Camera.GetFOV()) * 0.5f));
+	for (auto &objects : _Objects) {
+		for (auto &object : objects.second) {
+			object.SelectLod(_Camera._Position, pixelsPerUnit);
+		}
+	}
+
+	// Only write the matrices this slot does not have yet
+	uint32_t first, last;
+	if (_Transforms.Compose(_FrameSlot, _ObjectData.Data, _DynamicStride, first, last)) {
+		_FrameAllocator.Flush(_ObjectData, first * _DynamicStride, (last - first) * _DynamicStride);
 	}
 }
 
-void Scene::Update(const uint32_t image)
+void Scene::CullClusters(const bool shadowPass)
 {
-	// Prepare the camera
-	_SceneDataObjects.at(image)._Data[0]._CameraData = _Camera.GetUniformData();
-	_SceneDataObjects.at(image)._Data[1]._CameraData = _ShadowCamera.GetUniformData();
+	const Camera &camera = shadowPass ? _ShadowCamera : _Camera;
+	const Material *shadow = _Materials.at("shadow");
 
-	_SceneDataObjects.at(image)._Data[2]._LightData[0] = _Lights[0].GetUniformData();
-	_SceneDataObjects.at(image)._Data[2]._LightData[1] = _Lights[1].GetUniformData();
+	std::vector<ClusterCullJob> jobs;
+	size_t nbCommands = 0;
+
+	for (auto &objects : _Objects) {
+		const Material *material = _Materials.at(objects.first);
+		std::vector<ClusterDraws> &draws = _ClusterDraws[objects.first];
+		draws.assign(objects.second.size(), ClusterDraws());
+
+		// Instances share a single draw, each cannot keep its own meshlets
+		const Material *pipeline = shadowPass ? shadow : material;
+		if ((shadowPass && !material->_CastShadow) || pipeline->_Instanced) {
+			continue;
+		}
 
-	_SceneDataBuffers.at(image).Copy(&_SceneDataObjects.at(image)._Data, sizeof(SceneDataObject::Data) * 3);
+		for (size_t i = 0; i < objects.second.size(); ++i) {
+			const Object &object = objects.second[i];
+			const uint32_t nbMeshlets = object._Mesh->_Lods[object.GetLod()]._NbMeshlets;
+			if (nbMeshlets == 0) {
+				continue;
+			}
 
-	for (auto &mat : _Objects) {
-		for (auto &obj : mat.second) {
-			glm::mat4* modelPtr = (glm::mat4*)(((uint64_t)Object::uboDynamic.model + (obj._DynamicIndex * Object::dynamicAlignement)));
-			*modelPtr = obj.GetModelMatrix();
+			// In commands until the allocation is known
+			draws[i]._Offset = static_cast<uint32_t>(nbCommands);
+			jobs.push_back({ &object, nullptr, &draws[i], pipeline->GetCullMode() == vk::CullModeFlagBits::eBack });
+			nbCommands += nbMeshlets;
 		}
 	}
 
-	UploadDynamic();
+	if (jobs.empty()) {
+		return;
+	}
+
+	// Every object writes its own range, the workers need no synchronisation
+	FrameAllocation allocation = _DrawCommands.Allocate(nbCommands * sizeof(vk::DrawIndexedIndirectCommand));
+	vk::DrawIndexedIndirectCommand *commands = static_cast<vk::DrawIndexedIndirectCommand*>(allocation.Data);
+	for (auto &job : jobs) {
+		job._Commands = commands + job._Draws->_Offset;
+		job._Draws->_Offset = allocation.Offset + job._Draws->_Offset * sizeof(vk::DrawIndexedIndirectCommand);
+	}
+
+	ClusterCuller::Cull(jobs, camera.GetProjection() * camera.GetView(), camera._Position);
+
+	_DrawCommands.Flush(allocation, 0, nbCommands * sizeof(vk::DrawIndexedIndirectCommand));
 }
 
 void Scene::CreateDescriptorSetLayout(const uint32_t nbImages)
 {
-	vk::DescriptorSetLayoutBinding cameraInfo(0, vk::DescriptorType::eUniformBuffer, 1,  vk::ShaderStageFlagBits::eVertex);
-	vk::DescriptorSetLayoutBinding shadowCameraInfo(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex);
-	vk::DescriptorSetLayoutBinding lightInfo(2, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment);
+	vk::DescriptorSetLayoutBinding cameraInfo(0, vk::DescriptorType::eUniformBufferDynamic, 1,  vk::ShaderStageFlagBits::eVertex);
+	vk::DescriptorSetLayoutBinding shadowCameraInfo(1, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex);
+	vk::DescriptorSetLayoutBinding lightInfo(2, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eFragment);
 
 	std::vector<vk::DescriptorSetLayoutBinding> bindings{ cameraInfo, shadowCameraInfo, lightInfo };
 
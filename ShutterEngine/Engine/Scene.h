@@ -2,21 +2,33 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <array>
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
 
 #include "Camera.h"
 #include "Renderer/DeviceHandler.h"
 #include "Renderer/Buffer.h"
+#include "Renderer/FrameAllocator.h"
 
 #include "Light.h"
 #include "Renderer/Material.h"
 #include "Renderer/Cubemap.h"
 #include "Engine/Mesh.h"
+#include "Engine/MeshRegistry.h"
 #include "Object.h"
+#include "TransformSystem.h"
 #include "Texture.h"
 #include "CubeTexture.h"
 #include "Renderer/Shadow.h"
+#include "ClusterCulling.h"
+
+// Consecutive objects of a material drawing the same mesh with the same textures. Their transforms
+// are consecutive too, so an instanced draw reads the matrices straight from the frame data.
+struct InstanceGroup {
+	uint32_t _First;
+	uint32_t _Count;
+};
 
 struct SceneDataObject {
 	union alignas(256) Data{
@@ -29,28 +41,44 @@ struct SceneDataObject {
 class Scene {
 public:
 	// Load a scene from a set of yaml files
-	void Load(const std::string &name, Device *device, const vk::CommandPool &cmdPool, const vk::RenderPass &renderPass, const vk::RenderPass &shadowPass, const Texture &shadow);
+	void Load(const std::string &name, Device *device, UploadContext &upload, const vk::RenderPass &renderPass, const vk::RenderPass &shadowPass, const Texture &shadow);
+
+	// Release the meshes, textures and uniform data, they are destroyed once the GPU is done with them
+	void Clean();
 
 	void Resize(const vk::RenderPass &renderPass, const vk::RenderPass &renderShadow, const vk::Extent2D &dimension);
 
+	// To call when a texture bound to the objects got recreated, e.g. the shadow map
+	void UpdateTextureDescriptors();
+	void SetSampleCount(const vk::SampleCountFlagBits samples);
+
 
 	std::vector<Light> _Lights;
 	std::map<std::string, Material*> _Materials;
 	std::unordered_map<std::string, Cubemap> _Cubemaps;
-	std::unordered_map<std::string, Mesh> _Models;
+	MeshRegistry _Meshes;
 	std::unordered_map<std::string, std::vector<Object>> _Objects;
+	std::unordered_map<std::string, std::vector<InstanceGroup>> _InstanceGroups;
+
+	// Visible meshlets of each object for the pass recorded next, indexed like _Objects
+	std::unordered_map<std::string, std::vector<ClusterDraws>> _ClusterDraws;
 	std::unordered_map<std::string, Texture> _Textures;
 
-	void CreateDynamic(Device *device);
-	uint32_t AddToDynamic(const Object &object);
-	void UploadDynamic();
+	void CreateDynamic(Device *device, const uint32_t nbImages);
 
 	void ReloadShader(const vk::RenderPass &renderPass, const vk::Extent2D &screenSize);
 
 
 
 	void CreateDescriptorSets(Device *device, const uint32_t nbImages);
-	void Update(const uint32_t image);
+
+	// Reset the per frame uniform data, once the GPU is done with this frame
+	void BeginFrame(const uint32_t image);
+	void Update();
+
+	// Cull the meshlets of the objects drawn by the shadow or the colour pass against its camera, before recording it.
+	// Objects drawn through an instanced material are left whole.
+	void CullClusters(const bool shadowPass);
 
 
 	vk::DescriptorSet GetDescriptorSet(const uint32_t image) const {
@@ -61,9 +89,42 @@ public:
 		return _DescriptorSetLayout;
 	}
 
+	// Dynamic offsets of the scene descriptor set written by the last update
+	const std::array<uint32_t, 3> &GetDynamicOffsets() const {
+		return _SceneDataOffsets;
+	}
+
+	// Dynamic offset of the model matrix of an object for the current frame
+	uint32_t GetDynamicOffset(const Object &object) const {
+		return _ObjectData.Offset + object._TransformId * _DynamicStride;
+	}
+
+	uint32_t GetDynamicStride() const {
+		return _DynamicStride;
+	}
+
+	// Holds the model matrices, bound as instance data from the dynamic offset of the first instance
+	const vk::Buffer &GetInstanceBuffer() const {
+		return _FrameAllocator.GetBuffer();
+	}
+
+	// Holds the commands of the visible meshlets, at the offsets of the cluster draws
+	const vk::Buffer &GetDrawCommandBuffer() const {
+		return _DrawCommands.GetBuffer();
+	}
+
 private:
 	void CreateDescriptorSetLayout(const uint32_t nbImages);
 
+	// Size the frame data from the transforms of the loaded objects and point the scene descriptors at it
+	void CreateFrameData();
+
+	// Replace the static objects sharing a material and textures by one object per group
+	void MergeStaticObjects(Device *device, UploadContext &upload);
+
+	// Sort the objects of the instanced materials by mesh and textures, then split every material in groups
+	void GroupInstances();
+
 public:
 	Camera _Camera;
 	Camera _ShadowCamera;
@@ -72,14 +133,25 @@ public:
 private:
 	Device *_Device;
 
-	size_t dynamicIndex = 0;
-
 	vk::DescriptorPool _DescriptorPool;
 
 	std::vector<vk::DescriptorSet> _SceneDescriptorSets;
 
 	vk::DescriptorSetLayout _DescriptorSetLayout;
 
-	std::vector<Buffer> _SceneDataBuffers;
-	std::vector<SceneDataObject> _SceneDataObjects;
+	// Scene block and object matrices, sub-allocated each update
+	FrameAllocator _FrameAllocator;
+	std::array<uint32_t, 3> _SceneDataOffsets = { 0, 0, 0 };
+
+	// Object matrices sit at the start of each slot, so a slot keeps the matrices written last time it was used
+	FrameAllocation _ObjectData;
+	uint32_t _DynamicStride = 0;
+	size_t _NbDynamicObjects = 0;
+	uint32_t _FrameSlot = 0;
+	uint32_t _NbFrames = 0;
+
+	// Room for one command per meshlet of every level, for both passes
+	FrameAllocator _DrawCommands;
+
+	TransformSystem _Transforms;
 };
\ No newline at end of file
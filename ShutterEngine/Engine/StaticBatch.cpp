@@ -0,0 +1,96 @@
+#include "StaticBatch.h"
+#include <algorithm>
+
+std::vector<std::vector<const Object*>> StaticBatch::Group(const std::vector<Object> &objects)
+{
+	std::vector<std::vector<const Object*>> groups;
+
+	for (const auto &object : objects) {
+		if (!object._Static) {
+			continue;
+		}
+
+		auto group = std::find_if(groups.begin(), groups.end(), [&object](const std::vector<const Object*> &group) {
+			return group.front()->GetTextures() == object.GetTextures();
+		});
+
+		if (group == groups.end()) {
+			groups.push_back({ &object });
+		}
+		else {
+			group->push_back(&object);
+		}
+	}
+
+	groups.erase(std::remove_if(groups.begin(), groups.end(), [](const std::vector<const Object*> &group) {
+		return group.size() < MIN_OBJECTS;
+	}), groups.end());
+
+	return groups;
+}
+
+MeshData StaticBatch::Merge(const std::vector<const Object*> &objects, const std::string &name)
+{
+	MeshData merged;
+	merged._Name = name;
+
+	size_t nbVertices = 0, nbIndices = 0;
+	for (const auto *object : objects) {
+		nbVertices += object->_Mesh->_Vertices.size();
+		nbIndices += object->_Mesh->_Lods.front()._NbIndices;
+	}
+	merged._Vertices.reserve(nbVertices);
+	merged._Indices.reserve(nbIndices);
+
+	for (const auto *object : objects) {
+		const Mesh &mesh = *object->_Mesh;
+		const glm::mat4 &model = object->GetModelMatrix();
+		const glm::mat3 tangentMatrix(model);
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(tangentMatrix));
+
+		// The triangles keep their winding, a mirroring transform flips them on screen exactly as before
+		SubMesh subMesh;
+		subMesh._Name = object->_Name;
+		subMesh._FirstIndex = static_cast<uint32_t>(merged._Indices.size());
+		subMesh._NbIndices = mesh._Lods.front()._NbIndices;
+
+		// Only the full detail level, the batch is drawn as a whole
+		const uint32_t baseVertex = static_cast<uint32_t>(merged._Vertices.size());
+		for (uint32_t i = 0; i < subMesh._NbIndices; ++i) {
+			merged._Indices.push_back(baseVertex + mesh._Indices[mesh._Lods.front()._FirstIndex + i]);
+		}
+
+		for (const auto &source : mesh._Vertices) {
+			Vertex vertex = source;
+			vertex.position = glm::vec3(model * glm::vec4(source.position, 1.0f));
+
+			vertex.normal = normalMatrix * source.normal;
+			const float length = glm::length(vertex.normal);
+			if (length > 0.0f) {
+				vertex.normal /= length;
+			}
+
+			vertex.tangent = tangentMatrix * source.tangent;
+			vertex.bitangent = tangentMatrix * source.bitangent;
+
+			if (merged._Vertices.size() == baseVertex) {
+				subMesh._Min = vertex.position;
+				subMesh._Max = vertex.position;
+			}
+			subMesh._Min = glm::min(subMesh._Min, vertex.position);
+			subMesh._Max = glm::max(subMesh._Max, vertex.position);
+
+			merged._Vertices.push_back(vertex);
+		}
+
+		merged._SubMeshes.push_back(subMesh);
+	}
+
+	merged._Quantization = ComputeVertexQuantization(merged._Vertices);
+	merged._Lods.push_back({ 0, static_cast<uint32_t>(merged._Indices.size()), 0.0f });
+
+	// A batch spans the whole scene, culling its meshlets is what keeps it from always being drawn whole
+	merged.BuildMeshlets();
+
+	return merged;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "MeshData.h"
+#include "Object.h"
+
+// Static objects drawn with the same material and textures, merged into a single mesh in
+// world space so they cost one draw and one descriptor set bind
+class StaticBatch {
+public:
+	// Split the static objects of a material by texture set, the others are left out
+	static std::vector<std::vector<const Object*>> Group(const std::vector<Object> &objects);
+
+	// Bake the transforms of the objects into one mesh, with a sub-mesh for each
+	static MeshData Merge(const std::vector<const Object*> &objects, const std::string &name);
+
+	// Below this, merging saves nothing
+	static const size_t MIN_OBJECTS = 2;
+};
@@ -1,25 +1,31 @@
 #include "Texture.h"
+#include "TextureContainer.h"
 #include "Renderer/Helpers.h"
 #include <algorithm>
+#include <iostream>
+#include <stdexcept>
 
-void Texture::Load(const std::string &filename, bool generateMips)
+void Texture::Load(const std::string &filename, UploadContext &upload, bool generateMips)
 {
-	_Filename = filename;
-
-	int width;
-	int height;
-	int channels;
+	DecodedImage image;
 
 	// Load the image from disk
-	stbi_uc* image = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	int width, height, channels;
+	image.Pixels.reset(stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha));
+	if (!image.Pixels) {
+		throw std::runtime_error("Could not read the texture " + filename);
+	}
+	image.Width = static_cast<uint32_t>(width);
+	image.Height = static_cast<uint32_t>(height);
 
-	_Dimensions = vk::Extent3D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+	Create(filename, image, upload, generateMips);
+}
 
-	// Copy the data to the buffer
-	_Buffer = Buffer(_Device, vk::BufferUsageFlagBits::eTransferSrc, width * height * 4);
-	_Buffer.Copy(image, width * height * 4);
+void Texture::Create(const std::string &filename, const DecodedImage &image, UploadContext &upload, bool generateMips)
+{
+	_Filename = filename;
 
-	stbi_image_free(image);
+	_Dimensions = vk::Extent3D{ image.Width, image.Height, 1 };
 
 	_Image = Image(
 		_Device,
@@ -30,51 +36,102 @@ void Texture::Load(const std::string &filename, bool generateMips)
 		generateMips
 	);
 
+	_Image.SetAsset(filename);
+
+	// Record the copy, the pixels are staged so they can be released right away
+	_Image.TransitionLayout(upload.GetCommandBuffer(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+	upload.CopyToImage(image.Pixels.get(), image.GetSize(), _Image, _Dimensions);
+
+	// Blits need the graphics queue, the image is handed over before the mips are generated
+	if (_Image.GetMipLevel() > 1u) {
+		upload.Release(_Image, vk::ImageLayout::eTransferDstOptimal);
+		_Image.GenerateMipmaps(upload.GetGraphicsCommandBuffer());
+	}
+	else
+	{
+		upload.Release(_Image, vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+
 	CreateSampler();
 }
 
-void Texture::Clean()
+bool Texture::LoadCompressed(const std::string &filename, UploadContext &upload)
 {
-	//_Buffer.Clean();
-	//_Device->GetDevice().destroySampler(_Sampler);
-	//_Image.Clean();
+	TextureContainer container(filename);
+	if (!container.IsValid()) {
+		std::cerr << "Could not read the compressed texture " << filename << std::endl;
+		return false;
+	}
+
+	const vk::Format format = container.GetFormat();
+	if (!_Device->GetEnabledFeatures().textureCompressionBC || !_Device->SupportsSampledFormat(format)) {
+		std::cerr << filename << ": format " << vk::to_string(format) << " cannot be sampled by the device" << std::endl;
+		return false;
+	}
+
+	_Filename = filename;
+
+	const std::vector<TextureContainer::Level> &levels = container.GetLevels();
+	_Dimensions = vk::Extent3D{ levels.front().Width, levels.front().Height, 1 };
+
+	_Image = Image(
+		_Device,
+		_Dimensions,
+		1,
+		static_cast<uint32_t>(levels.size()),
+		format,
+		vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled
+	);
+
+	_Image.SetAsset(filename);
+
+	// Every level is staged straight from the mapped file
+	_Image.TransitionLayout(upload.GetCommandBuffer(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+	for (uint32_t i = 0; i < levels.size(); ++i) {
+		upload.CopyToImage(levels[i].Data, levels[i].Size, _Image, vk::Extent3D{ levels[i].Width, levels[i].Height, 1 }, 0, i);
+	}
+	upload.Release(_Image, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	CreateSampler();
+
+	return true;
 }
 
-void Texture::TransferBufferToImage(const vk::CommandPool &cmdPool)
+Texture::Texture(Texture &&texture) noexcept
 {
-	std::array<vk::BufferImageCopy, 1> regions = {};
-	regions[0].bufferOffset = 0;
-	regions[0].bufferRowLength = 0;
-	regions[0].bufferImageHeight = 0;
-	regions[0].imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-	regions[0].imageSubresource.mipLevel = 0;
-	regions[0].imageSubresource.baseArrayLayer = 0;
-	regions[0].imageSubresource.layerCount = 1;
-	regions[0].imageOffset = { 0,0,0 };
-	regions[0].imageExtent = _Dimensions;
-
-	_Image.TransitionLayout(cmdPool, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-
-	vk::CommandBuffer cmdBuffer = BeginSingleUseCommandBuffer(*_Device, cmdPool);
-
-	cmdBuffer.copyBufferToImage(
-		_Buffer.GetBuffer(),
-		_Image.GetImage(),
-		vk::ImageLayout::eTransferDstOptimal,
-		regions
-	);
+	*this = std::move(texture);
+}
 
-	EndSingleUseCommandBuffer(cmdBuffer, *_Device, cmdPool);
+Texture &Texture::operator=(Texture &&texture) noexcept
+{
+	if (this != &texture) {
+		Clean();
 
-	if (_Image.GetMipLevel() > 1u) {
-		_Image.GenerateMipmaps(cmdPool);
+		_Image = std::move(texture._Image);
+		_Device = texture._Device;
+		_Sampler = texture._Sampler;
+		_Dimensions = texture._Dimensions;
+		_Filename = std::move(texture._Filename);
+
+		texture._Sampler = nullptr;
 	}
-	else
-	{
-		_Image.TransitionLayout(cmdPool, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	return *this;
+}
+
+void Texture::Clean()
+{
+	if (_Sampler) {
+		vk::Device device = _Device->GetDevice();
+		vk::Sampler sampler = _Sampler;
+
+		_Device->GetDeletionQueue().Push([device, sampler]() {
+			device.destroySampler(sampler);
+		});
+		_Sampler = nullptr;
 	}
 
-	_Buffer.Clean();
+	_Image.Clean();
 }
 
 void Texture::CreateSampler()
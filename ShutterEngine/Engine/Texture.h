@@ -4,20 +4,34 @@
 #include "Renderer/Image.h"
 #include "Renderer/Buffer.h"
 #include "Renderer/DeviceHandler.h"
-#include "stb_image.h"
+#include "Renderer/UploadContext.h"
+#include "ImageDecoder.h"
 
 class Texture {
 public:
 	Texture(){}
 	explicit Texture(Device *device) : _Device(device){};
+
+	// Owns the image and the sampler, only moves
+	Texture(const Texture &texture) = delete;
+	Texture &operator=(const Texture &texture) = delete;
+	Texture(Texture &&texture) noexcept;
+	Texture &operator=(Texture &&texture) noexcept;
+
 	~Texture() {
 		Clean();
 	}
 
-	void Load(const std::string &filename, bool generateMips = false);
-	void Clean();
+	// Create the image and record its upload, it can be sampled once the upload is complete
+	void Load(const std::string &filename, UploadContext &upload, bool generateMips = false);
 
-	virtual void TransferBufferToImage(const vk::CommandPool &cmdPool);
+	// Same with an image decoded beforehand, its pixels are staged and can be released on return
+	void Create(const std::string &filename, const DecodedImage &image, UploadContext &upload, bool generateMips = false);
+
+	// Same with a block compressed KTX2 or DDS file, uploaded with its own mips. Return false and create
+	// nothing when the file cannot be read or the device cannot sample its format.
+	bool LoadCompressed(const std::string &filename, UploadContext &upload);
+	void Clean();
 
 	const vk::Sampler &GetSampler() const {
 		return _Sampler;
@@ -34,7 +48,7 @@ public:
 	void CreateSampler();
 
 //protected:
-	Device *_Device;
+	Device *_Device = nullptr;
 //public:
 
 	vk::Sampler _Sampler;
@@ -43,5 +57,4 @@ public:
 
 private:
 	std::string _Filename;
-	Buffer _Buffer;
 };
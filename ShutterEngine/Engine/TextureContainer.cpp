@@ -0,0 +1,287 @@
+#include "TextureContainer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	// The 64 bit fields are only 4 byte aligned in the file
+#pragma pack(push, 4)
+	struct Ktx2Header {
+		uint32_t VkFormat;
+		uint32_t TypeSize;
+		uint32_t PixelWidth;
+		uint32_t PixelHeight;
+		uint32_t PixelDepth;
+		uint32_t LayerCount;
+		uint32_t FaceCount;
+		uint32_t LevelCount;
+		uint32_t SupercompressionScheme;
+
+		uint32_t DfdByteOffset;
+		uint32_t DfdByteLength;
+		uint32_t KvdByteOffset;
+		uint32_t KvdByteLength;
+		uint64_t SgdByteOffset;
+		uint64_t SgdByteLength;
+	};
+#pragma pack(pop)
+
+	struct Ktx2Level {
+		uint64_t ByteOffset;
+		uint64_t ByteLength;
+		uint64_t UncompressedByteLength;
+	};
+
+	const char DDS_MAGIC[4] = { 'D', 'D', 'S', ' ' };
+	const uint32_t DDS_FOURCC = 0x4;
+
+	struct DdsPixelFormat {
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask;
+		uint32_t GBitMask;
+		uint32_t BBitMask;
+		uint32_t ABitMask;
+	};
+
+	struct DdsHeader {
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t Height;
+		uint32_t Width;
+		uint32_t PitchOrLinearSize;
+		uint32_t Depth;
+		uint32_t MipMapCount;
+		uint32_t Reserved1[11];
+		DdsPixelFormat PixelFormat;
+		uint32_t Caps;
+		uint32_t Caps2;
+		uint32_t Caps3;
+		uint32_t Caps4;
+		uint32_t Reserved2;
+	};
+
+	struct DdsHeaderDx10 {
+		uint32_t DxgiFormat;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+
+	// Cube maps and volumes
+	const uint32_t DDS_CAPS2_CUBEMAP = 0x200;
+	const uint32_t DDS_CAPS2_VOLUME = 0x200000;
+	const uint32_t DXGI_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+	uint32_t MakeFourCC(const char *code)
+	{
+		return uint32_t(uint8_t(code[0])) | uint32_t(uint8_t(code[1])) << 8 | uint32_t(uint8_t(code[2])) << 16 | uint32_t(uint8_t(code[3])) << 24;
+	}
+
+	// Levels of a full mip chain, down to 1x1
+	uint32_t GetMaxLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t nbLevels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+			++nbLevels;
+		}
+		return nbLevels;
+	}
+
+	vk::Format FromFourCC(const uint32_t fourCC)
+	{
+		if (fourCC == MakeFourCC("DXT1")) {
+			return vk::Format::eBc1RgbaUnormBlock;
+		}
+		if (fourCC == MakeFourCC("DXT5")) {
+			return vk::Format::eBc3UnormBlock;
+		}
+		if (fourCC == MakeFourCC("ATI1") || fourCC == MakeFourCC("BC4U")) {
+			return vk::Format::eBc4UnormBlock;
+		}
+		if (fourCC == MakeFourCC("BC4S")) {
+			return vk::Format::eBc4SnormBlock;
+		}
+		if (fourCC == MakeFourCC("ATI2") || fourCC == MakeFourCC("BC5U")) {
+			return vk::Format::eBc5UnormBlock;
+		}
+		if (fourCC == MakeFourCC("BC5S")) {
+			return vk::Format::eBc5SnormBlock;
+		}
+
+		return vk::Format::eUndefined;
+	}
+
+	vk::Format FromDxgi(const uint32_t format)
+	{
+		switch (format) {
+		case 71: return vk::Format::eBc1RgbaUnormBlock;
+		case 72: return vk::Format::eBc1RgbaSrgbBlock;
+		case 77: return vk::Format::eBc3UnormBlock;
+		case 78: return vk::Format::eBc3SrgbBlock;
+		case 80: return vk::Format::eBc4UnormBlock;
+		case 81: return vk::Format::eBc4SnormBlock;
+		case 83: return vk::Format::eBc5UnormBlock;
+		case 84: return vk::Format::eBc5SnormBlock;
+		case 98: return vk::Format::eBc7UnormBlock;
+		case 99: return vk::Format::eBc7SrgbBlock;
+		default: return vk::Format::eUndefined;
+		}
+	}
+}
+
+TextureContainer::TextureContainer(const std::string &filename) :
+	_File(filename)
+{
+	if (!_File.IsOpen()) {
+		return;
+	}
+
+	const bool valid = ParseKtx2() || ParseDds();
+	if (!valid) {
+		_Levels.clear();
+	}
+}
+
+size_t TextureContainer::GetBlockSize(const vk::Format format)
+{
+	switch (format) {
+	case vk::Format::eBc1RgbUnormBlock:
+	case vk::Format::eBc1RgbSrgbBlock:
+	case vk::Format::eBc1RgbaUnormBlock:
+	case vk::Format::eBc1RgbaSrgbBlock:
+	case vk::Format::eBc4UnormBlock:
+	case vk::Format::eBc4SnormBlock:
+		return 8;
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc3SrgbBlock:
+	case vk::Format::eBc5UnormBlock:
+	case vk::Format::eBc5SnormBlock:
+	case vk::Format::eBc7UnormBlock:
+	case vk::Format::eBc7SrgbBlock:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t TextureContainer::GetLevelSize(const vk::Format format, const uint32_t width, const uint32_t height)
+{
+	// Partial blocks on the edges are stored whole
+	return size_t((std::max(width, 1u) + 3) / 4) * size_t((std::max(height, 1u) + 3) / 4) * GetBlockSize(format);
+}
+
+bool TextureContainer::ParseKtx2()
+{
+	const size_t headerEnd = sizeof(KTX2_IDENTIFIER) + sizeof(Ktx2Header);
+	if (_File.GetSize() < headerEnd || std::memcmp(_File.GetData(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+		return false;
+	}
+
+	Ktx2Header header;
+	std::memcpy(&header, _File.GetData() + sizeof(KTX2_IDENTIFIER), sizeof(header));
+
+	// Arrays, cube maps, volumes and supercompressed data are left to the RGBA8 path
+	if (header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1 || header.SupercompressionScheme != 0
+		|| header.PixelWidth == 0 || header.PixelHeight == 0) {
+		return false;
+	}
+
+	_Format = static_cast<vk::Format>(header.VkFormat);
+	if (GetBlockSize(_Format) == 0) {
+		return false;
+	}
+
+	// 0 asks for the mips to be generated at load, left to the RGBA8 path which does it.
+	// Levels past 1x1 would make an invalid image.
+	const uint32_t nbLevels = header.LevelCount;
+	if (nbLevels == 0 || nbLevels > GetMaxLevels(header.PixelWidth, header.PixelHeight)
+		|| _File.GetSize() - headerEnd < nbLevels * sizeof(Ktx2Level)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < nbLevels; ++i) {
+		Ktx2Level level;
+		std::memcpy(&level, _File.GetData() + headerEnd + i * sizeof(Ktx2Level), sizeof(level));
+
+		const uint32_t width = std::max(header.PixelWidth >> i, 1u);
+		const uint32_t height = std::max(header.PixelHeight >> i, 1u);
+		if (level.ByteLength != GetLevelSize(_Format, width, height) || !AddLevel(level.ByteOffset, level.ByteLength, width, height)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool TextureContainer::ParseDds()
+{
+	const size_t headerEnd = sizeof(DDS_MAGIC) + sizeof(DdsHeader);
+	if (_File.GetSize() < headerEnd || std::memcmp(_File.GetData(), DDS_MAGIC, sizeof(DDS_MAGIC)) != 0) {
+		return false;
+	}
+
+	DdsHeader header;
+	std::memcpy(&header, _File.GetData() + sizeof(DDS_MAGIC), sizeof(header));
+
+	if (header.Size != sizeof(DdsHeader) || !(header.PixelFormat.Flags & DDS_FOURCC) || (header.Caps2 & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME))
+		|| header.Width == 0 || header.Height == 0) {
+		return false;
+	}
+
+	uint64_t offset = headerEnd;
+	if (header.PixelFormat.FourCC == MakeFourCC("DX10")) {
+		if (_File.GetSize() < headerEnd + sizeof(DdsHeaderDx10)) {
+			return false;
+		}
+
+		DdsHeaderDx10 extension;
+		std::memcpy(&extension, _File.GetData() + headerEnd, sizeof(extension));
+		if (extension.ResourceDimension != DXGI_RESOURCE_DIMENSION_TEXTURE2D || extension.ArraySize > 1) {
+			return false;
+		}
+
+		_Format = FromDxgi(extension.DxgiFormat);
+		offset += sizeof(DdsHeaderDx10);
+	}
+	else {
+		_Format = FromFourCC(header.PixelFormat.FourCC);
+	}
+
+	if (GetBlockSize(_Format) == 0) {
+		return false;
+	}
+
+	// The levels follow each other, from the largest
+	const uint32_t nbLevels = std::max(header.MipMapCount, 1u);
+	if (nbLevels > GetMaxLevels(header.Width, header.Height)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < nbLevels; ++i) {
+		const uint32_t width = std::max(header.Width >> i, 1u);
+		const uint32_t height = std::max(header.Height >> i, 1u);
+		const size_t size = GetLevelSize(_Format, width, height);
+
+		if (!AddLevel(offset, size, width, height)) {
+			return false;
+		}
+		offset += size;
+	}
+
+	return true;
+}
+
+bool TextureContainer::AddLevel(const uint64_t offset, const uint64_t size, const uint32_t width, const uint32_t height)
+{
+	if (offset > _File.GetSize() || size > _File.GetSize() - offset) {
+		return false;
+	}
+
+	_Levels.push_back({ _File.GetData() + offset, static_cast<size_t>(size), width, height });
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <vulkan/vulkan.hpp>
+#include "MappedFile.h"
+
+// Block compressed image read from a KTX2 or DDS file with the mip chain baked in it. The texels are
+// used as they are mapped, nothing is decoded. Only 2D images in BC1, BC3, BC4, BC5 or BC7 are supported,
+// without supercompression.
+class TextureContainer {
+public:
+	struct Level {
+		const char *Data;
+		size_t Size;
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	explicit TextureContainer(const std::string &filename);
+
+	// False if the file cannot be read, or is not a supported image
+	bool IsValid() const {
+		return !_Levels.empty();
+	}
+
+	vk::Format GetFormat() const {
+		return _Format;
+	}
+
+	// The full size level comes first
+	const std::vector<Level> &GetLevels() const {
+		return _Levels;
+	}
+
+	// Bytes of a block of 4x4 texels, 0 for the formats not supported
+	static size_t GetBlockSize(const vk::Format format);
+
+	// Bytes of a level of the given size
+	static size_t GetLevelSize(const vk::Format format, const uint32_t width, const uint32_t height);
+
+private:
+	bool ParseKtx2();
+	bool ParseDds();
+
+	// Check the level fits in the file before adding it
+	bool AddLevel(const uint64_t offset, const uint64_t size, const uint32_t width, const uint32_t height);
+
+private:
+	MappedFile _File;
+
+	vk::Format _Format = vk::Format::eUndefined;
+	std::vector<Level> _Levels;
+};
@@ -0,0 +1,242 @@
+#include "TransformSystem.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+uint32_t TransformSystem::Add(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+{
+	uint32_t id = static_cast<uint32_t>(_Count);
+
+	// Grow by a whole block of identity transforms
+	if (_Count % BLOCK_SIZE == 0) {
+		size_t size = _Count + BLOCK_SIZE;
+
+		_PositionX.resize(size, 0.0f);
+		_PositionY.resize(size, 0.0f);
+		_PositionZ.resize(size, 0.0f);
+
+		_RotationX.resize(size, 0.0f);
+		_RotationY.resize(size, 0.0f);
+		_RotationZ.resize(size, 0.0f);
+		_RotationW.resize(size, 1.0f);
+
+		_ScaleX.resize(size, 1.0f);
+		_ScaleY.resize(size, 1.0f);
+		_ScaleZ.resize(size, 1.0f);
+
+		_DirtySlots.push_back(0);
+	}
+
+	++_Count;
+	Set(id, position, rotation, scale);
+
+	return id;
+}
+
+void TransformSystem::Set(const uint32_t id, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+{
+	_PositionX[id] = position.x;
+	_PositionY[id] = position.y;
+	_PositionZ[id] = position.z;
+
+	_RotationX[id] = rotation.x;
+	_RotationY[id] = rotation.y;
+	_RotationZ[id] = rotation.z;
+	_RotationW[id] = rotation.w;
+
+	_ScaleX[id] = scale.x;
+	_ScaleY[id] = scale.y;
+	_ScaleZ[id] = scale.z;
+
+	_DirtySlots[id / BLOCK_SIZE] = ~0u;
+}
+
+void TransformSystem::Clear()
+{
+	_Count = 0;
+
+	_PositionX.clear();
+	_PositionY.clear();
+	_PositionZ.clear();
+
+	_RotationX.clear();
+	_RotationY.clear();
+	_RotationZ.clear();
+	_RotationW.clear();
+
+	_ScaleX.clear();
+	_ScaleY.clear();
+	_ScaleZ.clear();
+
+	_DirtySlots.clear();
+}
+
+void TransformSystem::MarkAllDirty()
+{
+	std::fill(_DirtySlots.begin(), _DirtySlots.end(), ~0u);
+}
+
+bool TransformSystem::Compose(const uint32_t slot, void *output, const size_t stride, uint32_t &first, uint32_t &last)
+{
+	const uint32_t slotMask = 1u << slot;
+
+	_Work.clear();
+	for (uint32_t block = 0; block < _DirtySlots.size(); ++block) {
+		if (_DirtySlots[block] & slotMask) {
+			_DirtySlots[block] &= ~slotMask;
+			_Work.push_back(block);
+		}
+	}
+
+	if (_Work.empty()) {
+		return false;
+	}
+
+	ComposeParallel(_Work.data(), _Work.size(), static_cast<char*>(output), stride, 0);
+
+	first = _Work.front() * BLOCK_SIZE;
+	last = std::min<uint32_t>(static_cast<uint32_t>(_Count), (_Work.back() + 1) * BLOCK_SIZE);
+
+	return true;
+}
+
+void TransformSystem::ComposeAll(void *output, const size_t stride, const uint32_t nbThreads)
+{
+	_Work.resize(_DirtySlots.size());
+	for (uint32_t block = 0; block < _Work.size(); ++block) {
+		_Work[block] = block;
+	}
+
+	ComposeParallel(_Work.data(), _Work.size(), static_cast<char*>(output), stride, nbThreads);
+}
+
+glm::quat TransformSystem::FromEuler(const glm::vec3 &degrees)
+{
+	return glm::angleAxis(glm::radians(degrees.x), glm::vec3(1.0f, 0.0f, 0.0f))
+		* glm::angleAxis(glm::radians(degrees.y), glm::vec3(0.0f, 1.0f, 0.0f))
+		* glm::angleAxis(glm::radians(degrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+void TransformSystem::ComposeParallel(const uint32_t *blocks, const size_t nbBlocks, char *output, const size_t stride, uint32_t nbThreads) const
+{
+	WorkerPool &pool = WorkerPool::GetShared();
+	if (nbThreads == 0) {
+		nbThreads = nbBlocks < PARALLEL_THRESHOLD ? 1 : pool.GetThreadCount() + 1;
+	}
+
+	if (nbThreads == 1) {
+		ComposeBlocks(blocks, nbBlocks, output, stride);
+		return;
+	}
+
+	// One share per thread, on the shared workers and the calling thread
+	const size_t share = (nbBlocks + nbThreads - 1) / nbThreads;
+	const size_t nbShares = (nbBlocks + share - 1) / share;
+
+	pool.ParallelFor(nbShares, [&](size_t i) {
+		const size_t start = i * share;
+		ComposeBlocks(blocks + start, std::min(share, nbBlocks - start), output, stride);
+	});
+}
+
+#ifdef TRANSFORM_SSE
+void TransformSystem::ComposeBlocks(const uint32_t *blocks, const size_t nbBlocks, char *output, const size_t stride) const
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (size_t b = 0; b < nbBlocks; ++b) {
+		const size_t base = blocks[b] * BLOCK_SIZE;
+
+		const __m128 qx = _mm_loadu_ps(&_RotationX[base]);
+		const __m128 qy = _mm_loadu_ps(&_RotationY[base]);
+		const __m128 qz = _mm_loadu_ps(&_RotationZ[base]);
+		const __m128 qw = _mm_loadu_ps(&_RotationW[base]);
+
+		const __m128 xx = _mm_mul_ps(qx, qx);
+		const __m128 yy = _mm_mul_ps(qy, qy);
+		const __m128 zz = _mm_mul_ps(qz, qz);
+		const __m128 xy = _mm_mul_ps(qx, qy);
+		const __m128 xz = _mm_mul_ps(qx, qz);
+		const __m128 yz = _mm_mul_ps(qy, qz);
+		const __m128 wx = _mm_mul_ps(qw, qx);
+		const __m128 wy = _mm_mul_ps(qw, qy);
+		const __m128 wz = _mm_mul_ps(qw, qz);
+
+		const __m128 sx = _mm_loadu_ps(&_ScaleX[base]);
+		const __m128 sy = _mm_loadu_ps(&_ScaleY[base]);
+		const __m128 sz = _mm_loadu_ps(&_ScaleZ[base]);
+
+		// Rotation columns scaled, one lane per object
+		__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		__m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		__m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+		__m128 c0w = zero;
+
+		__m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		__m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+		__m128 c1w = zero;
+
+		__m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		__m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+		__m128 c2w = zero;
+
+		__m128 c3x = _mm_loadu_ps(&_PositionX[base]);
+		__m128 c3y = _mm_loadu_ps(&_PositionY[base]);
+		__m128 c3z = _mm_loadu_ps(&_PositionZ[base]);
+		__m128 c3w = one;
+
+		// Back to one column per register for each object
+		_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+		_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+		_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+		_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+		const __m128 columns[4][4] = {
+			{ c0x, c1x, c2x, c3x },
+			{ c0y, c1y, c2y, c3y },
+			{ c0z, c1z, c2z, c3z },
+			{ c0w, c1w, c2w, c3w }
+		};
+
+		const size_t nbLanes = std::min<size_t>(BLOCK_SIZE, _Count - base);
+		for (size_t lane = 0; lane < nbLanes; ++lane) {
+			float *matrix = reinterpret_cast<float*>(output + (base + lane) * stride);
+			_mm_storeu_ps(matrix + 0, columns[lane][0]);
+			_mm_storeu_ps(matrix + 4, columns[lane][1]);
+			_mm_storeu_ps(matrix + 8, columns[lane][2]);
+			_mm_storeu_ps(matrix + 12, columns[lane][3]);
+		}
+	}
+}
+#else
+void TransformSystem::ComposeBlocks(const uint32_t *blocks, const size_t nbBlocks, char *output, const size_t stride) const
+{
+	for (size_t b = 0; b < nbBlocks; ++b) {
+		const size_t base = blocks[b] * BLOCK_SIZE;
+		const size_t end = std::min<size_t>(base + BLOCK_SIZE, _Count);
+
+		for (size_t i = base; i < end; ++i) {
+			const float x = _RotationX[i], y = _RotationY[i], z = _RotationZ[i], w = _RotationW[i];
+			const float sx = _ScaleX[i], sy = _ScaleY[i], sz = _ScaleZ[i];
+
+			const float matrix[16] = {
+				(1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y + w * z) * sx, 2.0f * (x * z - w * y) * sx, 0.0f,
+				2.0f * (x * y - w * z) * sy, (1.0f - 2.0f * (x * x + z * z)) * sy, 2.0f * (y * z + w * x) * sy, 0.0f,
+				2.0f * (x * z + w * y) * sz, 2.0f * (y * z - w * x) * sz, (1.0f - 2.0f * (x * x + y * y)) * sz, 0.0f,
+				_PositionX[i], _PositionY[i], _PositionZ[i], 1.0f
+			};
+
+			std::memcpy(output + i * stride, matrix, sizeof(matrix));
+		}
+	}
+}
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Position, rotation and scale of the objects, stored as structure of arrays so
+// world matrices can be composed four at a time
+class TransformSystem {
+public:
+	TransformSystem() {}
+
+	uint32_t Add(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale);
+	void Set(const uint32_t id, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale);
+	void Clear();
+
+	// Every slot has to receive all the matrices again
+	void MarkAllDirty();
+
+	// Write the matrices not yet up to date in the slot, at id * stride in output.
+	// Return false if nothing changed, otherwise the range of ids written.
+	bool Compose(const uint32_t slot, void *output, const size_t stride, uint32_t &first, uint32_t &last);
+
+	// Write every matrix, whatever their state
+	void ComposeAll(void *output, const size_t stride, const uint32_t nbThreads = 0);
+
+	size_t GetCount() const {
+		return _Count;
+	}
+
+	// Same rotation order as the Euler angles used in the scene files
+	static glm::quat FromEuler(const glm::vec3 &degrees);
+
+private:
+	void ComposeBlocks(const uint32_t *blocks, const size_t nbBlocks, char *output, const size_t stride) const;
+	void ComposeParallel(const uint32_t *blocks, const size_t nbBlocks, char *output, const size_t stride, uint32_t nbThreads) const;
+
+private:
+	static const uint32_t BLOCK_SIZE = 4;
+
+	// Under this amount of blocks, handing the work out costs more than it saves
+	static const size_t PARALLEL_THRESHOLD = 4096;
+
+	size_t _Count = 0;
+
+	// Arrays are padded to a multiple of the block size
+	std::vector<float> _PositionX;
+	std::vector<float> _PositionY;
+	std::vector<float> _PositionZ;
+
+	std::vector<float> _RotationX;
+	std::vector<float> _RotationY;
+	std::vector<float> _RotationZ;
+	std::vector<float> _RotationW;
+
+	std::vector<float> _ScaleX;
+	std::vector<float> _ScaleY;
+	std::vector<float> _ScaleZ;
+
+	// One bit per frame slot still holding an outdated matrix, for each block
+	std::vector<uint32_t> _DirtySlots;
+
+	// Blocks to compose during the current call, kept to avoid allocating each frame
+	std::vector<uint32_t> _Work;
+};
@@ -0,0 +1,173 @@
+#include "VertexLayout.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+	// Map a unit vector on the octahedron then unfold it to [-1, 1]^2
+	glm::vec2 EncodeOctahedron(const glm::vec3 &vector)
+	{
+		const float length = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+		if (!(length > 0.0f) || !std::isfinite(length)) {
+			return glm::vec2(0.0f, 0.0f);
+		}
+
+		glm::vec2 result(vector.x / length, vector.y / length);
+		if (vector.z < 0.0f) {
+			result = glm::vec2(
+				(1.0f - std::abs(result.y)) * (result.x >= 0.0f ? 1.0f : -1.0f),
+				(1.0f - std::abs(result.x)) * (result.y >= 0.0f ? 1.0f : -1.0f)
+			);
+		}
+
+		return result;
+	}
+
+	CompactPosition EncodeCompactPosition(const Vertex &vertex, const VertexQuantization &quantization)
+	{
+		glm::vec3 position = vertex.position - glm::vec3(quantization._Offset);
+		for (int i = 0; i < 3; ++i) {
+			position[i] = quantization._Scale[i] > 0.0f ? position[i] / quantization._Scale[i] : 0.0f;
+		}
+
+		// Degenerate UVs leave no tangent frame to speak of, the sign then defaults to positive
+		const float handedness = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent);
+
+		CompactPosition compact;
+		const uint64_t packed = glm::packUnorm4x16(glm::vec4(position, handedness < 0.0f ? 0.0f : 1.0f));
+		std::memcpy(compact.position, &packed, sizeof(compact.position));
+
+		return compact;
+	}
+
+	CompactAttributes EncodeCompactAttributes(const Vertex &vertex)
+	{
+		CompactAttributes compact;
+		compact.normal = glm::packSnorm2x16(EncodeOctahedron(vertex.normal));
+		compact.texCoord = glm::packHalf2x16(vertex.texCoord);
+		compact.tangent = glm::packSnorm2x16(EncodeOctahedron(vertex.tangent));
+
+		return compact;
+	}
+
+	template <typename T>
+	void Append(std::vector<char> &stream, const T &value)
+	{
+		const char *bytes = reinterpret_cast<const char*>(&value);
+		stream.insert(stream.end(), bytes, bytes + sizeof(T));
+	}
+}
+
+VertexQuantization ComputeVertexQuantization(const std::vector<Vertex> &vertices)
+{
+	VertexQuantization quantization = {};
+	if (vertices.empty()) {
+		return quantization;
+	}
+
+	glm::vec3 min = vertices.front().position;
+	glm::vec3 max = vertices.front().position;
+	for (const auto &vertex : vertices) {
+		min = glm::min(min, vertex.position);
+		max = glm::max(max, vertex.position);
+	}
+
+	quantization._Offset = glm::vec4(min, 0.0f);
+	quantization._Scale = glm::vec4(max - min, 0.0f);
+
+	return quantization;
+}
+
+std::vector<char> EncodeVertexStream(const std::vector<Vertex> &vertices, const E_VERTEX_LAYOUT layout, const E_VERTEX_STREAM stream, const VertexQuantization &quantization)
+{
+	std::vector<char> data;
+	data.reserve(vertices.size() * GetVertexStreamSize(layout, stream));
+
+	for (const auto &vertex : vertices) {
+		if (layout == E_VERTEX_LAYOUT::COMPACT) {
+			if (stream == E_VERTEX_STREAM::POSITION_STREAM) {
+				Append(data, EncodeCompactPosition(vertex, quantization));
+			}
+			else {
+				Append(data, EncodeCompactAttributes(vertex));
+			}
+		}
+		else {
+			if (stream == E_VERTEX_STREAM::POSITION_STREAM) {
+				Append(data, vertex.position);
+			}
+			else {
+				StandardAttributes attributes = { vertex.normal, vertex.texCoord, vertex.tangent, vertex.bitangent };
+				Append(data, attributes);
+			}
+		}
+	}
+
+	return data;
+}
+
+size_t GetVertexStreamSize(const E_VERTEX_LAYOUT layout, const E_VERTEX_STREAM stream)
+{
+	if (layout == E_VERTEX_LAYOUT::COMPACT) {
+		return stream == E_VERTEX_STREAM::POSITION_STREAM ? sizeof(CompactPosition) : sizeof(CompactAttributes);
+	}
+
+	return stream == E_VERTEX_STREAM::POSITION_STREAM ? sizeof(glm::vec3) : sizeof(StandardAttributes);
+}
+
+std::vector<vk::VertexInputBindingDescription> GetVertexBindingDescriptions(const E_VERTEX_LAYOUT layout, const bool positionOnly)
+{
+	std::vector<vk::VertexInputBindingDescription> bindings;
+	bindings.push_back(vk::VertexInputBindingDescription(POSITION_STREAM, GetVertexStreamSize(layout, POSITION_STREAM), vk::VertexInputRate::eVertex));
+
+	if (!positionOnly) {
+		bindings.push_back(vk::VertexInputBindingDescription(ATTRIBUTE_STREAM, GetVertexStreamSize(layout, ATTRIBUTE_STREAM), vk::VertexInputRate::eVertex));
+	}
+
+	return bindings;
+}
+
+std::vector<vk::VertexInputAttributeDescription> GetVertexAttributeDescriptions(const E_VERTEX_LAYOUT layout, const bool positionOnly)
+{
+	std::vector<vk::VertexInputAttributeDescription> attributes;
+
+	if (layout == E_VERTEX_LAYOUT::COMPACT) {
+		attributes.push_back(vk::VertexInputAttributeDescription(0, POSITION_STREAM, vk::Format::eR16G16B16A16Unorm, offsetof(CompactPosition, position)));
+
+		if (!positionOnly) {
+			attributes.push_back(vk::VertexInputAttributeDescription(1, ATTRIBUTE_STREAM, vk::Format::eR16G16Snorm, offsetof(CompactAttributes, normal)));
+			attributes.push_back(vk::VertexInputAttributeDescription(2, ATTRIBUTE_STREAM, vk::Format::eR16G16Sfloat, offsetof(CompactAttributes, texCoord)));
+			attributes.push_back(vk::VertexInputAttributeDescription(3, ATTRIBUTE_STREAM, vk::Format::eR16G16Snorm, offsetof(CompactAttributes, tangent)));
+		}
+	}
+	else {
+		attributes.push_back(vk::VertexInputAttributeDescription(0, POSITION_STREAM, vk::Format::eR32G32B32Sfloat, 0));
+
+		if (!positionOnly) {
+			attributes.push_back(vk::VertexInputAttributeDescription(1, ATTRIBUTE_STREAM, vk::Format::eR32G32B32Sfloat, offsetof(StandardAttributes, normal)));
+			attributes.push_back(vk::VertexInputAttributeDescription(2, ATTRIBUTE_STREAM, vk::Format::eR32G32Sfloat, offsetof(StandardAttributes, texCoord)));
+			attributes.push_back(vk::VertexInputAttributeDescription(3, ATTRIBUTE_STREAM, vk::Format::eR32G32B32Sfloat, offsetof(StandardAttributes, tangent)));
+			attributes.push_back(vk::VertexInputAttributeDescription(4, ATTRIBUTE_STREAM, vk::Format::eR32G32B32Sfloat, offsetof(StandardAttributes, bitangent)));
+		}
+	}
+
+	return attributes;
+}
+
+vk::VertexInputBindingDescription GetInstanceBindingDescription(const uint32_t stride)
+{
+	return vk::VertexInputBindingDescription(INSTANCE_BINDING, stride, vk::VertexInputRate::eInstance);
+}
+
+std::vector<vk::VertexInputAttributeDescription> GetInstanceAttributeDescriptions()
+{
+	std::vector<vk::VertexInputAttributeDescription> attributes;
+
+	// One column of the matrix per location
+	for (uint32_t i = 0; i < 4; ++i) {
+		attributes.push_back(vk::VertexInputAttributeDescription(INSTANCE_LOCATION + i, INSTANCE_BINDING, vk::Format::eR32G32B32A32Sfloat, i * sizeof(glm::vec4)));
+	}
+
+	return attributes;
+}
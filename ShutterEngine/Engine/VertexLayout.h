@@ -0,0 +1,84 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Vertex formats a material can ask for, meshes upload the streams of each one in use
+enum E_VERTEX_LAYOUT
+{
+	STANDARD,
+	COMPACT
+};
+
+static const size_t VERTEX_LAYOUT_COUNT = 2;
+
+// Every layout splits its vertices in two buffers, so depth-only passes fetch positions alone
+enum E_VERTEX_STREAM
+{
+	POSITION_STREAM,
+	ATTRIBUTE_STREAM
+};
+
+static const size_t VERTEX_STREAM_COUNT = 2;
+
+// Instanced materials read their model matrix as per-instance data, bound after the vertex streams.
+// The matrix takes four locations from the first one, after the attributes of every layout.
+static const uint32_t INSTANCE_BINDING = VERTEX_STREAM_COUNT;
+static const uint32_t INSTANCE_LOCATION = 5;
+
+// Interleaved vertex used on the CPU side, while loading and optimizing
+struct Vertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texCoord;
+	glm::vec3 tangent;
+	glm::vec3 bitangent;
+};
+
+// Attribute stream of the standard layout, its position stream is a packed glm::vec3
+struct StandardAttributes {
+	glm::vec3 normal;
+	glm::vec2 texCoord;
+	glm::vec3 tangent;
+	glm::vec3 bitangent;
+};
+
+// Pushed to the vertex stage of compact materials, position = offset + unorm * scale
+struct VertexQuantization {
+	glm::vec4 _Offset;
+	glm::vec4 _Scale;
+};
+
+// Position stream of the compact layout: unorm in the mesh bounds, w is 1 when the
+// bitangent follows cross(normal, tangent)
+struct CompactPosition {
+	uint16_t position[4];
+};
+
+// Attribute stream of the compact layout, decoded by Shaders/compact_vertex.glsl
+struct CompactAttributes {
+	// Octahedral snorm
+	uint32_t normal;
+	// Half floats
+	uint32_t texCoord;
+	// Octahedral snorm
+	uint32_t tangent;
+};
+
+VertexQuantization ComputeVertexQuantization(const std::vector<Vertex> &vertices);
+
+// Pack one stream of the vertices in the layout's GPU format
+std::vector<char> EncodeVertexStream(const std::vector<Vertex> &vertices, const E_VERTEX_LAYOUT layout, const E_VERTEX_STREAM stream, const VertexQuantization &quantization);
+
+size_t GetVertexStreamSize(const E_VERTEX_LAYOUT layout, const E_VERTEX_STREAM stream);
+
+// One binding per stream consumed, the attribute locations are the same with both layouts
+std::vector<vk::VertexInputBindingDescription> GetVertexBindingDescriptions(const E_VERTEX_LAYOUT layout, const bool positionOnly);
+std::vector<vk::VertexInputAttributeDescription> GetVertexAttributeDescriptions(const E_VERTEX_LAYOUT layout, const bool positionOnly);
+
+// Model matrices stored stride bytes apart, one per instance
+vk::VertexInputBindingDescription GetInstanceBindingDescription(const uint32_t stride);
+std::vector<vk::VertexInputAttributeDescription> GetInstanceAttributeDescriptions();
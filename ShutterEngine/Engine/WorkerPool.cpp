@@ -0,0 +1,112 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+WorkerPool::WorkerPool(uint32_t nbThreads)
+{
+	if (nbThreads == 0) {
+		nbThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	for (uint32_t i = 0; i < nbThreads; ++i) {
+		_Workers.emplace_back(&WorkerPool::Work, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		_Stopping = true;
+	}
+	_Queued.notify_all();
+
+	for (auto &worker : _Workers) {
+		worker.join();
+	}
+}
+
+void WorkerPool::Submit(std::function<void()> task)
+{
+	// Single core, nobody else would ever run it
+	if (_Workers.empty()) {
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		_Tasks.push_back(std::move(task));
+	}
+	_Queued.notify_one();
+}
+
+void WorkerPool::ParallelFor(const size_t nbTasks, const std::function<void(size_t)> &task)
+{
+	if (nbTasks == 0) {
+		return;
+	}
+
+	// Shared with the helpers, which may only start once everything is done
+	struct Batch {
+		std::function<void(size_t)> Task;
+		size_t Count;
+		std::atomic<size_t> Next;
+		std::atomic<size_t> Done;
+		std::mutex Mutex;
+		std::condition_variable Finished;
+	};
+
+	std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+	batch->Task = task;
+	batch->Count = nbTasks;
+	batch->Next = 0;
+	batch->Done = 0;
+
+	auto run = [](Batch &batch) {
+		for (size_t i = batch.Next++; i < batch.Count; i = batch.Next++) {
+			batch.Task(i);
+			if (++batch.Done == batch.Count) {
+				std::lock_guard<std::mutex> lock(batch.Mutex);
+				batch.Finished.notify_all();
+			}
+		}
+	};
+
+	const size_t nbHelpers = std::min<size_t>(_Workers.size(), nbTasks - 1);
+	for (size_t i = 0; i < nbHelpers; ++i) {
+		Submit([batch, run]() { run(*batch); });
+	}
+
+	run(*batch);
+
+	std::unique_lock<std::mutex> lock(batch->Mutex);
+	batch->Finished.wait(lock, [&batch]() { return batch->Done == batch->Count; });
+}
+
+WorkerPool &WorkerPool::GetShared()
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+void WorkerPool::Work()
+{
+	std::unique_lock<std::mutex> lock(_Mutex);
+	while (true) {
+		_Queued.wait(lock, [this]() { return _Stopping || !_Tasks.empty(); });
+
+		// Queued tasks still run, their owners are waiting for them
+		if (_Tasks.empty()) {
+			return;
+		}
+
+		std::function<void()> task = std::move(_Tasks.front());
+		_Tasks.pop_front();
+
+		lock.unlock();
+		task();
+		lock.lock();
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+// Threads started once and kept waiting for tasks, so per frame work does not pay for creating them
+class WorkerPool {
+public:
+	// 0 threads uses every core but the one of the calling thread
+	explicit WorkerPool(uint32_t nbThreads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool &pool) = delete;
+	WorkerPool &operator=(const WorkerPool &pool) = delete;
+
+	// Queue a task for the first free worker, run it right away if the pool has none
+	void Submit(std::function<void()> task);
+
+	// Run task(i) for every i below nbTasks and return once they are all done.
+	// The calling thread runs tasks too, so this can be called from a task.
+	void ParallelFor(const size_t nbTasks, const std::function<void(size_t)> &task);
+
+	uint32_t GetThreadCount() const {
+		return static_cast<uint32_t>(_Workers.size());
+	}
+
+	// Pool shared by the engine systems, so they do not compete with each other for the cores
+	static WorkerPool &GetShared();
+
+private:
+	void Work();
+
+private:
+	std::vector<std::thread> _Workers;
+
+	std::mutex _Mutex;
+	std::condition_variable _Queued;
+	std::deque<std::function<void()>> _Tasks;
+	bool _Stopping = false;
+};
@@ -0,0 +1,41 @@
+#include "Widgets.h"
+#include "Renderer/TemporalAA.h"
+
+void AntiAliasingWidget::Draw()
+{
+	ImGui::SetNextWindowSize(ImVec2(220, 110));
+	ImGui::SetNextWindowPos(ImVec2(_Margin, 85 + 2 * _Margin));
+	ImGui::Begin("Anti-aliasing", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
+
+	ImGui::RadioButton("MSAA 4x", &_RequestedMode, E_ANTI_ALIASING::MSAA);
+	ImGui::SameLine();
+	ImGui::RadioButton("TAA", &_RequestedMode, E_ANTI_ALIASING::TAA);
+
+	const char *names[] = { "MSAA", "TAA" };
+	for (size_t i = 0; i < _GpuTime.size(); ++i) {
+		if (_GpuTime[i] < 0.0f || _Memory[i] < 0) {
+			ImGui::Text("%s: not measured", names[i]);
+		}
+		else {
+			ImGui::Text("%s: %.2f ms, %.1f MB", names[i], _GpuTime[i], _Memory[i] / (1024.0f * 1024.0f));
+		}
+	}
+
+	ImGui::End();
+}
+
+void AntiAliasingWidget::AddGpuTime(const int mode, const float time)
+{
+	// Smooth the value so that it stays readable
+	if (_GpuTime[mode] < 0.0f) {
+		_GpuTime[mode] = time;
+	}
+	else {
+		_GpuTime[mode] = _GpuTime[mode] * 0.95f + time * 0.05f;
+	}
+}
+
+void AntiAliasingWidget::SetMemoryUsage(const int mode, const unsigned long long bytes)
+{
+	_Memory[mode] = static_cast<long long>(bytes);
+}
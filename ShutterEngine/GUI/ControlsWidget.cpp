@@ -8,7 +8,7 @@ void ControlsWidget::Draw()
 		ImGui::SetNextWindowSize(ImVec2(270, 120));
 		ImGui::SetNextWindowPos(ImVec2(_Margin, _ViewportHeight - 120 - _Margin));
 		ImGui::Begin(std::string("Controls: " + _SceneTree->_SelectedObject->_Name).c_str(), nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
-		ImGui::DragFloat3("Position", &_SceneTree->_SelectedObject->_Position[0], 0.1f);
+		bool moved = ImGui::DragFloat3("Position", &_SceneTree->_SelectedObject->_Position[0], 0.1f);
 		
 		if (Light* light = dynamic_cast<Light*>(_SceneTree->_SelectedObject)) {
 			ImGui::ColorEdit3("color", &light->_Colour[0]);
@@ -21,8 +21,12 @@ void ControlsWidget::Draw()
 		}
 
 		if (Object* object = dynamic_cast<Object*>(_SceneTree->_SelectedObject)) {
-			ImGui::DragFloat3("Rotation", &object->_Rotation[0], 0.1f);
-			ImGui::DragFloat3("Scale", &object->_Scale[0], 0.1f);
+			moved |= ImGui::DragFloat3("Rotation", &object->_Rotation[0], 0.1f);
+			moved |= ImGui::DragFloat3("Scale", &object->_Scale[0], 0.1f);
+
+			if (moved) {
+				object->MarkDirty();
+			}
 		}
 		ImGui::End();
 	}
@@ -14,7 +14,6 @@ void GUI::Init(Device *device, GLFWwindow *window, const vk::SurfaceKHR & surfac
 
 	CreateDescriptorPool();
 	CreateRenderPass();
-	CreateCommandBuffers(cmdPool);
 
 	windowSize = screenSize;
 
@@ -42,20 +41,23 @@ void GUI::Init(Device *device, GLFWwindow *window, const vk::SurfaceKHR & surfac
 	}
 
 	controls._SceneTree = &tree;
+	memory._Allocator = &_Device->GetAllocator();
 
 }
 
-void GUI::Render(const size_t frameId, const std::vector<vk::Framebuffer> &fb, std::vector<vk::Fence> &fence, std::vector<vk::Fence> &frameFence, std::vector<vk::Semaphore> &semaphore, Scene *scene)
+void GUI::Render(const vk::CommandBuffer &cmdBuffer, const vk::Framebuffer &fb)
 {
-
-	_Device->GetDevice().waitForFences(fence[frameId], VK_TRUE, std::numeric_limits<uint64_t>::max());
-	_Device->GetDevice().resetFences(fence[frameId]);
+	if (!_Visible) {
+		return;
+	}
 
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 
 	perf.Draw();
+	aa.Draw();
+	memory.Draw();
 	tree.Draw();
 	tree._ViewportWidth = windowSize.width;
 	controls.Draw();
@@ -66,40 +68,24 @@ void GUI::Render(const size_t frameId, const std::vector<vk::Framebuffer> &fb, s
 
 	std::array<vk::ClearValue, 1> clearValues;
 	clearValues[0] = vk::ClearColorValue(std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f });
-	
-	_CommandBuffers[frameId].begin({ vk::CommandBufferUsageFlagBits::eSimultaneousUse });
-	_Device->StartMarker(_CommandBuffers[frameId], "GUI");
-	_CommandBuffers[frameId].beginRenderPass(
+
+	_Device->StartMarker(cmdBuffer, "GUI");
+	cmdBuffer.beginRenderPass(
 		vk::RenderPassBeginInfo(
 			_RenderPass,
-			fb[frameId],
+			fb,
 			{ {0,0}, {windowSize.width, windowSize.height} },
 			1,
 			clearValues.data()
 		),
 		vk::SubpassContents::eInline
 	);
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), VkCommandBuffer(_CommandBuffers[frameId]));
-	_CommandBuffers[frameId].endRenderPass();
-	_Device->EndMarker(_CommandBuffers[frameId]);
-	_CommandBuffers[frameId].end();
-
-	_Device->GetQueue(E_QUEUE_TYPE::GRAPHICS).VulkanQueue.submit(
-		{
-			vk::SubmitInfo(
-				0,
-				nullptr,
-				&vk::PipelineStageFlags(vk::PipelineStageFlagBits::eColorAttachmentOutput),
-				1,
-				&_CommandBuffers[frameId],
-				1,
-				&semaphore[frameId]
-			)
-		},
-		frameFence[frameId]
-	);
-
 
+	// Recorded every frame, even when nothing changed: the frame command buffer is recorded anew and the
+	// backend moves to the next of its vertex and index buffers on each call, so no draw can be kept
+	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), VkCommandBuffer(cmdBuffer));
+	cmdBuffer.endRenderPass();
+	_Device->EndMarker(cmdBuffer);
 }
 
 void GUI::CreateRenderPass()
@@ -112,7 +98,7 @@ void GUI::CreateRenderPass()
 		vk::AttachmentStoreOp::eStore,
 		vk::AttachmentLoadOp::eDontCare,
 		vk::AttachmentStoreOp::eDontCare,
-		vk::ImageLayout::eUndefined,
+		vk::ImageLayout::ePresentSrcKHR,
 		vk::ImageLayout::ePresentSrcKHR
 	);
 
@@ -147,8 +133,8 @@ void GUI::CreateRenderPass()
 			0,
 			vk::PipelineStageFlagBits::eColorAttachmentOutput,
 			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			{},
-			vk::AccessFlagBits::eColorAttachmentWrite
+			vk::AccessFlagBits::eColorAttachmentWrite,
+			vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
 		)
 	));
 }
@@ -170,8 +156,3 @@ void GUI::CreateDescriptorPool()
 
 	_DescriptorPool = _Device->GetDevice().createDescriptorPool(vk::DescriptorPoolCreateInfo({}, 2, poolSize.size(), poolSize.data()));
 }
-
-void GUI::CreateCommandBuffers(const vk::CommandPool &_CommandPool)
-{
-	_CommandBuffers = _Device->GetDevice().allocateCommandBuffers(vk::CommandBufferAllocateInfo(_CommandPool, vk::CommandBufferLevel::ePrimary, 2));
-}
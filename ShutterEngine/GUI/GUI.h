@@ -20,22 +20,25 @@ public:
 		const vk::CommandPool &cmdPool
 	);
 
-	void Render(const size_t frameId, const std::vector<vk::Framebuffer> &fb, std::vector<vk::Fence> &fence, std::vector<vk::Fence> &frameFence, std::vector<vk::Semaphore> &semaphore, Scene *scene);
+	// Record the UI pass in the frame command buffer, after the scene has been rendered
+	void Render(const vk::CommandBuffer &cmdBuffer, const vk::Framebuffer &fb);
 	vk::RenderPass _RenderPass;
 
+	bool _Visible = true;
+
 	PerformanceWidget perf;
 	SceneTreeWidget tree;
 	ControlsWidget controls;
+	AntiAliasingWidget aa;
+	MemoryWidget memory;
 
 	vk::Extent2D windowSize;
 
 private:
 	void CreateRenderPass();
 	void CreateDescriptorPool();
-	void CreateCommandBuffers(const vk::CommandPool &_CommandPool);
 
 	Device * _Device;
-	std::vector<vk::CommandBuffer> _CommandBuffers;
 
 	vk::DescriptorPool _DescriptorPool;
 
@@ -0,0 +1,35 @@
+#include "Widgets.h"
+#include "Renderer/Allocator.h"
+#include <fstream>
+
+void MemoryWidget::Draw()
+{
+	const float MB = 1024.0f * 1024.0f;
+
+	ImGui::SetNextWindowPos(ImVec2(_Margin, 195 + 3 * _Margin));
+	ImGui::Begin("Memory", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse);
+
+	// Usage against what the driver lets us have, per heap
+	std::vector<MemoryHeapBudget> budgets = _Allocator->GetHeapBudgets();
+	for (size_t i = 0; i < budgets.size(); ++i) {
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "%.0f / %.0f MB", budgets[i].Usage / MB, budgets[i].Budget / MB);
+
+		ImGui::Text("Heap %u (%s)", static_cast<unsigned int>(i), budgets[i].DeviceLocal ? "device" : "host");
+		ImGui::ProgressBar(budgets[i].Budget > 0 ? float(budgets[i].Usage) / float(budgets[i].Budget) : 0.0f, ImVec2(200, 0), overlay);
+	}
+
+	ImGui::Separator();
+
+	std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> categories = _Allocator->GetTracker().GetCategoryUsage();
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		ImGui::Text("%s: %.1f MB", MemoryTracker::GetCategoryName(static_cast<E_MEMORY_CATEGORY>(i)), categories[i] / MB);
+	}
+
+	if (ImGui::Button("Dump report")) {
+		std::ofstream file(_ReportPath);
+		_Allocator->WriteReport(file);
+	}
+
+	ImGui::End();
+}
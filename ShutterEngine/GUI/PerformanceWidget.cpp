@@ -2,11 +2,12 @@
 
 void PerformanceWidget::Draw()
 {
-	ImGui::SetNextWindowSize(ImVec2(120, 70));
+	ImGui::SetNextWindowSize(ImVec2(150, 85));
 	ImGui::SetNextWindowPos(ImVec2(_Margin, _Margin));
 	ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoTitleBar);
 	ImGui::Text("%u FPS", static_cast<unsigned int>(1000.f / _LastFrameTime));
 	ImGui::Text("%.2f ms", _LastFrameTime);
+	ImGui::Text("%llu triangles", _Triangles);
 	ImGui::PushItemWidth(-1);
 	ImGui::PlotLines("", _Buffer.data(), _Buffer.size(), 0, nullptr, 16.0f, 60.0f);
 	ImGui::End();
@@ -18,3 +19,8 @@ void PerformanceWidget::AddValue(const float frameTime)
 	_Buffer[_BufferOffset] = frameTime;
 	_BufferOffset = (_BufferOffset + 1) % _Buffer.size();
 }
+
+void PerformanceWidget::SetTriangles(const unsigned long long triangles)
+{
+	_Triangles = triangles;
+}
@@ -20,8 +20,10 @@ public:
 	void Draw() override;
 
 	void AddValue(const float frameTime);
+	void SetTriangles(const unsigned long long triangles);
 
 	float _LastFrameTime = .0f;
+	unsigned long long _Triangles = 0;
 	std::array<float, 40> _Buffer = { .0f };
 	int _BufferOffset = 0;
 };
@@ -46,4 +48,31 @@ public:
 	float range;
 
 	SceneTreeWidget *_SceneTree;
+};
+
+class AntiAliasingWidget : public Widget {
+public:
+	void Draw() override;
+
+	void AddGpuTime(const int mode, const float time);
+	void SetMemoryUsage(const int mode, const unsigned long long bytes);
+
+	// Mode selected in the UI, as a E_ANTI_ALIASING value
+	int _RequestedMode = 0;
+
+	// Smoothed GPU time (ms) and render target memory (bytes) for each mode, negative until measured
+	std::array<float, 2> _GpuTime = { -1.0f, -1.0f };
+	std::array<long long, 2> _Memory = { -1, -1 };
+};
+
+class Allocator;
+
+class MemoryWidget : public Widget {
+public:
+	void Draw() override;
+
+	Allocator *_Allocator = nullptr;
+
+	// Where the per asset report is written from the UI
+	std::string _ReportPath = "memory_report.txt";
 };
\ No newline at end of file
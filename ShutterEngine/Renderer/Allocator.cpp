@@ -0,0 +1,364 @@
+#include "Allocator.h"
+#include <algorithm>
+#include <iomanip>
+
+void Allocator::Init(const vk::PhysicalDevice &physicalDevice, const vk::Device &device, const bool supportBudget, const vk::DeviceSize blockSize)
+{
+	_PhysicalDevice = physicalDevice;
+	_Device = device;
+	_SupportBudget = supportBudget;
+	_MemoryProperties = physicalDevice.getMemoryProperties();
+	_NonCoherentAtomSize = physicalDevice.getProperties().limits.nonCoherentAtomSize;
+	_BlockSize = blockSize;
+}
+
+void Allocator::Clean()
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	for (auto &block : _Blocks) {
+		if (block) {
+			_Device.freeMemory(block->Memory);
+		}
+	}
+	_Blocks.clear();
+
+	for (auto &memory : _Dedicated) {
+		_Device.freeMemory(memory);
+	}
+	_Dedicated.clear();
+	_DedicatedCount = 0;
+	_DedicatedBytes = 0;
+
+	_HeapBytes = {};
+}
+
+Allocation Allocator::Allocate(const vk::MemoryRequirements &requirements, const vk::MemoryPropertyFlags properties, const E_ALLOCATION_TYPE type, const E_MEMORY_CATEGORY category)
+{
+	Allocation allocation = AllocateUntracked(requirements, properties, type);
+	allocation.TrackingId = _Tracker.Add(category, allocation.Size, _MemoryProperties.memoryTypes[allocation.MemoryType].heapIndex);
+
+	return allocation;
+}
+
+Allocation Allocator::AllocateUntracked(const vk::MemoryRequirements &requirements, const vk::MemoryPropertyFlags properties, const E_ALLOCATION_TYPE type)
+{
+	uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+
+	// Flushes of non coherent memory work on whole atoms, keep allocations from sharing one
+	vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+	vk::DeviceSize size = requirements.size;
+	vk::MemoryPropertyFlags typeFlags = _MemoryProperties.memoryTypes[memoryType].propertyFlags;
+	if ((typeFlags & vk::MemoryPropertyFlagBits::eHostVisible) && !(typeFlags & vk::MemoryPropertyFlagBits::eHostCoherent)) {
+		alignment = std::max(alignment, _NonCoherentAtomSize);
+		size = (size + _NonCoherentAtomSize - 1) / _NonCoherentAtomSize * _NonCoherentAtomSize;
+	}
+
+	vk::DeviceSize blockSize = GetBlockSize(memoryType);
+	if (type == E_ALLOCATION_TYPE::DEDICATED || size > blockSize / 2) {
+		return AllocateDedicated(size, memoryType);
+	}
+
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	Allocation allocation;
+	for (auto &block : _Blocks) {
+		if (block && block->MemoryType == memoryType && block->Type == type) {
+			if (AllocateFromBlock(*block, size, alignment, allocation)) {
+				return allocation;
+			}
+		}
+	}
+
+	// No space left, create a new block for this type
+	std::unique_ptr<MemoryBlock> block(new MemoryBlock());
+	block->Memory = AllocateMemory(blockSize, memoryType);
+	block->MemoryType = memoryType;
+	block->Type = type;
+	block->Size = blockSize;
+	block->Mapped = Map(block->Memory, memoryType);
+	if (type != E_ALLOCATION_TYPE::STAGING) {
+		block->Metadata = Tlsf(blockSize);
+	}
+
+	// Empty blocks are kept around, the index of a block never changes until Clean
+	_Blocks.push_back(std::move(block));
+
+	if (!AllocateFromBlock(*_Blocks.back(), size, alignment, allocation)) {
+		throw std::runtime_error("Allocation does not fit in a new memory block.");
+	}
+
+	return allocation;
+}
+
+void Allocator::Free(Allocation &allocation)
+{
+	if (!allocation) {
+		return;
+	}
+
+	_Tracker.Remove(allocation.TrackingId);
+
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	if (allocation.Block < 0) {
+		_Dedicated.erase(std::find(_Dedicated.begin(), _Dedicated.end(), allocation.Memory));
+		_Device.freeMemory(allocation.Memory);
+		--_DedicatedCount;
+		_DedicatedBytes -= allocation.Size;
+		_HeapBytes[_MemoryProperties.memoryTypes[allocation.MemoryType].heapIndex] -= allocation.Size;
+	}
+	else {
+		MemoryBlock &block = *_Blocks[allocation.Block];
+
+		if (block.Type == E_ALLOCATION_TYPE::STAGING) {
+			// Rewind once everything in the block has been released
+			if (--block.LinearCount == 0) {
+				block.Head = 0;
+			}
+		}
+		else {
+			block.Metadata.Free(allocation.Node);
+		}
+	}
+
+	allocation = Allocation();
+}
+
+void Allocator::SetAsset(const Allocation &allocation, const std::string &asset)
+{
+	_Tracker.SetAsset(allocation.TrackingId, asset);
+}
+
+void Allocator::Flush(const Allocation &allocation, const vk::DeviceSize offset, const vk::DeviceSize size) const
+{
+	if (_MemoryProperties.memoryTypes[allocation.MemoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) {
+		return;
+	}
+
+	// Allocations are atom aligned and sized, so widening the range never reaches a neighbour
+	vk::DeviceSize start = offset / _NonCoherentAtomSize * _NonCoherentAtomSize;
+	vk::DeviceSize end = std::min((offset + size + _NonCoherentAtomSize - 1) / _NonCoherentAtomSize * _NonCoherentAtomSize, allocation.Size);
+
+	vk::MappedMemoryRange range(allocation.Memory, allocation.Offset + start, end - start);
+	_Device.flushMappedMemoryRanges(range);
+}
+
+uint32_t Allocator::FindMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < _MemoryProperties.memoryTypeCount; i++) {
+		if ((typeFilter & (1 << i)) && (_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("failed to find suitable memory type!");
+}
+
+AllocatorStats Allocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	AllocatorStats stats;
+	stats.DedicatedCount = _DedicatedCount;
+	stats.DedicatedBytes = _DedicatedBytes;
+	stats.AllocationCount = _DedicatedCount;
+
+	vk::DeviceSize freeBytes = 0;
+	vk::DeviceSize largestFreeBytes = 0;
+
+	for (const auto &block : _Blocks) {
+		if (!block) {
+			continue;
+		}
+
+		++stats.BlockCount;
+		stats.BlockBytes += block->Size;
+
+		if (block->Type == E_ALLOCATION_TYPE::STAGING) {
+			stats.UsedBytes += block->Head;
+			stats.AllocationCount += block->LinearCount;
+		}
+		else {
+			stats.UsedBytes += block->Metadata.GetUsed();
+			stats.AllocationCount += block->Metadata.GetAllocationCount();
+
+			freeBytes += block->Size - block->Metadata.GetUsed();
+			largestFreeBytes += block->Metadata.GetLargestFree();
+		}
+	}
+
+	stats.DeviceMemoryCount = stats.BlockCount + stats.DedicatedCount;
+	stats.Fragmentation = freeBytes > 0 ? 1.0f - float(largestFreeBytes) / float(freeBytes) : 0.0f;
+
+	return stats;
+}
+
+std::vector<MemoryBlockStats> Allocator::GetBlockStats() const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	std::vector<MemoryBlockStats> stats;
+	for (const auto &block : _Blocks) {
+		if (!block) {
+			continue;
+		}
+
+		if (block->Type == E_ALLOCATION_TYPE::STAGING) {
+			stats.push_back({ block->MemoryType, block->Type, block->LinearCount, block->Size, block->Head, block->Size - block->Head });
+		}
+		else {
+			stats.push_back({
+				block->MemoryType,
+				block->Type,
+				block->Metadata.GetAllocationCount(),
+				block->Size,
+				block->Metadata.GetUsed(),
+				block->Metadata.GetLargestFree()
+			});
+		}
+	}
+
+	return stats;
+}
+
+std::vector<MemoryHeapBudget> Allocator::GetHeapBudgets() const
+{
+	std::vector<MemoryHeapBudget> budgets(_MemoryProperties.memoryHeapCount);
+
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		for (uint32_t i = 0; i < _MemoryProperties.memoryHeapCount; ++i) {
+			budgets[i].Size = _MemoryProperties.memoryHeaps[i].size;
+			budgets[i].DeviceLocal = bool(_MemoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+			budgets[i].Budget = budgets[i].Size;
+			budgets[i].Usage = _HeapBytes[i];
+			budgets[i].Tracked = _Tracker.GetHeapUsage(i);
+		}
+	}
+
+#ifdef VK_EXT_memory_budget
+	// The driver knows about the other processes and its own allocations
+	if (_SupportBudget) {
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budgetProperties;
+
+		vkGetPhysicalDeviceMemoryProperties2(VkPhysicalDevice(_PhysicalDevice), &properties);
+
+		for (uint32_t i = 0; i < _MemoryProperties.memoryHeapCount; ++i) {
+			budgets[i].Budget = budgetProperties.heapBudget[i];
+			budgets[i].Usage = budgetProperties.heapUsage[i];
+		}
+	}
+#endif
+
+	return budgets;
+}
+
+void Allocator::WriteReport(std::ostream &out) const
+{
+	const float MB = 1024.0f * 1024.0f;
+
+	out << std::fixed << std::setprecision(2);
+	out << "Heaps" << (_SupportBudget ? "" : " (no VK_EXT_memory_budget, usage is the allocator only)") << "\n";
+
+	std::vector<MemoryHeapBudget> budgets = GetHeapBudgets();
+	for (size_t i = 0; i < budgets.size(); ++i) {
+		out << "  " << i << (budgets[i].DeviceLocal ? " device " : " host   ")
+			<< budgets[i].Usage / MB << " / " << budgets[i].Budget / MB << " MB used, "
+			<< budgets[i].Tracked / MB << " MB in resources, "
+			<< budgets[i].Size / MB << " MB heap\n";
+	}
+
+	AllocatorStats stats = GetStats();
+	out << "  " << stats.DeviceMemoryCount << " device memory allocations, "
+		<< stats.AllocationCount << " resources, "
+		<< stats.Fragmentation * 100.0f << "% fragmentation\n\n";
+
+	_Tracker.WriteReport(out);
+}
+
+bool Allocator::AllocateFromBlock(MemoryBlock &block, const vk::DeviceSize size, const vk::DeviceSize alignment, Allocation &allocation)
+{
+	vk::DeviceSize offset;
+	uint32_t node = Tlsf::INVALID_NODE;
+
+	if (block.Type == E_ALLOCATION_TYPE::STAGING) {
+		offset = (block.Head + alignment - 1) / alignment * alignment;
+		if (offset + size > block.Size) {
+			return false;
+		}
+
+		block.Head = offset + size;
+		++block.LinearCount;
+	}
+	else {
+		node = block.Metadata.Allocate(size, alignment, offset);
+		if (node == Tlsf::INVALID_NODE) {
+			return false;
+		}
+	}
+
+	allocation.Memory = block.Memory;
+	allocation.Offset = offset;
+	allocation.Size = size;
+	allocation.MemoryType = block.MemoryType;
+	allocation.Node = node;
+	allocation.Mapped = block.Mapped ? static_cast<char*>(block.Mapped) + offset : nullptr;
+
+	for (size_t i = 0; i < _Blocks.size(); ++i) {
+		if (_Blocks[i].get() == &block) {
+			allocation.Block = static_cast<int32_t>(i);
+			break;
+		}
+	}
+
+	return true;
+}
+
+Allocation Allocator::AllocateDedicated(const vk::DeviceSize size, const uint32_t memoryType)
+{
+	Allocation allocation;
+	allocation.Memory = _Device.allocateMemory(vk::MemoryAllocateInfo(size, memoryType));
+	allocation.Size = size;
+	allocation.MemoryType = memoryType;
+	allocation.Mapped = Map(allocation.Memory, memoryType);
+
+	std::lock_guard<std::mutex> lock(_Mutex);
+	_Dedicated.push_back(allocation.Memory);
+	++_DedicatedCount;
+	_DedicatedBytes += size;
+	_HeapBytes[_MemoryProperties.memoryTypes[memoryType].heapIndex] += size;
+
+	return allocation;
+}
+
+vk::DeviceMemory Allocator::AllocateMemory(const vk::DeviceSize size, const uint32_t memoryType)
+{
+	// Called with the lock held, only for blocks
+	vk::DeviceMemory memory = _Device.allocateMemory(vk::MemoryAllocateInfo(size, memoryType));
+	_HeapBytes[_MemoryProperties.memoryTypes[memoryType].heapIndex] += size;
+
+	return memory;
+}
+
+vk::DeviceSize Allocator::GetBlockSize(const uint32_t memoryType) const
+{
+	// Small heaps (e.g. host visible device memory) should not be taken by a single block
+	vk::DeviceSize heapSize = _MemoryProperties.memoryHeaps[_MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+
+	return std::min(_BlockSize, heapSize / 8);
+}
+
+void *Allocator::Map(const vk::DeviceMemory &memory, const uint32_t memoryType) const
+{
+	if (_MemoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+		return _Device.mapMemory(memory, 0, VK_WHOLE_SIZE, {});
+	}
+
+	return nullptr;
+}
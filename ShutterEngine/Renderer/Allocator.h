@@ -0,0 +1,159 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <array>
+#include <ostream>
+#include <mutex>
+#include <vulkan/vulkan.hpp>
+
+#include "Tlsf.h"
+#include "MemoryTracker.h"
+
+enum E_ALLOCATION_TYPE
+{
+	// Buffers, sub-allocated from shared blocks
+	LINEAR,
+	// Optimal tiling images, kept in their own blocks so bufferImageGranularity never applies
+	OPTIMAL,
+	// Short lived upload buffers, allocated linearly and recycled once they are all freed
+	STAGING,
+	// Large render targets, getting their own device memory
+	DEDICATED
+};
+
+struct Allocation {
+	vk::DeviceMemory Memory;
+	vk::DeviceSize Offset = 0;
+	vk::DeviceSize Size = 0;
+	uint32_t MemoryType = 0;
+
+	// Start of the allocation in the persistent mapping, null if not host visible
+	void *Mapped = nullptr;
+
+	// Owning block in the allocator, -1 for dedicated allocations
+	int32_t Block = -1;
+	uint32_t Node = Tlsf::INVALID_NODE;
+
+	// Record in the memory tracker
+	uint32_t TrackingId = 0;
+
+	explicit operator bool() const {
+		return bool(Memory);
+	}
+};
+
+struct AllocatorStats {
+	// Number of live vkAllocateMemory
+	uint32_t DeviceMemoryCount = 0;
+	uint32_t BlockCount = 0;
+	uint32_t DedicatedCount = 0;
+	uint32_t AllocationCount = 0;
+
+	vk::DeviceSize BlockBytes = 0;
+	vk::DeviceSize UsedBytes = 0;
+	vk::DeviceSize DedicatedBytes = 0;
+
+	// 0 when the free space of the blocks is contiguous, close to 1 when scattered
+	float Fragmentation = 0.0f;
+};
+
+struct MemoryBlockStats {
+	uint32_t MemoryType;
+	E_ALLOCATION_TYPE Type;
+	uint32_t AllocationCount;
+
+	vk::DeviceSize Size;
+	vk::DeviceSize Used;
+	vk::DeviceSize LargestFree;
+};
+
+struct MemoryHeapBudget {
+	vk::DeviceSize Size;
+	bool DeviceLocal;
+
+	// What the driver lets the process use and what it currently uses, from VK_EXT_memory_budget.
+	// Without the extension, the size of the heap and what the allocator got from it.
+	vk::DeviceSize Budget;
+	vk::DeviceSize Usage;
+
+	// Bytes handed to buffers and images
+	vk::DeviceSize Tracked;
+};
+
+// Sub-allocates device memory out of large per memory type blocks
+class Allocator {
+public:
+	Allocator() {}
+
+	void Init(const vk::PhysicalDevice &physicalDevice, const vk::Device &device, const bool supportBudget = false, const vk::DeviceSize blockSize = 64 * 1024 * 1024);
+	void Clean();
+
+	Allocation Allocate(const vk::MemoryRequirements &requirements, const vk::MemoryPropertyFlags properties, const E_ALLOCATION_TYPE type, const E_MEMORY_CATEGORY category = E_MEMORY_CATEGORY::OTHER);
+	void Free(Allocation &allocation);
+
+	// Name the asset owning the allocation in the memory report
+	void SetAsset(const Allocation &allocation, const std::string &asset);
+
+	// Make host writes visible to the device, only does something on non coherent memory
+	void Flush(const Allocation &allocation, const vk::DeviceSize offset, const vk::DeviceSize size) const;
+
+	uint32_t FindMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+
+	AllocatorStats GetStats() const;
+	std::vector<MemoryBlockStats> GetBlockStats() const;
+	std::vector<MemoryHeapBudget> GetHeapBudgets() const;
+
+	// Budget of each heap followed by the memory used by each asset
+	void WriteReport(std::ostream &out) const;
+
+	const MemoryTracker &GetTracker() const {
+		return _Tracker;
+	}
+
+private:
+	struct MemoryBlock {
+		vk::DeviceMemory Memory;
+		uint32_t MemoryType;
+		E_ALLOCATION_TYPE Type;
+		vk::DeviceSize Size;
+
+		// Host visible blocks stay mapped for their whole life
+		void *Mapped = nullptr;
+
+		// Used by the sub-allocated blocks
+		Tlsf Metadata;
+
+		// Used by the staging blocks
+		vk::DeviceSize Head = 0;
+		uint32_t LinearCount = 0;
+	};
+
+	Allocation AllocateUntracked(const vk::MemoryRequirements &requirements, const vk::MemoryPropertyFlags properties, const E_ALLOCATION_TYPE type);
+	bool AllocateFromBlock(MemoryBlock &block, const vk::DeviceSize size, const vk::DeviceSize alignment, Allocation &allocation);
+	Allocation AllocateDedicated(const vk::DeviceSize size, const uint32_t memoryType);
+	vk::DeviceMemory AllocateMemory(const vk::DeviceSize size, const uint32_t memoryType);
+	vk::DeviceSize GetBlockSize(const uint32_t memoryType) const;
+	void *Map(const vk::DeviceMemory &memory, const uint32_t memoryType) const;
+
+private:
+	vk::PhysicalDevice _PhysicalDevice;
+	vk::Device _Device;
+	vk::PhysicalDeviceMemoryProperties _MemoryProperties;
+	bool _SupportBudget = false;
+	vk::DeviceSize _NonCoherentAtomSize;
+	vk::DeviceSize _BlockSize;
+
+	std::vector<std::unique_ptr<MemoryBlock>> _Blocks;
+
+	// Live dedicated allocations, freed by Clean if their owner did not
+	std::vector<vk::DeviceMemory> _Dedicated;
+	uint32_t _DedicatedCount = 0;
+	vk::DeviceSize _DedicatedBytes = 0;
+
+	// Device memory allocated from each heap, blocks included
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> _HeapBytes = {};
+
+	MemoryTracker _Tracker;
+
+	mutable std::mutex _Mutex;
+};
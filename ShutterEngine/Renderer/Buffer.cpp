@@ -2,44 +2,81 @@
 
 #include "Buffer.h"
 #include "Helpers.h"
-#include <iostream>
 
 
 Buffer::Buffer(
 	Device *device,
-	const vk::BufferUsageFlagBits usage,
+	const vk::BufferUsageFlags usage,
 	const size_t size,
 	const vk::SharingMode sharingMode,
-	vk::MemoryPropertyFlags memoryFlags
+	vk::MemoryPropertyFlags memoryFlags,
+	const E_ALLOCATION_TYPE allocationType
 ):
-	_Device(device)
+	_Device(device),
+	_Size(size)
 {
-	std::cerr << "Allocating: " << size << std::endl;
-
 	_Buffer = _Device->GetDevice().createBuffer(vk::BufferCreateInfo( {}, size, usage, sharingMode ));
 
 	vk::MemoryRequirements memoryRequirements = _Device->GetDevice().getBufferMemoryRequirements(_Buffer);
 
-	vk::MemoryAllocateInfo memoryInfo;
-	memoryInfo.allocationSize = memoryRequirements.size;
-	memoryInfo.memoryTypeIndex = findMemoryType(*_Device, memoryRequirements.memoryTypeBits, memoryFlags);
+	// The frame ring also holds instance data as vertices, it still counts as uniform data
+	E_MEMORY_CATEGORY category = E_MEMORY_CATEGORY::OTHER;
+	if (usage & vk::BufferUsageFlagBits::eUniformBuffer) {
+		category = E_MEMORY_CATEGORY::UNIFORM;
+	}
+	else if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer)) {
+		category = E_MEMORY_CATEGORY::MESH;
+	}
+	else if (allocationType == E_ALLOCATION_TYPE::STAGING || ((usage & vk::BufferUsageFlagBits::eTransferSrc) && (memoryFlags & vk::MemoryPropertyFlagBits::eHostVisible))) {
+		category = E_MEMORY_CATEGORY::STAGING;
+	}
+
+	_Allocation = _Device->GetAllocator().Allocate(memoryRequirements, memoryFlags, allocationType, category);
+	_Device->GetDevice().bindBufferMemory(_Buffer, _Allocation.Memory, _Allocation.Offset);
+}
 
-	_Memory = _Device->GetDevice().allocateMemory(memoryInfo);
-	_Device->GetDevice().bindBufferMemory(_Buffer, _Memory, 0);
+Buffer::Buffer(Buffer &&buffer) noexcept :
+	_Device(buffer._Device),
+	_Buffer(buffer._Buffer),
+	_Allocation(buffer._Allocation),
+	_Size(buffer._Size)
+{
+	buffer._Buffer = nullptr;
+	buffer._Allocation = Allocation();
+	buffer._Size = 0;
 }
 
-void Buffer::Copy(void * data, const size_t size)
+Buffer &Buffer::operator=(Buffer &&buffer) noexcept
 {
-	_Size = size;
-	void *deviceData;
-	deviceData = _Device->GetDevice().mapMemory(_Memory, 0, size, {});
-	std::memcpy(deviceData, data, size);
+	if (this != &buffer) {
+		Clean();
+
+		_Device = buffer._Device;
+		_Buffer = buffer._Buffer;
+		_Allocation = buffer._Allocation;
+		_Size = buffer._Size;
 
-	std::array<vk::MappedMemoryRange, 1> memoryRanges;
-	memoryRanges[0] = vk::MappedMemoryRange(_Memory, 0, VK_WHOLE_SIZE);
-	_Device->GetDevice().flushMappedMemoryRanges(memoryRanges);
+		buffer._Buffer = nullptr;
+		buffer._Allocation = Allocation();
+		buffer._Size = 0;
+	}
 
-	_Device->GetDevice().unmapMemory(_Memory);
+	return *this;
+}
+
+void Buffer::Copy(const void * data, const size_t size, const size_t offset)
+{
+	if (!_Allocation.Mapped) {
+		throw std::runtime_error("Cannot copy into a buffer which is not host visible.");
+	}
+
+	std::memcpy(static_cast<char*>(_Allocation.Mapped) + offset, data, size);
+	Flush(offset, size);
+}
+
+void Buffer::Flush(const size_t offset, const size_t size) const
+{
+	_Device->GetAllocator().Flush(_Allocation, offset, size);
 }
 
 void Buffer::Transfer(const Buffer & dstBuffer, const vk::CommandPool &cmdPool)
@@ -52,13 +89,29 @@ void Buffer::Transfer(const Buffer & dstBuffer, const vk::CommandPool &cmdPool)
 	EndSingleUseCommandBuffer(cmd, *_Device, cmdPool);
 }
 
+void Buffer::SetAsset(const std::string &asset)
+{
+	_Device->GetAllocator().SetAsset(_Allocation, asset);
+}
+
 void Buffer::Clean()
 {
-	if (_Memory) {
-		_Device->GetDevice().freeMemory(_Memory);
+	if (!_Buffer && !_Allocation) {
+		return;
 	}
 
-	if (_Buffer) {
-		_Device->GetDevice().destroyBuffer(_Buffer);
-	}
+	vk::Device device = _Device->GetDevice();
+	Allocator *allocator = &_Device->GetAllocator();
+	vk::Buffer buffer = _Buffer;
+	Allocation allocation = _Allocation;
+
+	_Device->GetDeletionQueue().Push([device, allocator, buffer, allocation]() mutable {
+		if (buffer) {
+			device.destroyBuffer(buffer);
+		}
+		allocator->Free(allocation);
+	});
+
+	_Buffer = nullptr;
+	_Allocation = Allocation();
 }
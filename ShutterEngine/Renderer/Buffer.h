@@ -9,50 +9,55 @@ public:
 	Buffer(){}
 	explicit Buffer(
 		Device *device,
-		const vk::BufferUsageFlagBits usage,
+		const vk::BufferUsageFlags usage,
 		const size_t size,
 		const vk::SharingMode sharingMode = vk::SharingMode::eExclusive,
-		vk::MemoryPropertyFlags memoryFlags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		vk::MemoryPropertyFlags memoryFlags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		const E_ALLOCATION_TYPE allocationType = E_ALLOCATION_TYPE::LINEAR
 	);
-	//Buffer(const Buffer& buffer) :
-	//	_Device(buffer._Device),
-	//	_Buffer(buffer._Buffer),
-	//	_Memory(buffer._Memory)
-	//{
 
-	//}
-
-	//Buffer& operator=(Buffer buffer)
-	//{
-	//	_Device = buffer._Device;
-	//	std::swap(_Buffer, buffer._Buffer);
-	//	std::swap(_Memory, buffer._Memory);
-
-	//	return *this;
-	//}
+	// Owns the buffer and its memory, only moves
+	Buffer(const Buffer &buffer) = delete;
+	Buffer &operator=(const Buffer &buffer) = delete;
+	Buffer(Buffer &&buffer) noexcept;
+	Buffer &operator=(Buffer &&buffer) noexcept;
 
 	~Buffer() {
-		//Clean();
+		Clean();
 	}
 
-	void Copy(void *data, const size_t size);
+	// Write into the persistent mapping and flush the written range
+	void Copy(const void *data, const size_t size, const size_t offset = 0);
+	void Flush(const size_t offset, const size_t size) const;
 	void Transfer(const Buffer &dstBuffer, const vk::CommandPool &cmdPool);
 
+	// Destroyed once the frames in flight are done with it
 	void Clean();
 
+	// Name the asset owning the buffer in the memory report
+	void SetAsset(const std::string &asset);
+
 
 	const vk::Buffer &GetBuffer() const {
 		return _Buffer;
 	}
 
 	const vk::DeviceMemory &GetMemory() const {
-		return _Memory;
+		return _Allocation.Memory;
+	}
+
+	const Allocation &GetAllocation() const {
+		return _Allocation;
+	}
+
+	void *GetMapped() const {
+		return _Allocation.Mapped;
 	}
 
 protected:
-	Device *_Device;
+	Device *_Device = nullptr;
 
 	vk::Buffer _Buffer;
-	vk::DeviceMemory _Memory;
-	size_t _Size;
+	Allocation _Allocation;
+	size_t _Size = 0;
 };
\ No newline at end of file
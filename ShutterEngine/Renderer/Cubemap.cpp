@@ -2,8 +2,8 @@
 #include "Engine/Mesh.h"
 #include "Helpers.h"
 
-Cubemap::Cubemap(Device * device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize) :
-	Material(device, scene, width, height, poolSize)
+Cubemap::Cubemap(Device * device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize, const E_VERTEX_LAYOUT vertexLayout, const bool positionOnly, const bool instanced) :
+	Material(device, scene, width, height, poolSize, vertexLayout, positionOnly, instanced)
 {
 	// Investigate impact
 	PopulateInfo(width, height);
@@ -7,7 +7,7 @@
 class Cubemap: public Material {
 public:
 	Cubemap(){}
-	Cubemap(Device *device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize);
+	Cubemap(Device *device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize, const E_VERTEX_LAYOUT vertexLayout = E_VERTEX_LAYOUT::STANDARD, const bool positionOnly = true, const bool instanced = false);
 protected:
 	void CreateRasterizationInfo() override;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "DeletionQueue.h"
+
+void DeletionQueue::Push(std::function<void()> &&deleter)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+	_Entries.push_back({ _Frame, std::move(deleter) });
+}
+
+void DeletionQueue::BeginFrame(const uint64_t frame, const uint64_t completedFrames)
+{
+	std::deque<Entry> ready;
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+		_Frame = frame;
+
+		// Entries are pushed in frame order, stop at the first one still in flight
+		while (!_Entries.empty() && _Entries.front().Frame < completedFrames) {
+			ready.push_back(std::move(_Entries.front()));
+			_Entries.pop_front();
+		}
+	}
+
+	for (auto &entry : ready) {
+		entry.Deleter();
+	}
+}
+
+void DeletionQueue::Flush()
+{
+	// Deleters can push new entries, keep going until nothing is left
+	while (true) {
+		std::deque<Entry> ready;
+		{
+			std::lock_guard<std::mutex> lock(_Mutex);
+			if (_Entries.empty()) {
+				return;
+			}
+			ready.swap(_Entries);
+		}
+
+		for (auto &entry : ready) {
+			entry.Deleter();
+		}
+	}
+}
+
+size_t DeletionQueue::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+	return _Entries.size();
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+// Holds the destruction of resources until the GPU is done with the frames that could use them
+class DeletionQueue {
+public:
+	DeletionQueue() {}
+
+	// Run the deleter once the frame being recorded has completed
+	void Push(std::function<void()> &&deleter);
+
+	// A new frame starts recording, every frame before completedFrames is done on the GPU
+	void BeginFrame(const uint64_t frame, const uint64_t completedFrames);
+
+	// Run everything left, the device has to be idle
+	void Flush();
+
+	size_t GetPendingCount() const;
+
+private:
+	struct Entry {
+		uint64_t Frame;
+		std::function<void()> Deleter;
+	};
+
+	std::deque<Entry> _Entries;
+	uint64_t _Frame = 0;
+
+	mutable std::mutex _Mutex;
+};
@@ -29,6 +29,21 @@ void Device::Init(DeviceRequestInfo& info, optional_surface surface)
 		info.RequiredExtensions.push_back(VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
 	}
 
+#ifdef VK_EXT_memory_budget
+	// Same for the memory budget, the allocator falls back to its own numbers without it
+	it = std::find_if(
+		_DeviceExtensions.begin(),
+		_DeviceExtensions.end(),
+		[](const vk::ExtensionProperties&  availableExtenion) {
+		return std::strcmp(availableExtenion.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+	}
+	);
+	if (it != _DeviceExtensions.end()) {
+		_SupportMemoryBudget = true;
+		info.RequiredExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+#endif
+
 	PickQueueFamilyIndex(info, surface);
 
 	std::vector<vk::DeviceQueueCreateInfo> deviceQueuesInfo;
@@ -37,12 +52,17 @@ void Device::Init(DeviceRequestInfo& info, optional_surface surface)
 		deviceQueuesInfo.push_back(vk::DeviceQueueCreateInfo{ {}, id, 1, &queuePrio });
 	}
 
-	vk::PhysicalDeviceFeatures deviceFeatures = {};
+	// Several meshlet commands per draw when supported, one draw per command otherwise
+	_EnabledFeatures = vk::PhysicalDeviceFeatures();
+	_EnabledFeatures.multiDrawIndirect = _PhysicalDeviceFeatures.multiDrawIndirect;
+
+	// Textures fall back to their RGBA8 source without it
+	_EnabledFeatures.textureCompressionBC = _PhysicalDeviceFeatures.textureCompressionBC;
 
 	vk::DeviceCreateInfo deviceInfo = {};
 	deviceInfo.pQueueCreateInfos = deviceQueuesInfo.data();
 	deviceInfo.queueCreateInfoCount = deviceQueuesInfo.size();
-	deviceInfo.pEnabledFeatures = &deviceFeatures;
+	deviceInfo.pEnabledFeatures = &_EnabledFeatures;
 	deviceInfo.enabledExtensionCount = info.RequiredExtensions.size();
 	deviceInfo.ppEnabledExtensionNames = info.RequiredExtensions.data();
 
@@ -53,6 +73,11 @@ void Device::Init(DeviceRequestInfo& info, optional_surface surface)
 		queue.second.VulkanQueue = _Device.getQueue(queue.second.Index, 0);
 	}
 
+	_Allocator = std::make_shared<Allocator>();
+	_Allocator->Init(_PhysicalDevice, _Device, _SupportMemoryBudget);
+
+	_DeletionQueue = std::make_shared<DeletionQueue>();
+
 	if (_SupportDebugMarkers) {
 		pfnCmdDebugMarkerBegin = (PFN_vkCmdDebugMarkerBeginEXT)_Device.getProcAddr("vkCmdDebugMarkerBeginEXT");
 		pfnCmdDebugMarkerEnd = (PFN_vkCmdDebugMarkerEndEXT)_Device.getProcAddr("vkCmdDebugMarkerEndEXT");
@@ -61,6 +86,14 @@ void Device::Init(DeviceRequestInfo& info, optional_surface surface)
 
 void Device::Clean()
 {
+	// Whatever is still waiting holds memory from the allocator
+	if (_DeletionQueue) {
+		_DeletionQueue->Flush();
+	}
+
+	if (_Allocator) {
+		_Allocator->Clean();
+	}
 	//_Device.destroy();
 }
 
@@ -120,6 +153,11 @@ const bool Device::IsSuitable(const DeviceRequestInfo& info, optional_surface su
 	return havePresentation && haveGraphics;
 }
 
+bool Device::SupportsSampledFormat(const vk::Format format) const
+{
+	return static_cast<bool>(_PhysicalDevice.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+}
+
 void Device::StartMarker(const vk::CommandBuffer & cmdBuffer, const std::string & name)
 {
 	if (_SupportDebugMarkers) {
@@ -154,6 +192,7 @@ void Device::PickQueueFamilyIndex(const DeviceRequestInfo& info, optional_surfac
 				_Queues.emplace(PRESENT, present);
 				break;
 			}
+			++i;
 		}
 	}
 
@@ -166,8 +205,22 @@ void Device::PickQueueFamilyIndex(const DeviceRequestInfo& info, optional_surfac
 				_Queues.emplace(GRAPHICS, present);
 				break;
 			}
+			++i;
+		}
+	}
+
+	// Transfer only families are backed by the copy engines, they run next to the graphics work
+	i = 0;
+	if (info.SupportAsyncTransfer) {
+		for (const auto &queueFamily : _QueueFamilyProperties) {
+			if ((queueFamily.queueFlags & vk::QueueFlagBits::eTransfer) &&
+				!(queueFamily.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+				Queue transfer = { i };
+				_Queues.emplace(TRANSFER, transfer);
+				break;
+			}
+			++i;
 		}
-		++i;
 	}
 }
 
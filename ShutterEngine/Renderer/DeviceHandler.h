@@ -3,21 +3,29 @@
 #include <set>
 #include <map>
 #include <optional>
+#include <memory>
 
 #include <vulkan/vulkan.hpp>
 
+#include "Allocator.h"
+#include "DeletionQueue.h"
+
 typedef std::optional<std::reference_wrapper<vk::SurfaceKHR>> optional_surface;
 
 struct DeviceRequestInfo {
 	std::vector<const char*> RequiredExtensions;
 	bool SupportPresentation = false;
 	bool SupportGraphics = false;
+
+	// Use a transfer-only queue family when the device has one
+	bool SupportAsyncTransfer = false;
 };
 
 enum E_QUEUE_TYPE
 {
 	GRAPHICS,
-	PRESENT
+	PRESENT,
+	TRANSFER
 };
 
 struct Queue {
@@ -61,10 +69,29 @@ public:
 		return _Queues.at(queueType);
 	}
 
+	bool HasQueue(const E_QUEUE_TYPE queueType) const {
+		return _Queues.find(queueType) != _Queues.end();
+	}
+
 	const vk::PhysicalDeviceProperties &GetProperties() const {
 		return _PhysicalDeviceProperties;
 	}
 
+	const vk::PhysicalDeviceFeatures &GetEnabledFeatures() const {
+		return _EnabledFeatures;
+	}
+
+	// Optimal tiling images of this format can be sampled
+	bool SupportsSampledFormat(const vk::Format format) const;
+
+	Allocator &GetAllocator() const {
+		return *_Allocator;
+	}
+
+	DeletionQueue &GetDeletionQueue() const {
+		return *_DeletionQueue;
+	}
+
 private:
 	void PickQueueFamilyIndex(const DeviceRequestInfo& info, optional_surface surface);
 
@@ -73,6 +100,7 @@ private:
 	vk::PhysicalDevice _PhysicalDevice;
 	vk::PhysicalDeviceProperties _PhysicalDeviceProperties;
 	vk::PhysicalDeviceFeatures _PhysicalDeviceFeatures;
+	vk::PhysicalDeviceFeatures _EnabledFeatures;
 
 	// Logical device (vulkan handle)
 	vk::Device _Device;
@@ -82,6 +110,11 @@ private:
 	std::vector<vk::QueueFamilyProperties> _QueueFamilyProperties;
 	std::map<E_QUEUE_TYPE, Queue> _Queues;
 
+	// Shared so the device stays copyable
+	std::shared_ptr<Allocator> _Allocator;
+	std::shared_ptr<DeletionQueue> _DeletionQueue;
+
+	bool _SupportMemoryBudget = false;
 	bool _SupportDebugMarkers = false;
 	PFN_vkCmdDebugMarkerBeginEXT pfnCmdDebugMarkerBegin;
 	PFN_vkCmdDebugMarkerEndEXT  pfnCmdDebugMarkerEnd;
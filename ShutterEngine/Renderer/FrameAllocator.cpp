@@ -0,0 +1,45 @@
+#include "FrameAllocator.h"
+
+void FrameAllocator::Init(Device *device, const vk::DeviceSize frameSize, const uint32_t nbFrames, const vk::BufferUsageFlags usage, const std::string &name)
+{
+	_Device = device;
+	_Alignment = std::max<vk::DeviceSize>(_Device->GetProperties().limits.minUniformBufferOffsetAlignment, 1);
+
+	// Keep every slot aligned so the offsets are valid for dynamic descriptors
+	_FrameSize = (frameSize + _Alignment - 1) / _Alignment * _Alignment;
+
+	_Buffer = Buffer(_Device, usage, _FrameSize * nbFrames);
+	_Buffer.SetAsset(name);
+}
+
+void FrameAllocator::Clean()
+{
+	_Buffer.Clean();
+}
+
+void FrameAllocator::BeginFrame(const uint32_t frame)
+{
+	_FrameStart = _FrameSize * frame;
+	_Head = _FrameStart;
+}
+
+FrameAllocation FrameAllocator::Allocate(const vk::DeviceSize size)
+{
+	vk::DeviceSize offset = (_Head + _Alignment - 1) / _Alignment * _Alignment;
+	if (offset + size > _FrameStart + _FrameSize) {
+		throw std::runtime_error("Frame allocator is out of memory.");
+	}
+
+	_Head = offset + size;
+
+	FrameAllocation allocation;
+	allocation.Data = static_cast<char*>(_Buffer.GetMapped()) + offset;
+	allocation.Offset = static_cast<uint32_t>(offset);
+
+	return allocation;
+}
+
+void FrameAllocator::Flush(const FrameAllocation &allocation, const vk::DeviceSize offset, const vk::DeviceSize size) const
+{
+	_Buffer.Flush(allocation.Offset + offset, size);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "DeviceHandler.h"
+#include "Buffer.h"
+
+struct FrameAllocation {
+	// Where to write the data for this frame
+	void *Data = nullptr;
+
+	// Offset to give to the dynamic descriptor
+	uint32_t Offset = 0;
+};
+
+// Linear allocator over a persistently mapped buffer, one slot per frame in flight
+class FrameAllocator {
+public:
+	FrameAllocator() {}
+
+	void Init(Device *device, const vk::DeviceSize frameSize, const uint32_t nbFrames, const vk::BufferUsageFlags usage, const std::string &name);
+	void Clean();
+
+	// Start writing in the slot of the frame, the GPU must be done with it
+	void BeginFrame(const uint32_t frame);
+	FrameAllocation Allocate(const vk::DeviceSize size);
+
+	// Flush a written range of an allocation
+	void Flush(const FrameAllocation &allocation, const vk::DeviceSize offset, const vk::DeviceSize size) const;
+
+	const vk::Buffer &GetBuffer() const {
+		return _Buffer.GetBuffer();
+	}
+
+	const vk::DeviceSize GetAlignment() const {
+		return _Alignment;
+	}
+
+	const vk::DeviceSize GetUsed() const {
+		return _Head - _FrameStart;
+	}
+
+private:
+	Device *_Device = nullptr;
+
+	Buffer _Buffer;
+
+	vk::DeviceSize _FrameSize = 0;
+	vk::DeviceSize _Alignment = 1;
+
+	vk::DeviceSize _FrameStart = 0;
+	vk::DeviceSize _Head = 0;
+};
@@ -33,6 +33,29 @@ Image::Image(
 	CreateImageView();
 }
 
+Image::Image(
+	Device *device,
+	const VkExtent3D &dimensions,
+	const uint8_t layers,
+	const uint32_t mipLevels,
+	const vk::Format &format,
+	const vk::ImageUsageFlags usage
+) :
+	_Device(device)
+{
+	_Format = format;
+	_Usage = usage;
+	_NbLayers = layers;
+	_Dimensions = dimensions;
+	_NumSamples = vk::SampleCountFlagBits::e1;
+	_MipLevels = std::max(mipLevels, 1u);
+
+	CreateImage();
+	AllocateMemory();
+
+	CreateImageView();
+}
+
 void Image::FromVkImage(
 	Device *device,
 	const vk::Image &image,
@@ -50,28 +73,79 @@ void Image::FromVkImage(
 	_FromSwapchain = true;
 }
 
+Image::Image(Image &&image) noexcept
+{
+	*this = std::move(image);
+}
+
+Image &Image::operator=(Image &&image) noexcept
+{
+	if (this != &image) {
+		Clean();
+
+		_Device = image._Device;
+		_Format = image._Format;
+		_Usage = image._Usage;
+		_NumSamples = image._NumSamples;
+		_Dimensions = image._Dimensions;
+		_MipLevels = image._MipLevels;
+		_NbLayers = image._NbLayers;
+		_Image = image._Image;
+		_View = image._View;
+		_Allocation = image._Allocation;
+		_FromSwapchain = image._FromSwapchain;
+
+		image._Image = nullptr;
+		image._View = nullptr;
+		image._Allocation = Allocation();
+	}
+
+	return *this;
+}
+
 void Image::Clean()
 {
-	if (_View) {
-		_Device->GetDevice().destroyImageView(_View);
+	if (!_View && !_Image && !_Allocation) {
+		return;
 	}
 
+	vk::Device device = _Device->GetDevice();
+	Allocator *allocator = &_Device->GetAllocator();
+	vk::ImageView view = _View;
+
 	// In case we obtained the image through the sawpchain, do not clear it
-	if (!_FromSwapchain) {
-		if (_Image) {
-			_Device->GetDevice().destroyImage(_Image);
-		}
+	vk::Image image = _FromSwapchain ? vk::Image() : _Image;
+	Allocation allocation = _FromSwapchain ? Allocation() : _Allocation;
 
-		if (_Memory) {
-			_Device->GetDevice().freeMemory(_Memory);
+	_Device->GetDeletionQueue().Push([device, allocator, view, image, allocation]() mutable {
+		if (view) {
+			device.destroyImageView(view);
 		}
-	}
+		if (image) {
+			device.destroyImage(image);
+		}
+		allocator->Free(allocation);
+	});
+
+	_View = nullptr;
+	_Image = nullptr;
+	_Allocation = Allocation();
+}
+
+void Image::SetAsset(const std::string &asset)
+{
+	_Device->GetAllocator().SetAsset(_Allocation, asset);
 }
 
 void Image::GenerateMipmaps(const vk::CommandPool& cmdPool)
 {
 	vk::CommandBuffer cmdBuffer = BeginSingleUseCommandBuffer(*_Device, cmdPool);
+	GenerateMipmaps(cmdBuffer);
+	EndSingleUseCommandBuffer(cmdBuffer, *_Device, cmdPool);
+}
 
+void Image::GenerateMipmaps(const vk::CommandBuffer &cmdBuffer) const
+{
 	std::array<vk::ImageMemoryBarrier, 1> barriers;
 	barriers[0].image = _Image;
 	barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -155,14 +229,17 @@ void Image::GenerateMipmaps(const vk::CommandPool& cmdPool)
 		nullptr,
 		barriers[0]
 	);
-
-	EndSingleUseCommandBuffer(cmdBuffer, *_Device, cmdPool);
 }
 
 void Image::TransitionLayout(const vk::CommandPool &cmdPool, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout)
 {
 	vk::CommandBuffer cmdBuffer = BeginSingleUseCommandBuffer(*_Device, cmdPool);
+	TransitionLayout(cmdBuffer, oldLayout, newLayout);
+	EndSingleUseCommandBuffer(cmdBuffer, *_Device, cmdPool);
+}
 
+void Image::TransitionLayout(const vk::CommandBuffer &cmdBuffer, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout) const
+{
 	std::array<vk::ImageMemoryBarrier, 1> barriers;
 	barriers[0].image = _Image;
 	barriers[0].oldLayout = oldLayout;
@@ -197,6 +274,13 @@ void Image::TransitionLayout(const vk::CommandPool &cmdPool, const vk::ImageLayo
 		srcStage = vk::PipelineStageFlagBits::eTopOfPipe;
 		dstStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
 	}
+	else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
+		barriers[0].srcAccessMask = {};
+		barriers[0].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		srcStage = vk::PipelineStageFlagBits::eTopOfPipe;
+		dstStage = vk::PipelineStageFlagBits::eFragmentShader;
+	}
 
 	cmdBuffer.pipelineBarrier(
 		srcStage,
@@ -206,8 +290,6 @@ void Image::TransitionLayout(const vk::CommandPool &cmdPool, const vk::ImageLayo
 		nullptr,
 		barriers[0]
 	);
-
-	EndSingleUseCommandBuffer(cmdBuffer, *_Device, cmdPool);
 }
 
 void Image::CreateImage()
@@ -236,14 +318,22 @@ void Image::AllocateMemory()
 {
 	vk::MemoryRequirements imageMemReq = _Device->GetDevice().getImageMemoryRequirements(_Image);
 
-	_Memory = _Device->GetDevice().allocateMemory(
-		vk::MemoryAllocateInfo(
-			imageMemReq.size,
-			findMemoryType(*_Device, imageMemReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal)
-		)
-	);
+	// Render targets are big and get recreated on resize, give them their own memory
+	E_ALLOCATION_TYPE allocationType = E_ALLOCATION_TYPE::OPTIMAL;
+	if (_Usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment)) {
+		allocationType = E_ALLOCATION_TYPE::DEDICATED;
+	}
+
+	E_MEMORY_CATEGORY category = E_MEMORY_CATEGORY::OTHER;
+	if (allocationType == E_ALLOCATION_TYPE::DEDICATED) {
+		category = E_MEMORY_CATEGORY::RENDER_TARGET;
+	}
+	else if (_Usage & vk::ImageUsageFlagBits::eSampled) {
+		category = E_MEMORY_CATEGORY::TEXTURE;
+	}
 
-	_Device->GetDevice().bindImageMemory(_Image, _Memory, 0);
+	_Allocation = _Device->GetAllocator().Allocate(imageMemReq, vk::MemoryPropertyFlagBits::eDeviceLocal, allocationType, category);
+	_Device->GetDevice().bindImageMemory(_Image, _Allocation.Memory, _Allocation.Offset);
 }
 
 void Image::CreateImageView()
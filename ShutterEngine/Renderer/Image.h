@@ -16,17 +16,46 @@ public:
 		const vk::SampleCountFlagBits numSamples = vk::SampleCountFlagBits::e1
 	);
 
+	// With a given amount of mip levels, each filled by the caller
+	explicit Image(
+		Device *device,
+		const VkExtent3D &dimensions,
+		const uint8_t layers,
+		const uint32_t mipLevels,
+		const vk::Format &format,
+		const vk::ImageUsageFlags usage
+	);
+
+	// Owns the image, its view and its memory, only moves
+	Image(const Image &image) = delete;
+	Image &operator=(const Image &image) = delete;
+	Image(Image &&image) noexcept;
+	Image &operator=(Image &&image) noexcept;
+
+	~Image() {
+		Clean();
+	}
+
 	// Only create the image view, based on the provided image
 	void FromVkImage(
 		Device *device,
 		const vk::Image &image,
 		const vk::Format &format
 	);
+
+	// Destroyed once the frames in flight are done with it
 	void Clean();
 
+	// Name the asset owning the image in the memory report
+	void SetAsset(const std::string &asset);
+
 	void GenerateMipmaps(const vk::CommandPool &cmdPool);
 	void TransitionLayout(const vk::CommandPool &cmdPool, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout);
 
+	// Same, recorded in a command buffer owned by the caller
+	void GenerateMipmaps(const vk::CommandBuffer &cmdBuffer) const;
+	void TransitionLayout(const vk::CommandBuffer &cmdBuffer, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout) const;
+
 
 	const vk::Image &GetImage() const {
 		return _Image;
@@ -44,26 +73,39 @@ public:
 		return _MipLevels;
 	}
 
+	// Every level and layer of the image
+	vk::ImageSubresourceRange GetSubresourceRange() const {
+		return vk::ImageSubresourceRange(
+			_Format == vk::Format::eD32Sfloat ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor,
+			0, _MipLevels,
+			0, _NbLayers
+		);
+	}
+
+	const vk::DeviceSize GetMemorySize() const {
+		return _Allocation.Size;
+	}
+
 private:
 	void CreateImage();
 	void AllocateMemory();
 	void CreateImageView();
 
 private:
-	Device *_Device;
+	Device *_Device = nullptr;
 
 	vk::Format _Format;
 	vk::ImageUsageFlags _Usage;
 	vk::SampleCountFlagBits _NumSamples;
 
 	vk::Extent3D _Dimensions;
-	uint32_t _MipLevels;
-	uint32_t _NbLayers;
+	uint32_t _MipLevels = 1;
+	uint32_t _NbLayers = 1;
 
 	vk::Image _Image;
 	vk::ImageView _View;
 
-	vk::DeviceMemory _Memory;
+	Allocation _Allocation;
 
 	bool _FromSwapchain = false;
 };
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include "Helpers.h"
 #include "Engine/Scene.h"
 
-Material::Material(Device *device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize) :
+Material::Material(Device *device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize, const E_VERTEX_LAYOUT vertexLayout, const bool positionOnly, const bool instanced) :
+	_VertexLayout(vertexLayout),
+	_PositionOnly(positionOnly),
+	_Instanced(instanced),
 	_Device(device),
 	_Scene(scene)
 {
@@ -46,13 +49,22 @@ void Material::ClearShaders()
 
 void Material::CreatePipeline(const vk::RenderPass &renderPass)
 {
-	/// TODO: Clean, moved here to keep pointer context
+	_VertexBindings = GetVertexBindingDescriptions(_VertexLayout, _PositionOnly);
+	_VertexAttributes = GetVertexAttributeDescriptions(_VertexLayout, _PositionOnly);
+
+	if (_Instanced) {
+		_VertexBindings.push_back(GetInstanceBindingDescription(_Scene->GetDynamicStride()));
+
+		std::vector<vk::VertexInputAttributeDescription> instanceAttributes = GetInstanceAttributeDescriptions();
+		_VertexAttributes.insert(_VertexAttributes.end(), instanceAttributes.begin(), instanceAttributes.end());
+	}
+
 	_VertexInputInfo = vk::PipelineVertexInputStateCreateInfo(
 		{},
-		static_cast<uint32_t>(1),
-		&Vertex::GetBindingDescription(),
-		static_cast<uint32_t>(Vertex::GetAttributeDescriptions().size()),
-		Vertex::GetAttributeDescriptions().data()
+		static_cast<uint32_t>(_VertexBindings.size()),
+		_VertexBindings.data(),
+		static_cast<uint32_t>(_VertexAttributes.size()),
+		_VertexAttributes.data()
 	);
 
 	auto stages = GetShaderInfoList();
@@ -124,7 +136,7 @@ void Material::CreateRasterizationInfo()
 
 void Material::CreateMultisampleInfo()
 {
-	_MultisampleInfo = vk::PipelineMultisampleStateCreateInfo({}, vk::SampleCountFlagBits::e4, false);
+	_MultisampleInfo = vk::PipelineMultisampleStateCreateInfo({}, _SampleCount, false);
 }
 
 void Material::CreateDepthStencilInfo()
@@ -163,6 +175,9 @@ void Material::CreateColorBlendInfo()
 
 void Material::CreatePushConstantRange()
 {
+	if (_VertexLayout == E_VERTEX_LAYOUT::COMPACT) {
+		_PushConstantRange.push_back(vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(VertexQuantization)));
+	}
 }
 
 void Material::CreateDescriptorSetLayout()
@@ -4,6 +4,7 @@
 #include <vector>
 #include <unordered_map>
 #include "Shader.h"
+#include "Engine/VertexLayout.h"
 
 class Scene;
 
@@ -15,7 +16,10 @@ public:
 		Scene *scene,
 		const uint16_t width,
 		const uint16_t height,
-		const uint32_t poolSize
+		const uint32_t poolSize,
+		const E_VERTEX_LAYOUT vertexLayout = E_VERTEX_LAYOUT::STANDARD,
+		const bool positionOnly = false,
+		const bool instanced = false
 	);
 
 	void ReloadPipeline(const vk::RenderPass &renderPass, const uint16_t width, const uint16_t height);
@@ -38,9 +42,24 @@ public:
 	const vk::PipelineLayout &GetPipelineLayout() const {
 		return _PipelineLayout;
 	}
+	vk::CullModeFlags GetCullMode() const {
+		return _RasterizationInfo.cullMode;
+	}
 
 	bool _CastShadow = false;
 
+	// Compact materials receive the mesh's VertexQuantization as vertex push constants
+	E_VERTEX_LAYOUT _VertexLayout = E_VERTEX_LAYOUT::STANDARD;
+
+	// Only the position stream is bound, for depth-only shaders
+	bool _PositionOnly = false;
+
+	// The vertex shader reads the model matrix as instance data, objects sharing a mesh are then drawn at once
+	bool _Instanced = false;
+
+	// Sample count of the colour pass this material is drawn in
+	vk::SampleCountFlagBits _SampleCount = vk::SampleCountFlagBits::e4;
+
 protected:
 	Device *_Device;
 	Scene *_Scene;
@@ -86,4 +105,6 @@ protected:
 	vk::Pipeline _Pipeline;
 
 	vk::PipelineVertexInputStateCreateInfo _VertexInputInfo;
+	std::vector<vk::VertexInputBindingDescription> _VertexBindings;
+	std::vector<vk::VertexInputAttributeDescription> _VertexAttributes;
 };
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+uint32_t MemoryTracker::Add(const E_MEMORY_CATEGORY category, const vk::DeviceSize size, const uint32_t heap)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	uint32_t id = _NextId++;
+	_Records.emplace(id, Record{ category, size, heap, std::string() });
+
+	_CategoryBytes[static_cast<size_t>(category)] += size;
+	_HeapBytes[heap] += size;
+
+	return id;
+}
+
+void MemoryTracker::Remove(const uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	auto it = _Records.find(id);
+	if (it == _Records.end()) {
+		return;
+	}
+
+	_CategoryBytes[static_cast<size_t>(it->second.Category)] -= it->second.Size;
+	_HeapBytes[it->second.Heap] -= it->second.Size;
+
+	_Records.erase(it);
+}
+
+void MemoryTracker::SetAsset(const uint32_t id, const std::string &asset)
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+
+	auto it = _Records.find(id);
+	if (it != _Records.end()) {
+		it->second.Asset = asset;
+	}
+}
+
+std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> MemoryTracker::GetCategoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+	return _CategoryBytes;
+}
+
+vk::DeviceSize MemoryTracker::GetHeapUsage(const uint32_t heap) const
+{
+	std::lock_guard<std::mutex> lock(_Mutex);
+	return _HeapBytes[heap];
+}
+
+void MemoryTracker::WriteReport(std::ostream &out) const
+{
+	struct AssetUsage {
+		std::string Asset;
+		E_MEMORY_CATEGORY Category;
+		vk::DeviceSize Size = 0;
+		uint32_t Count = 0;
+	};
+
+	std::vector<AssetUsage> assets;
+	std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> categories;
+	{
+		std::lock_guard<std::mutex> lock(_Mutex);
+
+		// Group by asset and category, a mesh and its texture can have the same name
+		std::map<std::pair<std::string, E_MEMORY_CATEGORY>, AssetUsage> grouped;
+		for (const auto &record : _Records) {
+			AssetUsage &usage = grouped[{ record.second.Asset, record.second.Category }];
+			usage.Asset = record.second.Asset.empty() ? "(unnamed)" : record.second.Asset;
+			usage.Category = record.second.Category;
+			usage.Size += record.second.Size;
+			++usage.Count;
+		}
+
+		for (const auto &usage : grouped) {
+			assets.push_back(usage.second);
+		}
+		categories = _CategoryBytes;
+	}
+
+	std::sort(assets.begin(), assets.end(), [](const AssetUsage &a, const AssetUsage &b) {
+		return a.Size > b.Size;
+	});
+
+	const float MB = 1024.0f * 1024.0f;
+	out << std::fixed << std::setprecision(2);
+
+	out << "Category totals\n";
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		out << "  " << std::setw(14) << std::left << GetCategoryName(static_cast<E_MEMORY_CATEGORY>(i))
+			<< std::setw(10) << std::right << categories[i] / MB << " MB\n";
+	}
+
+	out << "\nAssets\n";
+	for (const auto &usage : assets) {
+		out << "  " << std::setw(10) << std::right << usage.Size / MB << " MB  "
+			<< std::setw(4) << usage.Count << "  "
+			<< std::setw(14) << std::left << GetCategoryName(usage.Category)
+			<< usage.Asset << "\n";
+	}
+}
+
+const char *MemoryTracker::GetCategoryName(const E_MEMORY_CATEGORY category)
+{
+	static const char *names[MEMORY_CATEGORY_COUNT] = { "Mesh", "Texture", "Render target", "Staging", "Uniform", "Other" };
+	return names[static_cast<size_t>(category)];
+}
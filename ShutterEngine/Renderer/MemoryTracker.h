@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <string>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vulkan/vulkan.hpp>
+
+// Scoped, STAGING is also an allocation type
+enum class E_MEMORY_CATEGORY
+{
+	MESH,
+	TEXTURE,
+	RENDER_TARGET,
+	STAGING,
+	UNIFORM,
+	OTHER
+};
+
+static const size_t MEMORY_CATEGORY_COUNT = 6;
+
+// Keeps a record of every live allocation, with what it is used for and the asset owning it
+class MemoryTracker {
+public:
+	MemoryTracker() {}
+
+	// Return the id of the record, never 0
+	uint32_t Add(const E_MEMORY_CATEGORY category, const vk::DeviceSize size, const uint32_t heap);
+	void Remove(const uint32_t id);
+	void SetAsset(const uint32_t id, const std::string &asset);
+
+	std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> GetCategoryUsage() const;
+	vk::DeviceSize GetHeapUsage(const uint32_t heap) const;
+
+	// Memory used by each asset, biggest first
+	void WriteReport(std::ostream &out) const;
+
+	static const char *GetCategoryName(const E_MEMORY_CATEGORY category);
+
+private:
+	struct Record {
+		E_MEMORY_CATEGORY Category;
+		vk::DeviceSize Size;
+		uint32_t Heap;
+		std::string Asset;
+	};
+
+	std::unordered_map<uint32_t, Record> _Records;
+	uint32_t _NextId = 1;
+
+	std::array<vk::DeviceSize, MEMORY_CATEGORY_COUNT> _CategoryBytes = {};
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> _HeapBytes = {};
+
+	mutable std::mutex _Mutex;
+};
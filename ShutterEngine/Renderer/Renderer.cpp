@@ -21,8 +21,10 @@ void Renderer::Init(GLFWwindow* window, const uint16_t width, const uint16_t hei
 
 	_Scene->CreateDescriptorSets(&_Device, _Surface._NbImages);
 	CreateCommandPool();
+	_UploadContext.Init(&_Device);
 
 	CreateDepth();
+	CreateShadowMap();
 	CreateOffscreen();
 
 
@@ -33,19 +35,33 @@ void Renderer::Init(GLFWwindow* window, const uint16_t width, const uint16_t hei
 	_GUI.Init(&_Device, _Window, _Surface._Surface, _ScreenSize, _Instance, _Surface._Swapchain, _CommandPool);
 	CreateFramebuffers();
 
-	_Scene->Load("sponza", &_Device, _CommandPool, _RenderPass, _ShadowRenderPass, _ShadowTexture);
+	_Scene->Load("sponza", &_Device, _UploadContext, _RenderPass, _ShadowRenderPass, _ShadowTexture);
+	_UploadContext.Wait(_UploadContext.Submit());
 	_GUI.tree._Scene = _Scene;
 
+	_TemporalAA.Init(&_Device, _CommandPool, "Data/shaders/", _Surface._SelectedSurfaceFormat.format, _Surface._NbImages);
+	_GUI.aa._RequestedMode = _AntiAliasing;
+	_GUI.aa.SetMemoryUsage(_AntiAliasing, GetRenderTargetMemory());
+
 	CreateCommandBuffers();
 	CreateSemaphores();
+	CreateTimestampQueries();
 }
 
 void Renderer::Draw()
 {
+	if (_GUI.aa._RequestedMode != _AntiAliasing) {
+		SetAntiAliasing(static_cast<E_ANTI_ALIASING>(_GUI.aa._RequestedMode));
+	}
+
 	_Device().waitForFences(_InFlightFences[_CurrentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
 	_Device().resetFences(_InFlightFences[_CurrentFrame]);
 	_Device().resetFences(_ShadowFences[_CurrentFrame]);
-	_Device().resetFences(_OffscreenFences[_CurrentFrame]);
+
+	// Waiting on this slot means every frame but the previous one is done
+	_Device.GetDeletionQueue().BeginFrame(_FrameNumber, _FrameNumber > 0 ? _FrameNumber - 1 : 0);
+
+	ReadTimestamps();
 
 	_FrameDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
 	_GUI.perf.AddValue(_FrameDuration);
@@ -53,16 +69,23 @@ void Renderer::Draw()
 
 	uint32_t imageIndex = _Device().acquireNextImageKHR(_Surface._Swapchain, std::numeric_limits<uint64_t>::max(), _ImageAvailableSemaphore[_CurrentFrame], {}).value;
 
-	_Scene->Update(_CurrentFrame);
+	if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+		_Scene->_Camera.SetJitter(_TemporalAA.NextJitter());
+	}
+
+	_Scene->BeginFrame(_CurrentFrame);
+	_Scene->Update();
+	_Scene->CullClusters(true);
 
+	_SubmittedTriangles = 0;
 	BuildShadowCommandBuffers();
 
 	_Device.GetQueue(E_QUEUE_TYPE::GRAPHICS).VulkanQueue.submit(
 		{
 			vk::SubmitInfo(
-				1,
-				&_ImageAvailableSemaphore[_CurrentFrame],
-				&vk::PipelineStageFlags(vk::PipelineStageFlagBits::eFragmentShader),
+				0,
+				nullptr,
+				nullptr,
 				1,
 				&_ShadowCommandBuffers[_CurrentFrame],
 				0,
@@ -75,27 +98,29 @@ void Renderer::Draw()
 
 	_Device().waitForFences(_ShadowFences[_CurrentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
 
-	_Scene->Update(_CurrentFrame);
+	_Scene->Update();
+	_Scene->CullClusters(false);
 
+	BuildCommandBuffers(imageIndex);
+	_GUI.perf.SetTriangles(_SubmittedTriangles);
 
-	BuildCommandBuffers();
-
+	// Scene and UI go in a single submission, the swapchain image is only needed once writing to it
+	vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
 	_Device.GetQueue(E_QUEUE_TYPE::GRAPHICS).VulkanQueue.submit(
 		{
 			vk::SubmitInfo(
-				0,
-				nullptr,
-				&vk::PipelineStageFlags(vk::PipelineStageFlagBits::eColorAttachmentOutput),
+				1,
+				&_ImageAvailableSemaphore[_CurrentFrame],
+				&waitStage,
 				1,
 				&_CommandBuffers[_CurrentFrame],
-				0,
-				nullptr
+				1,
+				&_RenderFinishedSemaphore[_CurrentFrame]
 			)
 		},
-		_OffscreenFences[_CurrentFrame]
+		_InFlightFences[_CurrentFrame]
 	);
 
-	_GUI.Render(_CurrentFrame, _FramebuffersPresent, _OffscreenFences, _InFlightFences, _RenderFinishedSemaphore, _Scene);
 	_Device.GetQueue(E_QUEUE_TYPE::PRESENT).VulkanQueue.presentKHR(vk::PresentInfoKHR(
 		1,
 		&_RenderFinishedSemaphore[_CurrentFrame],
@@ -107,47 +132,63 @@ void Renderer::Draw()
 
 	std::cout << _FrameDuration << std::endl;
 	_CurrentFrame = (_CurrentFrame + 1) % 2;
+	++_FrameNumber;
 }
 
 void Renderer::Clean()
 {
-	//DepthImage.Clean(DeviceRef);
-	//for (auto &frame : FrameBuffers) {
-	//	vkDestroyFramebuffer(DeviceRef.GetLogicalDevice(), frame, nullptr);
-	//}
-	//vkFreeCommandBuffers(DeviceRef.GetLogicalDevice(), CommandPool, CommandBuffers.size(), CommandBuffers.data());
+	WaitIdle();
+
+	_Scene->Clean();
+	_UploadContext.Clean();
+	_TemporalAA.Clean();
+
+	_DepthImage.Clean();
+	_ShadowTexture.Clean();
+	for (auto &image : _ImageColor) {
+		image.Clean();
+	}
+
+	for (auto &fb : _ShadowFramebuffer) {
+		_Device().destroyFramebuffer(fb);
+	}
+	for (auto &fb : _Framebuffers) {
+		_Device().destroyFramebuffer(fb);
+	}
+	for (auto &fb : _FramebuffersPresent) {
+		_Device().destroyFramebuffer(fb);
+	}
 
-	//vkDestroyRenderPass(DeviceRef.GetLogicalDevice(), RenderPass, nullptr);
-	//for (auto &image : SwapChainImageViews) {
-	//	image.Clean(DeviceRef);
-	//}
-	//vkDestroySwapchainKHR(DeviceRef.GetLogicalDevice(), SwapChain, nullptr);
+	_Device().destroyRenderPass(_RenderPass);
+	_Device().destroyRenderPass(_ShadowRenderPass);
 
-	//for (auto &semaphore : ImageAvailableSemaphore) {
-	//	vkDestroySemaphore(DeviceRef.GetLogicalDevice(), semaphore, nullptr);
-	//}
-	//for (auto &semaphore : RenderFinishedSemaphore) {
-	//	vkDestroySemaphore(DeviceRef.GetLogicalDevice(), semaphore, nullptr);
-	//}
-	//for (auto &fence : InFlightFences) {
-	//	vkDestroyFence(DeviceRef.GetLogicalDevice(), fence, nullptr);
-	//}
+	// Also frees the command buffers allocated from it
+	_Device().destroyCommandPool(_CommandPool);
 
-	//vkDestroyCommandPool(DeviceRef.GetLogicalDevice(), CommandPool, nullptr);
+	for (size_t i = 0; i < _InFlightFences.size(); ++i) {
+		_Device().destroySemaphore(_ImageAvailableSemaphore[i]);
+		_Device().destroySemaphore(_RenderFinishedSemaphore[i]);
+		_Device().destroyFence(_InFlightFences[i]);
+		_Device().destroyFence(_ShadowFences[i]);
+	}
 
-	//VertexShader.Clean(DeviceRef);
-	//FragmentShader.Clean(DeviceRef);
+	_Device().destroyQueryPool(_TimestampPool);
 
+	_Surface.Clean();
 
-	//DeviceRef.Clean();
+	// Runs the pending destructions and releases the memory blocks
+	_Device.Clean();
 
 	//layerManager.Clean(Instance);
 
-	//vkDestroySurfaceKHR(Instance, Surface, nullptr);
-
 	//vkDestroyInstance(Instance, nullptr);
 }
 
+void Renderer::ToggleGUI()
+{
+	_GUI._Visible = !_GUI._Visible;
+}
+
 void Renderer::WaitIdle()
 {
 	_Device().waitIdle();
@@ -165,6 +206,8 @@ void Renderer::Resize()
 
 	_DepthImage.Clean();
 	CreateDepth();
+	CreateShadowMap();
+	_Scene->UpdateTextureDescriptors();
 
 	for (auto &image : _ImageColor) {
 		image.Clean();
@@ -189,11 +232,57 @@ void Renderer::Resize()
 
 	_Scene->Resize(_RenderPass, _ShadowRenderPass, _Surface.GetWindowDimensions());
 
+	if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+		_TemporalAA.CreateTargets(_Surface.GetWindowDimensions(), _ImageColor, _DepthImage, _Surface._SwapchainImages);
+	}
+	_GUI.aa.SetMemoryUsage(_AntiAliasing, GetRenderTargetMemory());
+
 	_GUI.windowSize = _Surface.GetWindowDimensions();
 
+	// The GPU is idle, the old targets can go right away
+	_Device.GetDeletionQueue().Flush();
+
 	//_Scene->ReloadShader(_RenderPass, _Surface.GetWindowDimensions());
 }
 
+void Renderer::SetAntiAliasing(const E_ANTI_ALIASING mode)
+{
+	WaitIdle();
+	_AntiAliasing = mode;
+
+	// Only the colour pass depends on the mode, the shadow pass is left as is
+	_DepthImage.Clean();
+	CreateDepth();
+
+	for (auto &image : _ImageColor) {
+		image.Clean();
+	}
+	CreateOffscreen();
+
+	for (auto &fb : _Framebuffers) {
+		_Device().destroyFramebuffer(fb);
+	}
+	_Device().destroyRenderPass(_RenderPass);
+
+	CreateRenderPass();
+	CreateSceneFramebuffers();
+
+	_Scene->SetSampleCount(GetSampleCount());
+	_Scene->Resize(_RenderPass, _ShadowRenderPass, _Surface.GetWindowDimensions());
+
+	if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+		_TemporalAA.CreateTargets(_Surface.GetWindowDimensions(), _ImageColor, _DepthImage, _Surface._SwapchainImages);
+	}
+	else {
+		_TemporalAA.CleanTargets();
+		_Scene->_Camera.SetJitter(glm::vec2(0.0f, 0.0f));
+	}
+
+	_GUI.aa.SetMemoryUsage(_AntiAliasing, GetRenderTargetMemory());
+
+	_Device.GetDeletionQueue().Flush();
+}
+
 void Renderer::CreateInstance()
 {
 	vk::ApplicationInfo applicationInfo("Demo", VK_MAKE_VERSION(1, 0, 0), "Shutter", VK_MAKE_VERSION(1, 0, 0), VULKAN_VERSION);
@@ -239,6 +328,7 @@ void Renderer::CreateDevice() {
 	};
 	deviceRequestInfo.SupportPresentation = true;
 	deviceRequestInfo.SupportGraphics = true;
+	deviceRequestInfo.SupportAsyncTransfer = true;
 
 	_Device = Device::GetDevice(_Instance, deviceRequestInfo, _Surface._Surface);
 	_Device.Init(deviceRequestInfo, _Surface._Surface);
@@ -246,17 +336,20 @@ void Renderer::CreateDevice() {
 
 void Renderer::CreateRenderPass()
 {
+	// With TAA the colour and depth are single sampled and read back by the resolve
+	const bool temporal = _AntiAliasing == E_ANTI_ALIASING::TAA;
+
 	// Color Image
 	vk::AttachmentDescription colorAttachement(
 		{},
 		_Surface._SelectedSurfaceFormat.format,
-		vk::SampleCountFlagBits::e4,
+		GetSampleCount(),
 		vk::AttachmentLoadOp::eClear,
 		vk::AttachmentStoreOp::eStore,
 		vk::AttachmentLoadOp::eDontCare,
 		vk::AttachmentStoreOp::eDontCare,
 		vk::ImageLayout::eUndefined,
-		vk::ImageLayout::ePresentSrcKHR
+		temporal ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::ePresentSrcKHR
 	);
 
 	vk::AttachmentReference colorAttachementReference(
@@ -268,13 +361,13 @@ void Renderer::CreateRenderPass()
 	vk::AttachmentDescription depthAttachement(
 		{},
 		_DepthImage.GetFormat(),
-		vk::SampleCountFlagBits::e4,
+		GetSampleCount(),
 		vk::AttachmentLoadOp::eClear,
-		vk::AttachmentStoreOp::eDontCare,
+		temporal ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
 		vk::AttachmentLoadOp::eDontCare,
 		vk::AttachmentStoreOp::eDontCare,
 		vk::ImageLayout::eUndefined,
-		vk::ImageLayout::eDepthStencilAttachmentOptimal
+		temporal ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eDepthStencilAttachmentOptimal
 	);
 
 	vk::AttachmentReference depthAttachementReference(
@@ -307,7 +400,7 @@ void Renderer::CreateRenderPass()
 		{},
 		1,
 		&colorAttachementReference,
-		&resolveAttachementReference,
+		temporal ? nullptr : &resolveAttachementReference,
 		&depthAttachementReference
 	);
 
@@ -317,22 +410,34 @@ void Renderer::CreateRenderPass()
 		resolveAttachement
 	};
 
-	
-	_RenderPass = _Device().createRenderPass(vk::RenderPassCreateInfo(
-		{},
-		attachements.size(),
-		attachements.data(),
-		1,
-		&subpass,
-		1,
-		&vk::SubpassDependency(
+	std::array<vk::SubpassDependency, 2> dependencies{
+		vk::SubpassDependency(
 			VK_SUBPASS_EXTERNAL,
 			0,
 			vk::PipelineStageFlagBits::eColorAttachmentOutput,
 			vk::PipelineStageFlagBits::eColorAttachmentOutput,
 			{},
 			vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
+		),
+		// Make the colour and depth visible to the TAA passes
+		vk::SubpassDependency(
+			0,
+			VK_SUBPASS_EXTERNAL,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests,
+			vk::PipelineStageFlagBits::eFragmentShader,
+			vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+			vk::AccessFlagBits::eShaderRead
 		)
+	};
+	
+	_RenderPass = _Device().createRenderPass(vk::RenderPassCreateInfo(
+		{},
+		temporal ? 2 : 3,
+		attachements.data(),
+		1,
+		&subpass,
+		temporal ? 2 : 1,
+		dependencies.data()
 	));
 }
 
@@ -341,7 +446,7 @@ void Renderer::CreateShadowRenderPass()
 	// Depth Image
 	vk::AttachmentDescription depthAttachement(
 		{},
-		_ShadowImage.GetFormat(),
+		_ShadowTexture.GetImage().GetFormat(),
 		vk::SampleCountFlagBits::e1,
 		vk::AttachmentLoadOp::eClear,
 		vk::AttachmentStoreOp::eStore,
@@ -398,7 +503,7 @@ void Renderer::CreateFramebuffers()
 
 		for (size_t i = 0; i < _Surface._NbImages; ++i) {
 			std::array<vk::ImageView, 1> attachments = {
-				_ShadowImage.GetImageView(),
+				_ShadowTexture.GetImage().GetImageView(),
 			};
 
 			_ShadowFramebuffer[i] = _Device().createFramebuffer(vk::FramebufferCreateInfo(
@@ -414,27 +519,7 @@ void Renderer::CreateFramebuffers()
 	}
 
 	// Framebuffer used in offscreen to render to scene
-	{
-		_Framebuffers.resize(_Surface._NbImages);
-
-		for (size_t i = 0; i < _Surface._NbImages; ++i) {
-			std::array<vk::ImageView, 3> attachments = {
-				_ImageColor[i].GetImageView(),
-				_DepthImage.GetImageView(),
-				_Surface._SwapchainImages[i].GetImageView()
-			};
-
-			_Framebuffers[i] = _Device().createFramebuffer(vk::FramebufferCreateInfo(
-				{},
-				_RenderPass,
-				attachments.size(),
-				attachments.data(),
-				_Surface.GetWindowDimensions().width,
-				_Surface.GetWindowDimensions().height,
-				1
-			));
-		}
-	}
+	CreateSceneFramebuffers();
 
 	// Framebuffer used for rendering the UI
 	{
@@ -458,6 +543,30 @@ void Renderer::CreateFramebuffers()
 	}
 }
 
+void Renderer::CreateSceneFramebuffers()
+{
+	_Framebuffers.resize(_Surface._NbImages);
+
+	for (size_t i = 0; i < _Surface._NbImages; ++i) {
+		std::array<vk::ImageView, 3> attachments = {
+			_ImageColor[i].GetImageView(),
+			_DepthImage.GetImageView(),
+			_Surface._SwapchainImages[i].GetImageView()
+		};
+
+		// The TAA resolve writes the swapchain instead of the multisample resolve
+		_Framebuffers[i] = _Device().createFramebuffer(vk::FramebufferCreateInfo(
+			{},
+			_RenderPass,
+			_AntiAliasing == E_ANTI_ALIASING::TAA ? 2 : 3,
+			attachments.data(),
+			_Surface.GetWindowDimensions().width,
+			_Surface.GetWindowDimensions().height,
+			1
+		));
+	}
+}
+
 void Renderer::CreateCommandPool()
 {
 	_CommandPool = _Device().createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, _Device.GetQueue(E_QUEUE_TYPE::GRAPHICS).Index));
@@ -465,17 +574,29 @@ void Renderer::CreateCommandPool()
 
 void Renderer::CreateDepth()
 {
+	vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+
+	// The TAA velocity pass reads the depth back
+	if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+		usage |= vk::ImageUsageFlagBits::eSampled;
+	}
+
 	_DepthImage = Image(
 		&_Device,
 		VkExtent3D{ _Surface.GetWindowDimensions().width, _Surface.GetWindowDimensions().height, 1 },
 		1,
 		vk::Format::eD32Sfloat,
-		vk::ImageUsageFlagBits::eDepthStencilAttachment,
+		usage,
 		false,
-		vk::SampleCountFlagBits::e4
+		GetSampleCount()
 	);
+	_DepthImage.SetAsset("Depth");
+}
 
-	_ShadowImage = Image(
+void Renderer::CreateShadowMap()
+{
+	_ShadowTexture = Texture(&_Device);
+	_ShadowTexture._Image = Image(
 		&_Device,
 		VkExtent3D{ _Surface.GetWindowDimensions().width, _Surface.GetWindowDimensions().height, 1 },
 		1,
@@ -484,9 +605,7 @@ void Renderer::CreateDepth()
 		false,
 		vk::SampleCountFlagBits::e1
 	);
-
-	_ShadowTexture = Texture(&_Device);
-	_ShadowTexture._Image = _ShadowImage;
+	_ShadowTexture._Image.SetAsset("Shadow map");
 	_ShadowTexture.CreateSampler();
 }
 
@@ -496,16 +615,26 @@ void Renderer::CreateOffscreen()
 	{
 		_ImageColor.resize(_Surface._NbImages);
 
+		// Multisampled images only live during the pass, the TAA resolve samples the colour
+		vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eColorAttachment;
+		if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+			usage |= vk::ImageUsageFlagBits::eSampled;
+		}
+		else {
+			usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+		}
+
 		for (size_t i = 0; i < _Surface._NbImages; i++) {
 			_ImageColor.at(i) = Image(
 				&_Device,
 				VkExtent3D{ _Surface.GetWindowDimensions().width, _Surface.GetWindowDimensions().height, 1 },
 				1,
 				_Surface._SelectedSurfaceFormat.format,
-				vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment,
+				usage,
 				false,
-				vk::SampleCountFlagBits::e4
+				GetSampleCount()
 			);
+			_ImageColor.at(i).SetAsset("Color");
 			_ImageColor.at(i).TransitionLayout(_CommandPool, vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal);
 		}
 	}
@@ -537,6 +666,7 @@ void Renderer::BuildShadowCommandBuffers()
 		vk::SubpassContents::eInline
 	);
 
+	const std::array<uint32_t, 3> &sceneOffsets = _Scene->GetDynamicOffsets();
 	_ShadowCommandBuffers[_CurrentFrame].bindDescriptorSets(
 		vk::PipelineBindPoint::eGraphics,
 		_Scene->_Materials.at("shadow")->GetPipelineLayout(),
@@ -544,29 +674,14 @@ void Renderer::BuildShadowCommandBuffers()
 		{
 			_Scene->GetDescriptorSet(_CurrentFrame)
 		},
-		{}
+		{ sceneOffsets[0], sceneOffsets[1], sceneOffsets[2] }
 	);
 	_ShadowCommandBuffers[_CurrentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, _Scene->_Materials.at("shadow")->GetPipeline());
 
 	for (const auto &mat : _Scene->_Materials) {
 		if (mat.second->_CastShadow && _Scene->_Objects[mat.first].size() > 0) {
 			_Device.StartMarker(_ShadowCommandBuffers[_CurrentFrame], mat.first);
-			for (const auto &object : _Scene->_Objects[mat.first]) {
-				_ShadowCommandBuffers[_CurrentFrame].bindVertexBuffers(0, { object._Mesh._VertexBuffer.GetBuffer() }, { 0 });
-
-				_ShadowCommandBuffers[_CurrentFrame].bindDescriptorSets(
-					vk::PipelineBindPoint::eGraphics,
-					_Scene->_Materials.at("shadow")->GetPipelineLayout(),
-					0,
-					{
-						_Scene->GetDescriptorSet(_CurrentFrame),
-						object.GetDescriptorSet(_CurrentFrame)
-					},
-					{ object._DynamicIndex * static_cast<uint32_t>(Object::dynamicAlignement) }
-				);
-
-				_ShadowCommandBuffers[_CurrentFrame].draw(object._Mesh._Vertices.size(), 1, 0, 0);
-			}
+			_SubmittedTriangles += DrawObjects(_ShadowCommandBuffers[_CurrentFrame], *_Scene->_Materials.at("shadow"), _Scene->_Objects[mat.first], _Scene->_InstanceGroups[mat.first], _Scene->_ClusterDraws[mat.first]);
 			_Device.EndMarker(_ShadowCommandBuffers[_CurrentFrame]);
 		}
 	}
@@ -576,9 +691,101 @@ void Renderer::BuildShadowCommandBuffers()
 	_ShadowCommandBuffers[_CurrentFrame].end();
 }
 
-void Renderer::BuildCommandBuffers()
+void Renderer::BindMesh(const vk::CommandBuffer &commandBuffer, const Material &material, const Mesh &mesh) const
+{
+	if (material._PositionOnly) {
+		commandBuffer.bindVertexBuffers(POSITION_STREAM, { mesh.GetVertexStream(material._VertexLayout, POSITION_STREAM).GetBuffer() }, { 0 });
+	}
+	else {
+		commandBuffer.bindVertexBuffers(
+			POSITION_STREAM,
+			{ mesh.GetVertexStream(material._VertexLayout, POSITION_STREAM).GetBuffer(), mesh.GetVertexStream(material._VertexLayout, ATTRIBUTE_STREAM).GetBuffer() },
+			{ 0, 0 }
+		);
+	}
+
+	commandBuffer.bindIndexBuffer(mesh._IndexBuffer.GetBuffer(), 0, vk::IndexType::eUint32);
+
+	if (material._VertexLayout == E_VERTEX_LAYOUT::COMPACT) {
+		commandBuffer.pushConstants(material.GetPipelineLayout(), vk::ShaderStageFlagBits::eVertex, 0, sizeof(VertexQuantization), &mesh.GetQuantization());
+	}
+}
+
+uint64_t Renderer::DrawObjects(const vk::CommandBuffer &commandBuffer, const Material &material, const std::vector<Object> &objects, const std::vector<InstanceGroup> &groups, const std::vector<ClusterDraws> &clusters) const
+{
+	const std::array<uint32_t, 3> &sceneOffsets = _Scene->GetDynamicOffsets();
+	const uint32_t commandSize = sizeof(vk::DrawIndexedIndirectCommand);
+	uint64_t nbTriangles = 0;
+
+	for (const auto &group : groups) {
+		const Mesh &mesh = *objects[group._First]._Mesh;
+		BindMesh(commandBuffer, material, mesh);
+
+		// Instances share a level, the finest one any of them needs
+		uint32_t instancedLod = objects[group._First].GetLod();
+		for (uint32_t i = group._First; i < group._First + group._Count; ++i) {
+			instancedLod = std::min(instancedLod, objects[i].GetLod());
+		}
+
+		// Without instancing, each object of the group is still its own draw
+		const uint32_t nbDraws = material._Instanced ? 1 : group._Count;
+		const uint32_t nbInstances = material._Instanced ? group._Count : 1;
+
+		for (uint32_t i = group._First; i < group._First + nbDraws; ++i) {
+			const Object &object = objects[i];
+			const ClusterDraws &draws = clusters[i];
+
+			// Out of view or facing away as a whole
+			if (draws._Culled && draws._Count == 0) {
+				continue;
+			}
+
+			if (material._Instanced) {
+				commandBuffer.bindVertexBuffers(INSTANCE_BINDING, { _Scene->GetInstanceBuffer() }, { _Scene->GetDynamicOffset(object) });
+			}
+
+			// The textures are the same across the group, the model matrix is only read without instancing
+			commandBuffer.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics,
+				material.GetPipelineLayout(),
+				0,
+				{
+					_Scene->GetDescriptorSet(_CurrentFrame),
+					object.GetDescriptorSet(_CurrentFrame)
+				},
+				{ sceneOffsets[0], sceneOffsets[1], sceneOffsets[2], _Scene->GetDynamicOffset(object) }
+			);
+
+			if (draws._Culled) {
+				if (_Device.GetEnabledFeatures().multiDrawIndirect) {
+					commandBuffer.drawIndexedIndirect(_Scene->GetDrawCommandBuffer(), draws._Offset, draws._Count, commandSize);
+				}
+				else {
+					for (uint32_t c = 0; c < draws._Count; ++c) {
+						commandBuffer.drawIndexedIndirect(_Scene->GetDrawCommandBuffer(), draws._Offset + c * commandSize, 1, commandSize);
+					}
+				}
+				nbTriangles += draws._NbTriangles;
+				continue;
+			}
+
+			const MeshLod &lod = mesh._Lods[material._Instanced ? instancedLod : object.GetLod()];
+			commandBuffer.drawIndexed(lod._NbIndices, nbInstances, lod._FirstIndex, 0, 0);
+			nbTriangles += uint64_t(lod._NbIndices / 3) * nbInstances;
+		}
+	}
+
+	return nbTriangles;
+}
+
+void Renderer::BuildCommandBuffers(const uint32_t imageIndex)
 {	
 	_CommandBuffers[_CurrentFrame].begin({ vk::CommandBufferUsageFlagBits::eSimultaneousUse });
+
+	_CommandBuffers[_CurrentFrame].resetQueryPool(_TimestampPool, _CurrentFrame * 2, 2);
+	_CommandBuffers[_CurrentFrame].writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, _TimestampPool, _CurrentFrame * 2);
+	_TimestampMode[_CurrentFrame] = _AntiAliasing;
+
 	_Device.StartMarker(_CommandBuffers[_CurrentFrame], "Color Render");
 
 	std::array<vk::ClearValue, 2> clearValues;
@@ -588,7 +795,7 @@ void Renderer::BuildCommandBuffers()
 	_CommandBuffers[_CurrentFrame].beginRenderPass(
 		vk::RenderPassBeginInfo(
 			_RenderPass,
-			_Framebuffers[_CurrentFrame],
+			_Framebuffers[imageIndex],
 			{ {0, 0}, _Surface.GetWindowDimensions() },
 			clearValues.size(),
 			clearValues.data()
@@ -596,6 +803,7 @@ void Renderer::BuildCommandBuffers()
 		vk::SubpassContents::eInline
 	);
 
+	const std::array<uint32_t, 3> &sceneOffsets = _Scene->GetDynamicOffsets();
 	_CommandBuffers[_CurrentFrame].bindDescriptorSets(
 		vk::PipelineBindPoint::eGraphics,
 		_Scene->_Materials.at("basic")->GetPipelineLayout(),
@@ -603,7 +811,7 @@ void Renderer::BuildCommandBuffers()
 		{
 			_Scene->GetDescriptorSet(_CurrentFrame)
 		},
-		{}
+		{ sceneOffsets[0], sceneOffsets[1], sceneOffsets[2] }
 	);
 
 	for (const auto &mat : _Scene->_Materials) {
@@ -612,28 +820,27 @@ void Renderer::BuildCommandBuffers()
 			_CommandBuffers[_CurrentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, mat.second->GetPipeline());
 
 
-			for (const auto &object : _Scene->_Objects[mat.first]) {
-				_CommandBuffers[_CurrentFrame].bindVertexBuffers(0, { object._Mesh._VertexBuffer.GetBuffer() }, { 0 });
-
-				_CommandBuffers[_CurrentFrame].bindDescriptorSets(
-					vk::PipelineBindPoint::eGraphics,
-					mat.second->GetPipelineLayout(),
-					0,
-					{
-						_Scene->GetDescriptorSet(_CurrentFrame),
-						object.GetDescriptorSet(_CurrentFrame)
-					},
-					{ object._DynamicIndex * static_cast<uint32_t>(Object::dynamicAlignement) }
-				);
-
-				_CommandBuffers[_CurrentFrame].draw(object._Mesh._Vertices.size(), 1, 0, 0);
-			}
+			_SubmittedTriangles += DrawObjects(_CommandBuffers[_CurrentFrame], *mat.second, _Scene->_Objects[mat.first], _Scene->_InstanceGroups[mat.first], _Scene->_ClusterDraws[mat.first]);
 			_Device.EndMarker(_CommandBuffers[_CurrentFrame]);
 		}
 	}
 
 	_CommandBuffers[_CurrentFrame].endRenderPass();
+
+	if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+		// Reprojection from the current to the previous frame, without the jitter
+		glm::mat4 viewProjection = _Scene->_Camera.GetUnjitteredProjection() * _Scene->_Camera.GetView();
+		_TemporalAA.Record(_CommandBuffers[_CurrentFrame], imageIndex, _PreviousViewProjection * glm::inverse(viewProjection));
+		_PreviousViewProjection = viewProjection;
+	}
+
 	_Device.EndMarker(_CommandBuffers[_CurrentFrame]);
+
+	_CommandBuffers[_CurrentFrame].writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, _TimestampPool, _CurrentFrame * 2 + 1);
+	_TimestampWritten[_CurrentFrame] = true;
+
+	_GUI.Render(_CommandBuffers[_CurrentFrame], _FramebuffersPresent[imageIndex]);
+
 	_CommandBuffers[_CurrentFrame].end();
 }
 
@@ -642,7 +849,6 @@ void Renderer::CreateSemaphores()
 	_ImageAvailableSemaphore.resize(2);
 	_RenderFinishedSemaphore.resize(2);
 	_InFlightFences.resize(2);
-	_OffscreenFences.resize(2);
 	_ShadowFences.resize(2);
 
 	VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
@@ -654,7 +860,58 @@ void Renderer::CreateSemaphores()
 		_ImageAvailableSemaphore[i] = _Device().createSemaphore({});
 		_RenderFinishedSemaphore[i] = _Device().createSemaphore({});
 		_InFlightFences[i] = _Device().createFence({ vk::FenceCreateFlagBits::eSignaled });
-		_OffscreenFences[i] = _Device().createFence({ vk::FenceCreateFlagBits::eSignaled });
 		_ShadowFences[i] = _Device().createFence({ vk::FenceCreateFlagBits::eSignaled });
 	}
-}
\ No newline at end of file
+}
+
+void Renderer::CreateTimestampQueries()
+{
+	_TimestampPool = _Device().createQueryPool(vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, 2 * 2));
+
+	_TimestampWritten.resize(2, false);
+	_TimestampMode.resize(2, _AntiAliasing);
+}
+
+void Renderer::ReadTimestamps()
+{
+	// Called once the frame fence is signaled, the results are available
+	if (!_TimestampWritten[_CurrentFrame]) {
+		return;
+	}
+
+	std::array<uint64_t, 2> timestamps;
+	vk::Result result = _Device().getQueryPoolResults(
+		_TimestampPool,
+		_CurrentFrame * 2,
+		2,
+		sizeof(uint64_t) * timestamps.size(),
+		timestamps.data(),
+		sizeof(uint64_t),
+		vk::QueryResultFlagBits::e64
+	);
+
+	if (result == vk::Result::eSuccess) {
+		float duration = (timestamps[1] - timestamps[0]) * _Device.GetProperties().limits.timestampPeriod / 1000000.0f;
+		_GUI.aa.AddGpuTime(_TimestampMode[_CurrentFrame], duration);
+	}
+}
+
+vk::SampleCountFlagBits Renderer::GetSampleCount() const
+{
+	return _AntiAliasing == E_ANTI_ALIASING::TAA ? vk::SampleCountFlagBits::e1 : vk::SampleCountFlagBits::e4;
+}
+
+vk::DeviceSize Renderer::GetRenderTargetMemory() const
+{
+	vk::DeviceSize total = _DepthImage.GetMemorySize();
+
+	for (const auto &image : _ImageColor) {
+		total += image.GetMemorySize();
+	}
+
+	if (_AntiAliasing == E_ANTI_ALIASING::TAA) {
+		total += _TemporalAA.GetMemoryUsage();
+	}
+
+	return total;
+}
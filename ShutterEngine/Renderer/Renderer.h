@@ -33,6 +33,8 @@
 #include "GUI/GUI.h"
 #include <chrono>
 #include "Surface.h"
+#include "TemporalAA.h"
+#include "UploadContext.h"
 
 class Renderer {
 public:
@@ -47,6 +49,10 @@ public:
 
 	void ReloadShaders();
 	void Resize();
+	void ToggleGUI();
+
+	// Switch between MSAA and TAA, recreating the colour pass targets
+	void SetAntiAliasing(const E_ANTI_ALIASING mode);
 
 private:
 	void CreateInstance();
@@ -56,11 +62,26 @@ private:
 	void CreateFramebuffers();
 	void CreateCommandPool();
 	void CreateDepth();
+	void CreateShadowMap();
 	void CreateOffscreen();
+	void CreateSceneFramebuffers();
 	void CreateCommandBuffers();
 	void BuildShadowCommandBuffers();
-	void BuildCommandBuffers();
+	void BuildCommandBuffers(const uint32_t imageIndex);
+
+	// Bind the vertex streams and index buffer of the mesh as the material consumes them
+	void BindMesh(const vk::CommandBuffer &commandBuffer, const Material &material, const Mesh &mesh) const;
+
+	// Draw the objects of a material with the given pipeline material, one instanced draw per group when it supports it.
+	// Objects whose meshlets were culled only draw the visible ones. Return the amount of triangles submitted.
+	uint64_t DrawObjects(const vk::CommandBuffer &commandBuffer, const Material &material, const std::vector<Object> &objects, const std::vector<InstanceGroup> &groups, const std::vector<ClusterDraws> &clusters) const;
+
 	void CreateSemaphores();
+	void CreateTimestampQueries();
+	void ReadTimestamps();
+
+	vk::SampleCountFlagBits GetSampleCount() const;
+	vk::DeviceSize GetRenderTargetMemory() const;
 private:
 	// Screen/window related
 	GLFWwindow *_Window;
@@ -76,10 +97,13 @@ private:
 
 	std::vector<Image> _ImageColor;
 	Image _DepthImage;
-	Image _ShadowImage;
 	Texture _ShadowTexture;
 	bool _UpdateShadow = true;
 
+	E_ANTI_ALIASING _AntiAliasing = E_ANTI_ALIASING::MSAA;
+	TemporalAA _TemporalAA;
+	glm::mat4 _PreviousViewProjection = glm::mat4(1.0f);
+
 	std::vector<vk::Framebuffer> _ShadowFramebuffer;
 	std::vector<vk::Framebuffer> _Framebuffers;
 	std::vector<vk::Framebuffer> _FramebuffersPresent;
@@ -91,20 +115,33 @@ private:
 	std::vector<vk::CommandBuffer> _CommandBuffers;
 	std::vector<vk::CommandBuffer> _ShadowCommandBuffers;
 
+	// Batches the copies of the scene resources
+	UploadContext _UploadContext;
+
 	size_t _CurrentFrame = 0;
 
+	// Frames recorded since the start, the deletion queue waits on it
+	uint64_t _FrameNumber = 0;
+
 	// Sync related
 	std::vector<vk::Semaphore> _ImageAvailableSemaphore;
 	std::vector<vk::Semaphore> _RenderFinishedSemaphore;
 	std::vector<vk::Fence> _InFlightFences;
-	std::vector<vk::Fence> _OffscreenFences;
 	std::vector<vk::Fence> _ShadowFences;
 
+	// GPU time of the colour pass, two timestamps per frame
+	vk::QueryPool _TimestampPool;
+	std::vector<bool> _TimestampWritten;
+	std::vector<E_ANTI_ALIASING> _TimestampMode;
+
 	// Scene/Objects related
 	Scene *_Scene;
 
 	GUI _GUI;
 
 	long long _FrameDuration;
+
+	// Triangles of both passes in the last frame, after culling
+	uint64_t _SubmittedTriangles = 0;
 	std::chrono::steady_clock::time_point start;
 };
\ No newline at end of file
@@ -7,7 +7,7 @@
 class Shadow: public Material {
 public:
 	Shadow(){}
-	Shadow(Device *device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize);
+	Shadow(Device *device, Scene *scene, const uint16_t width, const uint16_t height, const uint32_t poolSize, const E_VERTEX_LAYOUT vertexLayout = E_VERTEX_LAYOUT::STANDARD, const bool positionOnly = true, const bool instanced = false);
 
 protected:
 	virtual void CreateMultisampleInfo() override {
@@ -0,0 +1,532 @@
+#include "TemporalAA.h"
+#include <array>
+#include "Helpers.h"
+
+const uint32_t TemporalAA::HISTORY_COUNT;
+
+// Low discrepancy sequence used to distribute the jitter over the pixel
+static float Halton(uint32_t index, const uint32_t base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f / base;
+
+	while (index > 0) {
+		result += fraction * (index % base);
+		index /= base;
+		fraction /= base;
+	}
+
+	return result;
+}
+
+void TemporalAA::Init(Device *device, const vk::CommandPool &cmdPool, const std::string &shaderRoot, const vk::Format colorFormat, const uint32_t nbImages)
+{
+	_Device = device;
+	_CommandPool = cmdPool;
+	_ColorFormat = colorFormat;
+	_NbImages = nbImages;
+
+	_FullscreenShader = Shader(_Device, "fullscreen", shaderRoot + "fullscreen.vert.spv", vk::ShaderStageFlagBits::eVertex);
+	_VelocityShader = Shader(_Device, "taa_velocity", shaderRoot + "taa_velocity.frag.spv", vk::ShaderStageFlagBits::eFragment);
+	_ResolveShader = Shader(_Device, "taa_resolve", shaderRoot + "taa_resolve.frag.spv", vk::ShaderStageFlagBits::eFragment);
+
+	CreateRenderPasses();
+	CreateSamplers();
+	CreateDescriptors();
+	CreatePipelines();
+}
+
+void TemporalAA::Clean()
+{
+	CleanTargets();
+
+	_Device->GetDevice().destroyPipeline(_VelocityPipeline);
+	_Device->GetDevice().destroyPipeline(_ResolvePipeline);
+	_Device->GetDevice().destroyPipelineLayout(_VelocityPipelineLayout);
+	_Device->GetDevice().destroyPipelineLayout(_ResolvePipelineLayout);
+
+	_Device->GetDevice().destroyDescriptorPool(_DescriptorPool);
+	_Device->GetDevice().destroyDescriptorSetLayout(_VelocitySetLayout);
+	_Device->GetDevice().destroyDescriptorSetLayout(_ResolveSetLayout);
+
+	_Device->GetDevice().destroySampler(_LinearSampler);
+	_Device->GetDevice().destroySampler(_PointSampler);
+
+	_Device->GetDevice().destroyRenderPass(_VelocityRenderPass);
+	_Device->GetDevice().destroyRenderPass(_ResolveRenderPass);
+
+	_FullscreenShader.Clean();
+	_VelocityShader.Clean();
+	_ResolveShader.Clean();
+}
+
+void TemporalAA::CreateTargets(const vk::Extent2D &dimensions, const std::vector<Image> &colorImages, const Image &depthImage, const std::vector<Image> &swapchainImages)
+{
+	CleanTargets();
+
+	_Dimensions = dimensions;
+
+	_VelocityImage = Image(
+		_Device,
+		VkExtent3D{ _Dimensions.width, _Dimensions.height, 1 },
+		1,
+		vk::Format::eR16G16Sfloat,
+		vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled
+	);
+	_VelocityImage.SetAsset("TAA velocity");
+
+	_HistoryImages.resize(HISTORY_COUNT);
+	for (auto &history : _HistoryImages) {
+		history = Image(
+			_Device,
+			VkExtent3D{ _Dimensions.width, _Dimensions.height, 1 },
+			1,
+			_ColorFormat,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled
+		);
+		history.SetAsset("TAA history");
+
+		// The first frame samples a history that was never written
+		history.TransitionLayout(_CommandPool, vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+
+	{
+		std::array<vk::ImageView, 1> attachments = {
+			_VelocityImage.GetImageView()
+		};
+
+		_VelocityFramebuffer = _Device->GetDevice().createFramebuffer(vk::FramebufferCreateInfo(
+			{},
+			_VelocityRenderPass,
+			attachments.size(),
+			attachments.data(),
+			_Dimensions.width,
+			_Dimensions.height,
+			1
+		));
+	}
+
+	_ResolveFramebuffers.resize(_NbImages * HISTORY_COUNT);
+	for (size_t i = 0; i < _ResolveFramebuffers.size(); ++i) {
+		std::array<vk::ImageView, 2> attachments = {
+			swapchainImages[i / HISTORY_COUNT].GetImageView(),
+			_HistoryImages[i % HISTORY_COUNT].GetImageView()
+		};
+
+		_ResolveFramebuffers[i] = _Device->GetDevice().createFramebuffer(vk::FramebufferCreateInfo(
+			{},
+			_ResolveRenderPass,
+			attachments.size(),
+			attachments.data(),
+			_Dimensions.width,
+			_Dimensions.height,
+			1
+		));
+	}
+
+	UpdateDescriptorSets(colorImages, depthImage);
+	InvalidateHistory();
+}
+
+void TemporalAA::CleanTargets()
+{
+	if (_VelocityFramebuffer) {
+		_Device->GetDevice().destroyFramebuffer(_VelocityFramebuffer);
+		_VelocityFramebuffer = nullptr;
+	}
+
+	for (auto &fb : _ResolveFramebuffers) {
+		_Device->GetDevice().destroyFramebuffer(fb);
+	}
+	_ResolveFramebuffers.clear();
+
+	if (_VelocityImage.GetImage()) {
+		_VelocityImage.Clean();
+		_VelocityImage = Image();
+	}
+
+	for (auto &history : _HistoryImages) {
+		history.Clean();
+	}
+	_HistoryImages.clear();
+}
+
+glm::vec2 TemporalAA::NextJitter()
+{
+	// Cycle through 8 samples of the (2, 3) Halton sequence
+	_JitterIndex = (_JitterIndex % 8) + 1;
+	_Jitter = glm::vec2(Halton(_JitterIndex, 2) - 0.5f, Halton(_JitterIndex, 3) - 0.5f);
+
+	return _Jitter;
+}
+
+void TemporalAA::Record(const vk::CommandBuffer &cmdBuffer, const uint32_t imageIndex, const glm::mat4 &reprojection)
+{
+	const uint32_t resolve = imageIndex * HISTORY_COUNT + _HistoryIndex;
+
+	vk::Viewport viewport(0.0f, 0.0f, _Dimensions.width, _Dimensions.height, 0.0f, 1.0f);
+	vk::Rect2D scissor({ 0, 0 }, _Dimensions);
+
+	// Velocity from the depth buffer and the camera motion
+	{
+		_Device->StartMarker(cmdBuffer, "TAA velocity");
+		cmdBuffer.beginRenderPass(
+			vk::RenderPassBeginInfo(
+				_VelocityRenderPass,
+				_VelocityFramebuffer,
+				scissor,
+				0,
+				nullptr
+			),
+			vk::SubpassContents::eInline
+		);
+
+		VelocityPushConstant constants = { reprojection };
+
+		cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _VelocityPipeline);
+		cmdBuffer.setViewport(0, viewport);
+		cmdBuffer.setScissor(0, scissor);
+		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _VelocityPipelineLayout, 0, { _VelocitySet }, {});
+		cmdBuffer.pushConstants(_VelocityPipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(VelocityPushConstant), &constants);
+		cmdBuffer.draw(3, 1, 0, 0);
+
+		cmdBuffer.endRenderPass();
+		_Device->EndMarker(cmdBuffer);
+	}
+
+	// Blend the current frame with the history, output to both the swapchain and the next history
+	{
+		_Device->StartMarker(cmdBuffer, "TAA resolve");
+		cmdBuffer.beginRenderPass(
+			vk::RenderPassBeginInfo(
+				_ResolveRenderPass,
+				_ResolveFramebuffers[resolve],
+				scissor,
+				0,
+				nullptr
+			),
+			vk::SubpassContents::eInline
+		);
+
+		ResolvePushConstant constants = {
+			glm::vec2(_Jitter.x / _Dimensions.width, _Jitter.y / _Dimensions.height),
+			_Feedback,
+			_HistoryValid ? 1.0f : 0.0f
+		};
+
+		cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _ResolvePipeline);
+		cmdBuffer.setViewport(0, viewport);
+		cmdBuffer.setScissor(0, scissor);
+		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _ResolvePipelineLayout, 0, { _ResolveSets[resolve] }, {});
+		cmdBuffer.pushConstants(_ResolvePipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(ResolvePushConstant), &constants);
+		cmdBuffer.draw(3, 1, 0, 0);
+
+		cmdBuffer.endRenderPass();
+		_Device->EndMarker(cmdBuffer);
+	}
+
+	_HistoryValid = true;
+	_HistoryIndex = (_HistoryIndex + 1) % HISTORY_COUNT;
+}
+
+vk::DeviceSize TemporalAA::GetMemoryUsage() const
+{
+	vk::DeviceSize total = _VelocityImage.GetMemorySize();
+
+	for (const auto &history : _HistoryImages) {
+		total += history.GetMemorySize();
+	}
+
+	return total;
+}
+
+void TemporalAA::CreateRenderPasses()
+{
+	// Both passes overwrite every pixel, and read what the previous passes wrote
+	std::array<vk::SubpassDependency, 2> dependencies = {
+		vk::SubpassDependency(
+			VK_SUBPASS_EXTERNAL,
+			0,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eFragmentShader,
+			vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eColorAttachmentWrite
+		),
+		vk::SubpassDependency(
+			0,
+			VK_SUBPASS_EXTERNAL,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			vk::AccessFlagBits::eColorAttachmentWrite,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
+		)
+	};
+
+	// Velocity
+	{
+		vk::AttachmentDescription velocityAttachement(
+			{},
+			vk::Format::eR16G16Sfloat,
+			vk::SampleCountFlagBits::e1,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eStore,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined,
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		);
+
+		vk::AttachmentReference velocityAttachementReference(
+			0,
+			vk::ImageLayout::eColorAttachmentOptimal
+		);
+
+		vk::SubpassDescription subpass(
+			{},
+			vk::PipelineBindPoint::eGraphics,
+			0,
+			{},
+			1,
+			&velocityAttachementReference
+		);
+
+		_VelocityRenderPass = _Device->GetDevice().createRenderPass(vk::RenderPassCreateInfo(
+			{},
+			1,
+			&velocityAttachement,
+			1,
+			&subpass,
+			dependencies.size(),
+			dependencies.data()
+		));
+	}
+
+	// Resolve
+	{
+		vk::AttachmentDescription presentAttachement(
+			{},
+			_ColorFormat,
+			vk::SampleCountFlagBits::e1,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eStore,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined,
+			vk::ImageLayout::ePresentSrcKHR
+		);
+
+		vk::AttachmentDescription historyAttachement(
+			{},
+			_ColorFormat,
+			vk::SampleCountFlagBits::e1,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eStore,
+			vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined,
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		);
+
+		std::array<vk::AttachmentReference, 2> attachementReferences = {
+			vk::AttachmentReference(0, vk::ImageLayout::eColorAttachmentOptimal),
+			vk::AttachmentReference(1, vk::ImageLayout::eColorAttachmentOptimal)
+		};
+
+		vk::SubpassDescription subpass(
+			{},
+			vk::PipelineBindPoint::eGraphics,
+			0,
+			{},
+			attachementReferences.size(),
+			attachementReferences.data()
+		);
+
+		std::array<vk::AttachmentDescription, 2> attachements{
+			presentAttachement,
+			historyAttachement
+		};
+
+		_ResolveRenderPass = _Device->GetDevice().createRenderPass(vk::RenderPassCreateInfo(
+			{},
+			attachements.size(),
+			attachements.data(),
+			1,
+			&subpass,
+			dependencies.size(),
+			dependencies.data()
+		));
+	}
+}
+
+void TemporalAA::CreateSamplers()
+{
+	vk::SamplerCreateInfo samplerInfo = {};
+	samplerInfo.magFilter = vk::Filter::eLinear;
+	samplerInfo.minFilter = vk::Filter::eLinear;
+	samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+	samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+	samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+	samplerInfo.anisotropyEnable = false;
+	samplerInfo.maxAnisotropy = 1;
+	samplerInfo.borderColor = vk::BorderColor::eFloatOpaqueBlack;
+	samplerInfo.unnormalizedCoordinates = false;
+	samplerInfo.compareEnable = false;
+	samplerInfo.compareOp = vk::CompareOp::eAlways;
+	samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+
+	_LinearSampler = _Device->GetDevice().createSampler(samplerInfo);
+
+	samplerInfo.magFilter = vk::Filter::eNearest;
+	samplerInfo.minFilter = vk::Filter::eNearest;
+
+	_PointSampler = _Device->GetDevice().createSampler(samplerInfo);
+}
+
+void TemporalAA::CreateDescriptors()
+{
+	// Velocity: scene depth
+	{
+		vk::DescriptorSetLayoutBinding depthInfo(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
+
+		_VelocitySetLayout = _Device->GetDevice().createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, 1, &depthInfo));
+	}
+
+	// Resolve: current colour, history and velocity
+	{
+		std::array<vk::DescriptorSetLayoutBinding, 3> bindings = {
+			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment),
+			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment),
+			vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment)
+		};
+
+		_ResolveSetLayout = _Device->GetDevice().createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, bindings.size(), bindings.data()));
+	}
+
+	const uint32_t nbResolveSets = _NbImages * HISTORY_COUNT;
+
+	vk::DescriptorPoolSize poolSize(vk::DescriptorType::eCombinedImageSampler, 1 + 3 * nbResolveSets);
+	_DescriptorPool = _Device->GetDevice().createDescriptorPool(vk::DescriptorPoolCreateInfo({}, 1 + nbResolveSets, 1, &poolSize));
+
+	_VelocitySet = _Device->GetDevice().allocateDescriptorSets(vk::DescriptorSetAllocateInfo(
+		_DescriptorPool,
+		1,
+		&_VelocitySetLayout
+	)).front();
+
+	std::vector<vk::DescriptorSetLayout> layouts(nbResolveSets, _ResolveSetLayout);
+	_ResolveSets = _Device->GetDevice().allocateDescriptorSets(vk::DescriptorSetAllocateInfo(
+		_DescriptorPool,
+		nbResolveSets,
+		layouts.data()
+	));
+}
+
+void TemporalAA::UpdateDescriptorSets(const std::vector<Image> &colorImages, const Image &depthImage)
+{
+	vk::DescriptorImageInfo depthInfo(_PointSampler, depthImage.GetImageView(), vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+	vk::DescriptorImageInfo velocityInfo(_PointSampler, _VelocityImage.GetImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	std::vector<vk::WriteDescriptorSet> descriptorWrites;
+	descriptorWrites.push_back(vk::WriteDescriptorSet(_VelocitySet, 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &depthInfo));
+
+	// Keep the image infos alive until the update
+	std::vector<vk::DescriptorImageInfo> imageInfos(_ResolveSets.size() * 2);
+
+	for (size_t i = 0; i < _ResolveSets.size(); ++i) {
+		// The resolve writing a history image reads the one written the frame before
+		size_t previous = (i % HISTORY_COUNT + HISTORY_COUNT - 1) % HISTORY_COUNT;
+
+		imageInfos[i * 2 + 0] = vk::DescriptorImageInfo(_PointSampler, colorImages[i / HISTORY_COUNT].GetImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+		imageInfos[i * 2 + 1] = vk::DescriptorImageInfo(_LinearSampler, _HistoryImages[previous].GetImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+
+		descriptorWrites.push_back(vk::WriteDescriptorSet(_ResolveSets[i], 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfos[i * 2 + 0]));
+		descriptorWrites.push_back(vk::WriteDescriptorSet(_ResolveSets[i], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfos[i * 2 + 1]));
+		descriptorWrites.push_back(vk::WriteDescriptorSet(_ResolveSets[i], 2, 0, 1, vk::DescriptorType::eCombinedImageSampler, &velocityInfo));
+	}
+
+	_Device->GetDevice().updateDescriptorSets(descriptorWrites, {});
+}
+
+void TemporalAA::CreatePipelines()
+{
+	{
+		vk::PushConstantRange pushConstant(vk::ShaderStageFlagBits::eFragment, 0, sizeof(VelocityPushConstant));
+		_VelocityPipelineLayout = _Device->GetDevice().createPipelineLayout(vk::PipelineLayoutCreateInfo({}, 1, &_VelocitySetLayout, 1, &pushConstant));
+		_VelocityPipeline = CreatePipeline(_VelocityPipelineLayout, _VelocityRenderPass, _VelocityShader, 1);
+	}
+
+	{
+		vk::PushConstantRange pushConstant(vk::ShaderStageFlagBits::eFragment, 0, sizeof(ResolvePushConstant));
+		_ResolvePipelineLayout = _Device->GetDevice().createPipelineLayout(vk::PipelineLayoutCreateInfo({}, 1, &_ResolveSetLayout, 1, &pushConstant));
+		_ResolvePipeline = CreatePipeline(_ResolvePipelineLayout, _ResolveRenderPass, _ResolveShader, 2);
+	}
+}
+
+vk::Pipeline TemporalAA::CreatePipeline(const vk::PipelineLayout &layout, const vk::RenderPass &renderPass, const Shader &fragment, const uint32_t nbAttachments)
+{
+	std::array<vk::PipelineShaderStageCreateInfo, 2> stages = {
+		_FullscreenShader.GetShaderPipelineInfo(),
+		fragment.GetShaderPipelineInfo()
+	};
+
+	// The fullscreen triangle is generated from the vertex index
+	vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+	vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo({}, vk::PrimitiveTopology::eTriangleList, false);
+
+	// Viewport is dynamic so that a resize does not need new pipelines
+	vk::PipelineViewportStateCreateInfo viewportInfo({}, 1, nullptr, 1, nullptr);
+	std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+	vk::PipelineDynamicStateCreateInfo dynamicInfo({}, dynamicStates.size(), dynamicStates.data());
+
+	vk::PipelineRasterizationStateCreateInfo rasterizationInfo(
+		{},
+		false,
+		false,
+		vk::PolygonMode::eFill,
+		vk::CullModeFlagBits::eNone,
+		vk::FrontFace::eCounterClockwise,
+		false,
+		0,
+		0,
+		0,
+		1.0
+	);
+
+	vk::PipelineMultisampleStateCreateInfo multisampleInfo({}, vk::SampleCountFlagBits::e1, false);
+	vk::PipelineDepthStencilStateCreateInfo depthStencilInfo({}, false, false, vk::CompareOp::eAlways, false, false);
+
+	std::vector<vk::PipelineColorBlendAttachmentState> blendAttachements(nbAttachments, vk::PipelineColorBlendAttachmentState(
+		false,
+		vk::BlendFactor::eOne,
+		vk::BlendFactor::eZero,
+		vk::BlendOp::eAdd,
+		vk::BlendFactor::eOne,
+		vk::BlendFactor::eZero,
+		vk::BlendOp::eAdd,
+		vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+	));
+	vk::PipelineColorBlendStateCreateInfo colorBlendInfo({}, false, {}, blendAttachements.size(), blendAttachements.data());
+
+	vk::GraphicsPipelineCreateInfo pipelineInfo(
+		{},
+		stages.size(),
+		stages.data(),
+		&vertexInputInfo,
+		&inputAssemblyInfo,
+		nullptr,
+		&viewportInfo,
+		&rasterizationInfo,
+		&multisampleInfo,
+		&depthStencilInfo,
+		&colorBlendInfo,
+		&dynamicInfo,
+		layout,
+		renderPass,
+		0
+	);
+
+	return _Device->GetDevice().createGraphicsPipeline(nullptr, pipelineInfo);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+#include "DeviceHandler.h"
+#include "Image.h"
+#include "Shader.h"
+
+enum E_ANTI_ALIASING
+{
+	MSAA,
+	TAA
+};
+
+struct VelocityPushConstant {
+	// Current unjittered clip space to previous unjittered clip space
+	glm::mat4 _Reprojection;
+};
+
+struct ResolvePushConstant {
+	glm::vec2 _Jitter;
+	float _Feedback;
+	float _HistoryValid;
+};
+
+// Temporal anti-aliasing: builds a velocity buffer from the scene depth, then
+// blends the current frame with the reprojected and clamped history
+class TemporalAA {
+public:
+	TemporalAA() {}
+
+	// The shader root holds the compiled shaders from ShutterEngine/Shaders
+	void Init(Device *device, const vk::CommandPool &cmdPool, const std::string &shaderRoot, const vk::Format colorFormat, const uint32_t nbImages);
+	void Clean();
+
+	// (Re)create the targets, to be called on init, resize and mode change
+	void CreateTargets(const vk::Extent2D &dimensions, const std::vector<Image> &colorImages, const Image &depthImage, const std::vector<Image> &swapchainImages);
+	void CleanTargets();
+
+	// Sub-pixel offset for the next frame, in pixels
+	glm::vec2 NextJitter();
+
+	// Record the velocity and the resolve pass, writing to the acquired swapchain image
+	void Record(const vk::CommandBuffer &cmdBuffer, const uint32_t imageIndex, const glm::mat4 &reprojection);
+
+	// Forget the accumulated history, used when the history is not valid anymore
+	void InvalidateHistory() {
+		_HistoryValid = false;
+	}
+
+	// Memory used by the TAA specific targets
+	vk::DeviceSize GetMemoryUsage() const;
+
+	float _Feedback = 0.9f;
+
+private:
+	void CreateRenderPasses();
+	void CreateSamplers();
+	void CreateDescriptors();
+	void CreatePipelines();
+	vk::Pipeline CreatePipeline(const vk::PipelineLayout &layout, const vk::RenderPass &renderPass, const Shader &fragment, const uint32_t nbAttachments);
+
+	void UpdateDescriptorSets(const std::vector<Image> &colorImages, const Image &depthImage);
+
+private:
+	// The history alternates every frame, whatever the order the swapchain images are acquired in
+	static const uint32_t HISTORY_COUNT = 2;
+
+	Device *_Device;
+	vk::CommandPool _CommandPool;
+
+	vk::Format _ColorFormat;
+	vk::Extent2D _Dimensions;
+	uint32_t _NbImages;
+
+	Shader _FullscreenShader;
+	Shader _VelocityShader;
+	Shader _ResolveShader;
+
+	Image _VelocityImage;
+	std::vector<Image> _HistoryImages;
+
+	vk::Sampler _LinearSampler;
+	vk::Sampler _PointSampler;
+
+	vk::RenderPass _VelocityRenderPass;
+	vk::RenderPass _ResolveRenderPass;
+
+	vk::Framebuffer _VelocityFramebuffer;
+
+	// One per swapchain image and history image, at imageIndex * HISTORY_COUNT + history
+	std::vector<vk::Framebuffer> _ResolveFramebuffers;
+
+	vk::DescriptorSetLayout _VelocitySetLayout;
+	vk::DescriptorSetLayout _ResolveSetLayout;
+	vk::DescriptorPool _DescriptorPool;
+	vk::DescriptorSet _VelocitySet;
+	// Indexed like the resolve framebuffers, reading the other history image
+	std::vector<vk::DescriptorSet> _ResolveSets;
+
+	vk::PipelineLayout _VelocityPipelineLayout;
+	vk::PipelineLayout _ResolvePipelineLayout;
+	vk::Pipeline _VelocityPipeline;
+	vk::Pipeline _ResolvePipeline;
+
+	uint32_t _JitterIndex = 0;
+	glm::vec2 _Jitter = glm::vec2(0.0f, 0.0f);
+	bool _HistoryValid = false;
+
+	// History image written by the next resolve
+	uint32_t _HistoryIndex = 0;
+};
@@ -0,0 +1,262 @@
+#include "Tlsf.h"
+
+// Definitions of the constants, some are bound to references
+const uint32_t Tlsf::INVALID_NODE;
+const uint32_t Tlsf::SL_BITS;
+const uint32_t Tlsf::SL_COUNT;
+const uint32_t Tlsf::FL_COUNT;
+
+static uint32_t HighestBit(uint64_t value)
+{
+	uint32_t bit = 0;
+	while (value >>= 1) {
+		++bit;
+	}
+	return bit;
+}
+
+static uint32_t LowestBit(uint64_t value)
+{
+	uint32_t bit = 0;
+	while (!(value & 1)) {
+		value >>= 1;
+		++bit;
+	}
+	return bit;
+}
+
+Tlsf::Tlsf(const uint64_t size) :
+	_Size(size)
+{
+	_SlBitmap.fill(0);
+	for (auto &heads : _FreeHeads) {
+		heads.fill(INVALID_NODE);
+	}
+
+	// Start with a single free node covering everything
+	uint32_t node = NewNode();
+	_Nodes[node].Offset = 0;
+	_Nodes[node].Size = size;
+	InsertFree(node);
+}
+
+uint32_t Tlsf::Allocate(const uint64_t size, const uint64_t alignment, uint64_t & offset)
+{
+	const uint64_t requested = size > 0 ? size : 1;
+
+	// Look for a block big enough to be aligned whatever its offset
+	uint32_t node = FindFree(requested + (alignment > 1 ? alignment - 1 : 0));
+	if (node == INVALID_NODE) {
+		return INVALID_NODE;
+	}
+
+	RemoveFree(node);
+
+	// Give the alignment padding back as a free node in front
+	uint64_t aligned = alignment > 1 ? (_Nodes[node].Offset + alignment - 1) / alignment * alignment : _Nodes[node].Offset;
+	uint64_t padding = aligned - _Nodes[node].Offset;
+	if (padding > 0) {
+		uint32_t front = NewNode();
+		_Nodes[front].Offset = _Nodes[node].Offset;
+		_Nodes[front].Size = padding;
+		_Nodes[front].PreviousPhysical = _Nodes[node].PreviousPhysical;
+		_Nodes[front].NextPhysical = node;
+
+		if (_Nodes[front].PreviousPhysical != INVALID_NODE) {
+			_Nodes[_Nodes[front].PreviousPhysical].NextPhysical = front;
+		}
+
+		_Nodes[node].PreviousPhysical = front;
+		_Nodes[node].Offset += padding;
+		_Nodes[node].Size -= padding;
+
+		InsertFree(front);
+	}
+
+	// Same for what is left after the allocation
+	if (_Nodes[node].Size > requested) {
+		uint32_t tail = NewNode();
+		_Nodes[tail].Offset = _Nodes[node].Offset + requested;
+		_Nodes[tail].Size = _Nodes[node].Size - requested;
+		_Nodes[tail].PreviousPhysical = node;
+		_Nodes[tail].NextPhysical = _Nodes[node].NextPhysical;
+
+		if (_Nodes[tail].NextPhysical != INVALID_NODE) {
+			_Nodes[_Nodes[tail].NextPhysical].PreviousPhysical = tail;
+		}
+
+		_Nodes[node].NextPhysical = tail;
+		_Nodes[node].Size = requested;
+
+		InsertFree(tail);
+	}
+
+	_Nodes[node].Free = false;
+	_Used += _Nodes[node].Size;
+	++_AllocationCount;
+
+	offset = _Nodes[node].Offset;
+	return node;
+}
+
+void Tlsf::Free(const uint32_t node)
+{
+	uint32_t current = node;
+
+	_Used -= _Nodes[current].Size;
+	--_AllocationCount;
+
+	// Merge with the next node
+	uint32_t next = _Nodes[current].NextPhysical;
+	if (next != INVALID_NODE && _Nodes[next].Free) {
+		RemoveFree(next);
+
+		_Nodes[current].Size += _Nodes[next].Size;
+		_Nodes[current].NextPhysical = _Nodes[next].NextPhysical;
+		if (_Nodes[current].NextPhysical != INVALID_NODE) {
+			_Nodes[_Nodes[current].NextPhysical].PreviousPhysical = current;
+		}
+
+		ReleaseNode(next);
+	}
+
+	// Merge with the previous node
+	uint32_t previous = _Nodes[current].PreviousPhysical;
+	if (previous != INVALID_NODE && _Nodes[previous].Free) {
+		RemoveFree(previous);
+
+		_Nodes[previous].Size += _Nodes[current].Size;
+		_Nodes[previous].NextPhysical = _Nodes[current].NextPhysical;
+		if (_Nodes[previous].NextPhysical != INVALID_NODE) {
+			_Nodes[_Nodes[previous].NextPhysical].PreviousPhysical = previous;
+		}
+
+		ReleaseNode(current);
+		current = previous;
+	}
+
+	InsertFree(current);
+}
+
+uint64_t Tlsf::GetLargestFree() const
+{
+	uint64_t largest = 0;
+	for (const auto &node : _Nodes) {
+		if (node.Alive && node.Free && node.Size > largest) {
+			largest = node.Size;
+		}
+	}
+
+	return largest;
+}
+
+void Tlsf::Mapping(const uint64_t size, uint32_t & fl, uint32_t & sl) const
+{
+	if (size < SL_COUNT) {
+		fl = 0;
+		sl = static_cast<uint32_t>(size);
+	}
+	else {
+		uint32_t highest = HighestBit(size);
+		fl = highest - SL_BITS + 1;
+		sl = static_cast<uint32_t>(size >> (highest - SL_BITS)) & (SL_COUNT - 1);
+	}
+}
+
+uint32_t Tlsf::FindFree(const uint64_t size) const
+{
+	// Round up to the next list so that any block found is big enough
+	uint64_t rounded = size;
+	if (rounded >= SL_COUNT) {
+		rounded += (uint64_t(1) << (HighestBit(rounded) - SL_BITS)) - 1;
+	}
+
+	uint32_t fl, sl;
+	Mapping(rounded, fl, sl);
+	if (fl >= FL_COUNT) {
+		return INVALID_NODE;
+	}
+
+	uint32_t slMap = _SlBitmap[fl] & (~0u << sl);
+	if (!slMap) {
+		uint64_t flMap = fl + 1 < FL_COUNT ? _FlBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+		if (!flMap) {
+			return INVALID_NODE;
+		}
+
+		fl = LowestBit(flMap);
+		slMap = _SlBitmap[fl];
+	}
+
+	return _FreeHeads[fl][LowestBit(slMap)];
+}
+
+void Tlsf::InsertFree(const uint32_t node)
+{
+	uint32_t fl, sl;
+	Mapping(_Nodes[node].Size, fl, sl);
+
+	uint32_t head = _FreeHeads[fl][sl];
+	_Nodes[node].Free = true;
+	_Nodes[node].PreviousFree = INVALID_NODE;
+	_Nodes[node].NextFree = head;
+	if (head != INVALID_NODE) {
+		_Nodes[head].PreviousFree = node;
+	}
+
+	_FreeHeads[fl][sl] = node;
+	_FlBitmap |= uint64_t(1) << fl;
+	_SlBitmap[fl] |= 1u << sl;
+}
+
+void Tlsf::RemoveFree(const uint32_t node)
+{
+	uint32_t fl, sl;
+	Mapping(_Nodes[node].Size, fl, sl);
+
+	uint32_t previous = _Nodes[node].PreviousFree;
+	uint32_t next = _Nodes[node].NextFree;
+
+	if (previous != INVALID_NODE) {
+		_Nodes[previous].NextFree = next;
+	}
+	else {
+		_FreeHeads[fl][sl] = next;
+	}
+
+	if (next != INVALID_NODE) {
+		_Nodes[next].PreviousFree = previous;
+	}
+
+	if (_FreeHeads[fl][sl] == INVALID_NODE) {
+		_SlBitmap[fl] &= ~(1u << sl);
+		if (!_SlBitmap[fl]) {
+			_FlBitmap &= ~(uint64_t(1) << fl);
+		}
+	}
+
+	_Nodes[node].Free = false;
+}
+
+uint32_t Tlsf::NewNode()
+{
+	uint32_t node;
+	if (!_UnusedNodes.empty()) {
+		node = _UnusedNodes.back();
+		_UnusedNodes.pop_back();
+	}
+	else {
+		node = static_cast<uint32_t>(_Nodes.size());
+		_Nodes.push_back({});
+	}
+
+	_Nodes[node] = { 0, 0, false, true, INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE };
+	return node;
+}
+
+void Tlsf::ReleaseNode(const uint32_t node)
+{
+	_Nodes[node].Alive = false;
+	_Nodes[node].Free = false;
+	_UnusedNodes.push_back(node);
+}
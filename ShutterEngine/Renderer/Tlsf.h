@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <vector>
+
+// Two-level segregated fit allocator, only manages offsets inside a range of memory
+class Tlsf {
+public:
+	static const uint32_t INVALID_NODE = UINT32_MAX;
+
+	Tlsf() {}
+	explicit Tlsf(const uint64_t size);
+
+	// Return the node owning the allocation, INVALID_NODE if there is no space left
+	uint32_t Allocate(const uint64_t size, const uint64_t alignment, uint64_t &offset);
+	void Free(const uint32_t node);
+
+	uint64_t GetLargestFree() const;
+
+	uint64_t GetSize() const {
+		return _Size;
+	}
+	uint64_t GetUsed() const {
+		return _Used;
+	}
+	uint32_t GetAllocationCount() const {
+		return _AllocationCount;
+	}
+
+private:
+	static const uint32_t SL_BITS = 4;
+	static const uint32_t SL_COUNT = 1 << SL_BITS;
+	static const uint32_t FL_COUNT = 64;
+
+	struct Node {
+		uint64_t Offset;
+		uint64_t Size;
+		bool Free;
+		bool Alive;
+
+		uint32_t PreviousPhysical;
+		uint32_t NextPhysical;
+		uint32_t PreviousFree;
+		uint32_t NextFree;
+	};
+
+	void Mapping(const uint64_t size, uint32_t &fl, uint32_t &sl) const;
+	uint32_t FindFree(const uint64_t size) const;
+
+	void InsertFree(const uint32_t node);
+	void RemoveFree(const uint32_t node);
+
+	uint32_t NewNode();
+	void ReleaseNode(const uint32_t node);
+
+private:
+	uint64_t _Size = 0;
+	uint64_t _Used = 0;
+	uint32_t _AllocationCount = 0;
+
+	std::vector<Node> _Nodes;
+	std::vector<uint32_t> _UnusedNodes;
+
+	// Bitmaps of the non empty free lists, then the head of each list
+	uint64_t _FlBitmap = 0;
+	std::array<uint32_t, FL_COUNT> _SlBitmap;
+	std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> _FreeHeads;
+};
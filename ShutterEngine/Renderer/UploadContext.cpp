@@ -0,0 +1,395 @@
+#include "UploadContext.h"
+#include <limits>
+#include <cstring>
+
+// What reads the uploaded resources once they are on the graphics queue
+static const vk::AccessFlags READ_ACCESS = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead;
+static const vk::PipelineStageFlags READ_STAGES = vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+
+void UploadContext::Init(Device *device, const vk::DeviceSize stagingSize)
+{
+	_Device = device;
+	_StagingSize = stagingSize;
+
+	_GraphicsFamily = _Device->GetQueue(E_QUEUE_TYPE::GRAPHICS).Index;
+	_Async = _Device->HasQueue(E_QUEUE_TYPE::TRANSFER) && _Device->GetQueue(E_QUEUE_TYPE::TRANSFER).Index != _GraphicsFamily;
+	_TransferFamily = _Async ? _Device->GetQueue(E_QUEUE_TYPE::TRANSFER).Index : _GraphicsFamily;
+
+	_CommandPool = _Device->GetDevice().createCommandPool(vk::CommandPoolCreateInfo(
+		vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
+		_TransferFamily
+	));
+
+	if (_Async) {
+		_GraphicsCommandPool = _Device->GetDevice().createCommandPool(vk::CommandPoolCreateInfo(
+			vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
+			_GraphicsFamily
+		));
+	}
+
+	_Staging = Buffer(_Device, vk::BufferUsageFlagBits::eTransferSrc, _StagingSize);
+	_Staging.SetAsset("Upload ring");
+}
+
+void UploadContext::Clean()
+{
+	if (_Recording) {
+		Submit();
+	}
+	while (!_InFlight.empty()) {
+		Retire(true);
+	}
+
+	for (auto &fence : _FreeFences) {
+		_Device->GetDevice().destroyFence(fence);
+	}
+	_FreeFences.clear();
+
+	for (auto &semaphore : _FreeSemaphores) {
+		_Device->GetDevice().destroySemaphore(semaphore);
+	}
+	_FreeSemaphores.clear();
+
+	_Device->GetDevice().destroyCommandPool(_CommandPool);
+	_FreeCommandBuffers.clear();
+
+	if (_Async) {
+		_Device->GetDevice().destroyCommandPool(_GraphicsCommandPool);
+		_FreeGraphicsCommandBuffers.clear();
+	}
+
+	_Staging.Clean();
+}
+
+void UploadContext::CopyToBuffer(const void *data, const vk::DeviceSize size, const Buffer &dst, const vk::DeviceSize dstOffset)
+{
+	vk::DeviceSize offset;
+	vk::Buffer src = Stage(data, size, offset);
+
+	GetCommandBuffer().copyBuffer(src, dst.GetBuffer(), vk::BufferCopy(offset, dstOffset, size));
+}
+
+void UploadContext::CopyToImage(const void *data, const vk::DeviceSize size, const Image &dst, const vk::Extent3D &extent, const uint32_t layer, const uint32_t mipLevel)
+{
+	vk::DeviceSize offset;
+	vk::Buffer src = Stage(data, size, offset);
+
+	vk::BufferImageCopy region;
+	region.bufferOffset = offset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mipLevel, layer, 1);
+	region.imageOffset = vk::Offset3D{ 0, 0, 0 };
+	region.imageExtent = extent;
+
+	GetCommandBuffer().copyBufferToImage(src, dst.GetImage(), vk::ImageLayout::eTransferDstOptimal, region);
+}
+
+const vk::CommandBuffer &UploadContext::GetCommandBuffer()
+{
+	if (!_Recording) {
+		BeginBatch();
+	}
+
+	return _Current.CommandBuffer;
+}
+
+const vk::CommandBuffer &UploadContext::GetGraphicsCommandBuffer()
+{
+	if (!_Async) {
+		return GetCommandBuffer();
+	}
+
+	if (!_Recording) {
+		BeginBatch();
+	}
+
+	return _Current.GraphicsCommandBuffer;
+}
+
+void UploadContext::Release(const Buffer &buffer)
+{
+	// On a single queue the barrier recorded at submit is enough
+	if (!_Async) {
+		return;
+	}
+
+	vk::BufferMemoryBarrier barrier(
+		vk::AccessFlagBits::eTransferWrite,
+		{},
+		_TransferFamily,
+		_GraphicsFamily,
+		buffer.GetBuffer(),
+		0,
+		VK_WHOLE_SIZE
+	);
+	GetCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), nullptr, barrier, nullptr);
+
+	barrier.srcAccessMask = {};
+	barrier.dstAccessMask = READ_ACCESS;
+	GetGraphicsCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, READ_STAGES, vk::DependencyFlags(), nullptr, barrier, nullptr);
+}
+
+void UploadContext::Release(const Image &image, const vk::ImageLayout layout)
+{
+	if (!_Async) {
+		if (layout != vk::ImageLayout::eTransferDstOptimal) {
+			image.TransitionLayout(GetCommandBuffer(), vk::ImageLayout::eTransferDstOptimal, layout);
+		}
+		return;
+	}
+
+	// Both sides of the transfer carry the same layout change, it happens only once
+	vk::ImageMemoryBarrier barrier(
+		vk::AccessFlagBits::eTransferWrite,
+		{},
+		vk::ImageLayout::eTransferDstOptimal,
+		layout,
+		_TransferFamily,
+		_GraphicsFamily,
+		image.GetImage(),
+		image.GetSubresourceRange()
+	);
+	GetCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), nullptr, nullptr, barrier);
+
+	// Images left in TransferDstOptimal are blitted on the graphics queue to generate their mips
+	const bool transfer = layout == vk::ImageLayout::eTransferDstOptimal;
+
+	barrier.srcAccessMask = {};
+	barrier.dstAccessMask = transfer ? vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite : READ_ACCESS;
+	GetGraphicsCommandBuffer().pipelineBarrier(
+		vk::PipelineStageFlagBits::eTopOfPipe,
+		transfer ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer) : READ_STAGES,
+		vk::DependencyFlags(),
+		nullptr,
+		nullptr,
+		barrier
+	);
+}
+
+UploadToken UploadContext::Submit()
+{
+	if (!_Recording) {
+		return _NextToken - 1;
+	}
+
+	// Make the copies visible to whatever reads the resources next
+	vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, READ_ACCESS);
+	GetGraphicsCommandBuffer().pipelineBarrier(
+		vk::PipelineStageFlagBits::eTransfer,
+		READ_STAGES,
+		vk::DependencyFlags(),
+		barrier,
+		nullptr,
+		nullptr
+	);
+
+	_Current.CommandBuffer.end();
+
+	vk::SubmitInfo submitInfo;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &_Current.CommandBuffer;
+
+	if (_Async) {
+		// The copies signal the acquire side, the fence covers both
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &_Current.Semaphore;
+		_Device->GetQueue(E_QUEUE_TYPE::TRANSFER).VulkanQueue.submit(submitInfo, nullptr);
+
+		_Current.GraphicsCommandBuffer.end();
+
+		const vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+		vk::SubmitInfo acquireInfo;
+		acquireInfo.waitSemaphoreCount = 1;
+		acquireInfo.pWaitSemaphores = &_Current.Semaphore;
+		acquireInfo.pWaitDstStageMask = &waitStage;
+		acquireInfo.commandBufferCount = 1;
+		acquireInfo.pCommandBuffers = &_Current.GraphicsCommandBuffer;
+
+		_Device->GetQueue(E_QUEUE_TYPE::GRAPHICS).VulkanQueue.submit(acquireInfo, _Current.Fence);
+	}
+	else {
+		_Device->GetQueue(E_QUEUE_TYPE::GRAPHICS).VulkanQueue.submit(submitInfo, _Current.Fence);
+	}
+
+	_Current.RingEnd = _Head;
+	_InFlight.push_back(std::move(_Current));
+	_Current = Batch();
+	_Recording = false;
+	_Staged = false;
+
+	return _InFlight.back().Token;
+}
+
+bool UploadContext::IsComplete(const UploadToken token)
+{
+	while (!_InFlight.empty() && _InFlight.front().Token <= token) {
+		if (_Device->GetDevice().getFenceStatus(_InFlight.front().Fence) != vk::Result::eSuccess) {
+			break;
+		}
+		Retire(false);
+	}
+
+	return token <= _CompletedToken;
+}
+
+void UploadContext::Wait(const UploadToken token)
+{
+	if (_Recording && token >= _Current.Token) {
+		Submit();
+	}
+
+	while (_CompletedToken < token && !_InFlight.empty()) {
+		Retire(true);
+	}
+}
+
+vk::Buffer UploadContext::Stage(const void *data, const vk::DeviceSize size, vk::DeviceSize &offset)
+{
+	// Big uploads would only starve the ring, give them their own buffer
+	if (size <= _StagingSize / 2) {
+		bool reserved = Reserve(size, offset);
+
+		// Make room by submitting what is pending and waiting for the oldest batches
+		if (!reserved && _Recording) {
+			Submit();
+		}
+		while (!reserved && !_InFlight.empty()) {
+			Retire(true);
+			reserved = Reserve(size, offset);
+		}
+
+		if (reserved) {
+			std::memcpy(static_cast<char*>(_Staging.GetMapped()) + offset, data, size);
+			_Staging.Flush(offset, size);
+
+			return _Staging.GetBuffer();
+		}
+	}
+
+	// Make sure the buffer ends up in the batch it is used by
+	GetCommandBuffer();
+
+	// Released with the batch, so they can share linear staging blocks
+	_Current.Temporaries.push_back(Buffer(
+		_Device,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		size,
+		vk::SharingMode::eExclusive,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		E_ALLOCATION_TYPE::STAGING
+	));
+	_Current.Temporaries.back().Copy(data, size);
+	_Current.Temporaries.back().SetAsset("Upload temporary");
+
+	offset = 0;
+	return _Current.Temporaries.back().GetBuffer();
+}
+
+bool UploadContext::Reserve(const vk::DeviceSize size, vk::DeviceSize &offset)
+{
+	// Enough for the texel size of any format we upload
+	const vk::DeviceSize alignment = 16;
+
+	const bool empty = _InFlight.empty() && !_Staged;
+	if (empty) {
+		_Head = 0;
+		_Tail = 0;
+	}
+
+	vk::DeviceSize aligned = (_Head + alignment - 1) / alignment * alignment;
+
+	if (empty || _Head > _Tail) {
+		// Free space at the end, then at the start of the ring
+		if (aligned + size <= _StagingSize) {
+			offset = aligned;
+		}
+		else if (size <= _Tail) {
+			offset = 0;
+		}
+		else {
+			return false;
+		}
+	}
+	else if (_Head < _Tail && aligned + size <= _Tail) {
+		offset = aligned;
+	}
+	else {
+		return false;
+	}
+
+	// The current batch has to exist to own the reservation
+	GetCommandBuffer();
+	_Staged = true;
+
+	_Head = offset + size;
+	return true;
+}
+
+void UploadContext::BeginBatch()
+{
+	if (_FreeCommandBuffers.empty()) {
+		_FreeCommandBuffers = _Device->GetDevice().allocateCommandBuffers(vk::CommandBufferAllocateInfo(_CommandPool, vk::CommandBufferLevel::ePrimary, 1));
+	}
+	if (_FreeFences.empty()) {
+		_FreeFences.push_back(_Device->GetDevice().createFence(vk::FenceCreateInfo()));
+	}
+
+	_Current.CommandBuffer = _FreeCommandBuffers.back();
+	_FreeCommandBuffers.pop_back();
+	_Current.Fence = _FreeFences.back();
+	_FreeFences.pop_back();
+
+	_Current.Token = _NextToken++;
+	_Staged = false;
+
+	_Current.CommandBuffer.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+	if (_Async) {
+		if (_FreeGraphicsCommandBuffers.empty()) {
+			_FreeGraphicsCommandBuffers = _Device->GetDevice().allocateCommandBuffers(vk::CommandBufferAllocateInfo(_GraphicsCommandPool, vk::CommandBufferLevel::ePrimary, 1));
+		}
+		if (_FreeSemaphores.empty()) {
+			_FreeSemaphores.push_back(_Device->GetDevice().createSemaphore(vk::SemaphoreCreateInfo()));
+		}
+
+		_Current.GraphicsCommandBuffer = _FreeGraphicsCommandBuffers.back();
+		_FreeGraphicsCommandBuffers.pop_back();
+		_Current.Semaphore = _FreeSemaphores.back();
+		_FreeSemaphores.pop_back();
+
+		_Current.GraphicsCommandBuffer.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+	}
+
+	_Recording = true;
+}
+
+void UploadContext::Retire(const bool wait)
+{
+	Batch &batch = _InFlight.front();
+
+	if (wait) {
+		_Device->GetDevice().waitForFences(batch.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+
+	for (auto &buffer : batch.Temporaries) {
+		buffer.Clean();
+	}
+
+	_Device->GetDevice().resetFences(batch.Fence);
+	batch.CommandBuffer.reset({});
+
+	_FreeFences.push_back(batch.Fence);
+	_FreeCommandBuffers.push_back(batch.CommandBuffer);
+
+	if (_Async) {
+		batch.GraphicsCommandBuffer.reset({});
+		_FreeGraphicsCommandBuffers.push_back(batch.GraphicsCommandBuffer);
+		_FreeSemaphores.push_back(batch.Semaphore);
+	}
+
+	_Tail = batch.RingEnd;
+	_CompletedToken = batch.Token;
+
+	_InFlight.pop_front();
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "DeviceHandler.h"
+#include "Buffer.h"
+#include "Image.h"
+
+// Identifies a submitted batch of uploads, 0 is always complete
+typedef uint64_t UploadToken;
+
+// Record many copies and transitions in one command buffer, with the data going
+// through a persistently mapped staging ring.
+// When the device has a transfer queue, copies run there and the resources are
+// handed to the graphics queue with ownership transfers, so they overlap rendering.
+class UploadContext {
+public:
+	UploadContext() {}
+
+	void Init(Device *device, const vk::DeviceSize stagingSize = 64 * 1024 * 1024);
+	void Clean();
+
+	// Copy data to a buffer, the destination needs TransferDst usage
+	void CopyToBuffer(const void *data, const vk::DeviceSize size, const Buffer &dst, const vk::DeviceSize dstOffset = 0);
+
+	// Copy tightly packed texels to a layer and level of an image in TransferDstOptimal layout
+	void CopyToImage(const void *data, const vk::DeviceSize size, const Image &dst, const vk::Extent3D &extent, const uint32_t layer = 0, const uint32_t mipLevel = 0);
+
+	// Command buffer of the current batch on the copy queue, to record transitions to TransferDstOptimal
+	const vk::CommandBuffer &GetCommandBuffer();
+
+	// Command buffer run on the graphics queue once the released resources are acquired, for mip generation
+	const vk::CommandBuffer &GetGraphicsCommandBuffer();
+
+	// Hand a resource written by the copies to the graphics queue, the image goes from TransferDstOptimal to layout
+	void Release(const Buffer &buffer);
+	void Release(const Image &image, const vk::ImageLayout layout);
+
+	// Submit what has been recorded, without waiting for it
+	UploadToken Submit();
+
+	bool IsComplete(const UploadToken token);
+	void Wait(const UploadToken token);
+
+	bool IsAsync() const {
+		return _Async;
+	}
+
+private:
+	struct Batch {
+		vk::CommandBuffer CommandBuffer;
+
+		// Only used with a transfer queue, the acquire side and what the copies signal
+		vk::CommandBuffer GraphicsCommandBuffer;
+		vk::Semaphore Semaphore;
+
+		vk::Fence Fence;
+		UploadToken Token;
+
+		// Staging ring position once this batch is done
+		vk::DeviceSize RingEnd;
+
+		// Uploads too big for the ring
+		std::vector<Buffer> Temporaries;
+	};
+
+	// Return the offset in the staging ring, or a temporary buffer if it does not fit
+	vk::Buffer Stage(const void *data, const vk::DeviceSize size, vk::DeviceSize &offset);
+	bool Reserve(const vk::DeviceSize size, vk::DeviceSize &offset);
+
+	void BeginBatch();
+	void Retire(const bool wait);
+
+private:
+	Device *_Device = nullptr;
+
+	bool _Async = false;
+	uint32_t _TransferFamily = 0;
+	uint32_t _GraphicsFamily = 0;
+
+	vk::CommandPool _CommandPool;
+	vk::CommandPool _GraphicsCommandPool;
+	std::vector<vk::CommandBuffer> _FreeCommandBuffers;
+	std::vector<vk::CommandBuffer> _FreeGraphicsCommandBuffers;
+	std::vector<vk::Semaphore> _FreeSemaphores;
+	std::vector<vk::Fence> _FreeFences;
+
+	Buffer _Staging;
+	vk::DeviceSize _StagingSize = 0;
+	vk::DeviceSize _Head = 0;
+	vk::DeviceSize _Tail = 0;
+
+	bool _Recording = false;
+	bool _Staged = false;
+	Batch _Current;
+	std::deque<Batch> _InFlight;
+
+	UploadToken _NextToken = 1;
+	UploadToken _CompletedToken = 0;
+};
@@ -0,0 +1,47 @@
+// Inputs and decoding of the compact vertex layout, for the vertex shaders of
+// materials declaring "vertexLayout: compact".
+// Define COMPACT_POSITION_ONLY first when the material only reads the position stream.
+
+layout(location = 0) in vec4 inPositionSign;
+#ifndef COMPACT_POSITION_ONLY
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec2 inTangent;
+#endif
+
+layout(push_constant) uniform Quantization {
+	// Bounds of the mesh, position = offset + unorm * scale
+	vec4 offset;
+	vec4 scale;
+} quantization;
+
+vec3 DecodeOctahedron(vec2 encoded)
+{
+	vec3 vector = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-vector.z, 0.0);
+	vector.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(vector.xy, vec2(0.0)));
+	return normalize(vector);
+}
+
+vec3 DecodePosition()
+{
+	return quantization.offset.xyz + inPositionSign.xyz * quantization.scale.xyz;
+}
+
+#ifndef COMPACT_POSITION_ONLY
+vec3 DecodeNormal()
+{
+	return DecodeOctahedron(inNormal);
+}
+
+vec3 DecodeTangent()
+{
+	return DecodeOctahedron(inTangent);
+}
+
+// Rebuilt from the normal and tangent instead of being stored
+vec3 DecodeBitangent()
+{
+	return cross(DecodeNormal(), DecodeTangent()) * (inPositionSign.w * 2.0 - 1.0);
+}
+#endif
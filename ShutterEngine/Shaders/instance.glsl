@@ -0,0 +1,4 @@
+// Model matrix of the vertex shaders of materials declaring "instancing: true", to use in
+// place of the object uniform. It comes from the same frame data, one matrix per instance.
+
+layout(location = 5) in mat4 inInstanceModel;
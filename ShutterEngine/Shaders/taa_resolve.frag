@@ -0,0 +1,50 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D currentMap;
+layout(set = 0, binding = 1) uniform sampler2D historyMap;
+layout(set = 0, binding = 2) uniform sampler2D velocityMap;
+
+layout(push_constant) uniform Constants {
+	vec2 jitter;
+	float feedback;
+	float historyValid;
+} constants;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec4 outHistory;
+
+void main()
+{
+	vec2 texel = 1.0 / vec2(textureSize(currentMap, 0));
+
+	// Remove the jitter of the current frame
+	vec2 uv = inUV - constants.jitter;
+	vec3 current = texture(currentMap, uv).rgb;
+
+	// Neighbourhood bounds used to clamp the history
+	vec3 minColor = current;
+	vec3 maxColor = current;
+	for (int x = -1; x <= 1; ++x) {
+		for (int y = -1; y <= 1; ++y) {
+			vec3 neighbour = texture(currentMap, uv + vec2(x, y) * texel).rgb;
+			minColor = min(minColor, neighbour);
+			maxColor = max(maxColor, neighbour);
+		}
+	}
+
+	vec2 previousUV = inUV + texture(velocityMap, inUV).xy;
+	vec3 history = clamp(texture(historyMap, previousUV).rgb, minColor, maxColor);
+
+	// Drop the history when it falls outside of the screen
+	float feedback = constants.feedback * constants.historyValid;
+	if (any(lessThan(previousUV, vec2(0.0))) || any(greaterThan(previousUV, vec2(1.0)))) {
+		feedback = 0.0;
+	}
+
+	vec3 result = mix(current, history, feedback);
+
+	outColor = vec4(result, 1.0);
+	outHistory = vec4(result, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D depthMap;
+
+layout(push_constant) uniform Constants {
+	// Current unjittered clip space to previous unjittered clip space
+	mat4 reprojection;
+} constants;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec2 outVelocity;
+
+void main()
+{
+	float depth = texture(depthMap, inUV).r;
+
+	vec4 current = vec4(inUV * 2.0 - 1.0, depth, 1.0);
+	vec4 previous = constants.reprojection * current;
+	previous /= previous.w;
+
+	// Offset in UV space to fetch the history
+	outVelocity = (previous.xy - current.xy) * 0.5;
+}
@@ -0,0 +1,489 @@
+#include "AssetBaker.h"
+#include "TextureCompressor.h"
+#include "Engine/MeshData.h"
+#include "Engine/MeshCache.h"
+#include "Engine/TextureContainer.h"
+#include "yaml-cpp/yaml.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <cerrno>
+
+extern char **environ;
+#endif
+
+namespace {
+	uint64_t HashBytes(uint64_t hash, const void *data, const size_t size)
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+#ifdef _WIN32
+	// _spawnvp joins the arguments with spaces, quote them the way the C runtime splits them back
+	std::string QuoteArgument(const std::string &argument)
+	{
+		std::string quoted = "\"";
+		size_t nbBackslashes = 0;
+		for (const char c : argument) {
+			if (c == '\\') {
+				++nbBackslashes;
+				continue;
+			}
+
+			// Backslashes only escape when followed by a quote
+			quoted.append(c == '"' ? nbBackslashes * 2 + 1 : nbBackslashes, '\\');
+			quoted += c;
+			nbBackslashes = 0;
+		}
+		quoted.append(nbBackslashes * 2, '\\');
+
+		return quoted + "\"";
+	}
+#endif
+
+	// Run a program without a shell, so the arguments reach it as they are.
+	// Return its exit status, -1 if it could not be started or did not exit on its own.
+	int RunProgram(const std::vector<std::string> &arguments)
+	{
+#ifdef _WIN32
+		std::vector<std::string> quoted;
+		for (const auto &argument : arguments) {
+			quoted.push_back(QuoteArgument(argument));
+		}
+
+		std::vector<const char*> argv;
+		for (const auto &argument : quoted) {
+			argv.push_back(argument.c_str());
+		}
+		argv.push_back(nullptr);
+
+		return static_cast<int>(_spawnvp(_P_WAIT, arguments.front().c_str(), argv.data()));
+#else
+		std::vector<char*> argv;
+		for (const auto &argument : arguments) {
+			argv.push_back(const_cast<char*>(argument.c_str()));
+		}
+		argv.push_back(nullptr);
+
+		// Rather than fork, the baker runs several jobs at once
+		pid_t pid;
+		if (posix_spawnp(&pid, argv.front(), nullptr, nullptr, argv.data(), environ) != 0) {
+			return -1;
+		}
+
+		int status;
+		while (waitpid(pid, &status, 0) < 0) {
+			if (errno != EINTR) {
+				return -1;
+			}
+		}
+
+		return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+	}
+}
+
+AssetBaker::AssetBaker(const std::string &sceneDirectory, const Options &options) :
+	_Root(sceneDirectory),
+	_Options(options)
+{
+	if (!_Root.empty() && _Root.back() != '/' && _Root.back() != '\\') {
+		_Root += '/';
+	}
+}
+
+size_t AssetBaker::Bake()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	CollectJobs();
+	if (!_Options.Force) {
+		ReadManifest();
+	}
+
+	uint32_t nbThreads = _Options.NbThreads;
+	if (nbThreads == 0) {
+		nbThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	nbThreads = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(nbThreads, _Jobs.size())));
+
+	// Jobs are handed out one at a time, a mesh can take as long as all the textures together
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < _Jobs.size(); i = next++) {
+			Run(_Jobs[i]);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i < nbThreads; ++i) {
+		workers.emplace_back(work);
+	}
+	work();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+
+	size_t nbBaked = 0, nbUpToDate = 0, nbFailed = 0;
+	for (const auto &job : _Jobs) {
+		nbBaked += job.Status == BAKED;
+		nbUpToDate += job.Status == UP_TO_DATE;
+		nbFailed += job.Status == FAILED;
+	}
+
+	if (!WriteManifest()) {
+		std::cerr << "Could not write the manifest: " << GetManifestPath(_Root) << std::endl;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	std::cout << nbBaked << " baked, " << nbUpToDate << " up to date, " << nbFailed << " failed on " << nbThreads << " threads in "
+		<< std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+	return nbFailed;
+}
+
+void AssetBaker::CollectJobs()
+{
+	YAML::Node config = YAML::LoadFile(_Root + "info.yaml");
+
+	// Materials share their shaders
+	std::set<std::string> outputs;
+	auto add = [&](const Job &job) {
+		if (outputs.insert(job.Output).second) {
+			_Jobs.push_back(job);
+		}
+	};
+
+	// The meshes first, they take the longest
+	for (size_t i = 0; i < config["models"].size(); ++i) {
+		Job job;
+		job.Type = MESH;
+		job.Sources = { "models/" + config["models"][i]["filename"].as<std::string>() };
+		job.Output = MeshCache::GetCachePath(job.Sources.front());
+		add(job);
+	}
+
+	// Cube maps are only loaded as RGBA8
+	for (size_t i = 0; i < config["textures"].size(); ++i) {
+		const YAML::Node texture = config["textures"][i];
+		if (texture["type"].as<std::string>() != "normal") {
+			continue;
+		}
+
+		const std::string name = texture["name"].as<std::string>();
+
+		Job job;
+		job.Type = TEXTURE;
+		job.Mips = texture["mipmap"].as<bool>();
+
+		if (texture["format"].IsDefined() && !ParseFormat(texture["format"].as<std::string>(), job.Format)) {
+			throw std::runtime_error("Unknown texture format for " + name + ": " + texture["format"].as<std::string>());
+		}
+
+		// Channel packing: the red channel of each source goes to R, G, B then A
+		if (texture["channels"].IsDefined()) {
+			if (texture["channels"].size() == 0 || texture["channels"].size() > 4) {
+				throw std::runtime_error("A packed texture takes one to four channels: " + name);
+			}
+			for (size_t j = 0; j < texture["channels"].size(); ++j) {
+				job.Sources.push_back("textures/" + texture["channels"][j].as<std::string>());
+			}
+		}
+		else {
+			job.Sources = { "textures/" + name };
+		}
+
+		if (texture["compressed"].IsDefined()) {
+			job.Output = "textures/" + texture["compressed"].as<std::string>();
+		}
+		else {
+			const std::string compressed = name.substr(0, name.find_last_of('.')) + ".ktx2";
+			job.Output = "textures/" + compressed;
+			std::cout << name << ": add \"compressed: " << compressed << "\" to its entry for the scene to load the baked copy" << std::endl;
+		}
+
+		add(job);
+	}
+
+	// Only the shaders whose GLSL source sits next to the SPIR-V
+	const std::string extension = ".spv";
+	for (size_t i = 0; i < config["materials"].size(); ++i) {
+		for (const char *stage : { "vertex", "fragment" }) {
+			const std::string shader = config["materials"][i]["shaders"][stage].as<std::string>();
+			if (shader.size() <= extension.size() || shader.compare(shader.size() - extension.size(), extension.size(), extension) != 0) {
+				continue;
+			}
+
+			Job job;
+			job.Type = SHADER;
+			job.Sources = { "shaders/" + shader.substr(0, shader.size() - extension.size()) };
+			job.Output = "shaders/" + shader;
+			if (FileExists(_Root + job.Sources.front())) {
+				add(job);
+			}
+		}
+	}
+}
+
+void AssetBaker::Run(Job &job)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::string message;
+	std::ostringstream log;
+	job.Hash = HashJob(job);
+	if (job.Hash == 0) {
+		job.Status = FAILED;
+		message = "a source cannot be read";
+	}
+	else {
+		auto entry = _Manifest.find(job.Output);
+		if (entry != _Manifest.end() && entry->second == job.Hash && FileExists(_Root + job.Output)) {
+			job.Status = UP_TO_DATE;
+			return;
+		}
+
+		bool baked = false;
+		switch (job.Type) {
+		case MESH:
+			baked = BakeMesh(job, log, message);
+			break;
+		case TEXTURE:
+			baked = BakeTexture(job, message);
+			break;
+		case SHADER:
+			baked = BakeShader(job, message);
+			break;
+		}
+		job.Status = baked ? BAKED : FAILED;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::lock_guard<std::mutex> lock(_LogMutex);
+	std::cout << log.str();
+	if (job.Status == BAKED) {
+		std::cout << job.Output << ": baked in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+	}
+	else {
+		std::cerr << job.Output << ": " << message << std::endl;
+	}
+}
+
+bool AssetBaker::BakeMesh(const Job &job, std::ostream &log, std::string &message) const
+{
+	const std::string source = _Root + job.Sources.front();
+
+	// The pool already keeps every core busy
+	const std::vector<MeshData> meshes = MeshData::LoadObj(source, 1, log);
+	if (meshes.empty()) {
+		message = "no mesh could be read from " + job.Sources.front();
+		return false;
+	}
+
+	if (!MeshCache::Write(_Root + job.Output, MeshCache::HashFile(source), meshes)) {
+		message = "could not write the mesh cache";
+		return false;
+	}
+
+	return true;
+}
+
+bool AssetBaker::BakeTexture(const Job &job, std::string &message) const
+{
+	TextureCompressor::Image image;
+	for (size_t i = 0; i < job.Sources.size(); ++i) {
+		int width, height, channels;
+		stbi_uc *pixels = stbi_load((_Root + job.Sources[i]).c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels) {
+			message = "could not read " + job.Sources[i];
+			return false;
+		}
+
+		const size_t nbPixels = size_t(width) * height;
+		if (job.Sources.size() == 1) {
+			image.Width = width;
+			image.Height = height;
+			image.Pixels.assign(pixels, pixels + nbPixels * 4);
+		}
+		else {
+			if (i == 0) {
+				image.Width = width;
+				image.Height = height;
+				image.Pixels.assign(nbPixels * 4, 0);
+				for (size_t p = 0; p < nbPixels; ++p) {
+					image.Pixels[p * 4 + 3] = 255;
+				}
+			}
+			else if (image.Width != uint32_t(width) || image.Height != uint32_t(height)) {
+				stbi_image_free(pixels);
+				message = "the packed channels differ in size";
+				return false;
+			}
+
+			for (size_t p = 0; p < nbPixels; ++p) {
+				image.Pixels[p * 4 + i] = pixels[p * 4];
+			}
+		}
+
+		stbi_image_free(pixels);
+	}
+
+	vk::Format format = job.Format;
+	if (format == vk::Format::eUndefined) {
+		bool opaque = true;
+		for (size_t p = 3; p < image.Pixels.size() && opaque; p += 4) {
+			opaque = image.Pixels[p] == 255;
+		}
+		format = opaque ? vk::Format::eBc1RgbUnormBlock : vk::Format::eBc3UnormBlock;
+	}
+
+	const uint32_t width = image.Width, height = image.Height;
+
+	std::vector<TextureCompressor::Image> levels;
+	if (job.Mips) {
+		levels = TextureCompressor::GenerateMips(std::move(image));
+	}
+	else {
+		levels.push_back(std::move(image));
+	}
+
+	std::vector<std::vector<char>> compressed;
+	for (const auto &level : levels) {
+		compressed.push_back(TextureCompressor::Compress(level, format));
+	}
+
+	if (!TextureCompressor::WriteKtx2(_Root + job.Output, format, width, height, compressed)) {
+		message = "could not write the texture";
+		return false;
+	}
+
+	// Read it back the way the engine does
+	TextureContainer container(_Root + job.Output);
+	if (!container.IsValid() || container.GetLevels().size() != levels.size()) {
+		message = "the written texture cannot be read back";
+		return false;
+	}
+
+	return true;
+}
+
+bool AssetBaker::BakeShader(const Job &job, std::string &message) const
+{
+	const int status = RunProgram({ _Options.ShaderCompiler, "-V", _Root + job.Sources.front(), "-o", _Root + job.Output });
+	if (status == -1) {
+		message = "could not run " + _Options.ShaderCompiler;
+		return false;
+	}
+	if (status != 0) {
+		message = "compilation failed, " + _Options.ShaderCompiler + " exited with " + std::to_string(status);
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t AssetBaker::HashJob(const Job &job) const
+{
+	std::ostringstream settings;
+	settings << job.Type << ' ' << (job.Type == MESH ? MeshCache::VERSION : VERSION) << ' ' << static_cast<uint32_t>(job.Format) << ' ' << job.Mips;
+	if (job.Type == SHADER) {
+		settings << ' ' << _Options.ShaderCompiler;
+	}
+
+	const std::string text = settings.str();
+	uint64_t hash = HashBytes(14695981039346656037ull, text.data(), text.size());
+
+	// The names count as well, swapping two packed channels changes the output
+	for (const auto &source : job.Sources) {
+		const uint64_t sourceHash = MeshCache::HashFile(_Root + source);
+		if (sourceHash == 0) {
+			return 0;
+		}
+
+		hash = HashBytes(hash, source.data(), source.size());
+		hash = HashBytes(hash, &sourceHash, sizeof(sourceHash));
+	}
+
+	return hash;
+}
+
+void AssetBaker::ReadManifest()
+{
+	std::ifstream file(GetManifestPath(_Root));
+
+	// One output per line after the hash of its sources
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.size() < 18 || line[16] != ' ') {
+			continue;
+		}
+
+		char *end = nullptr;
+		const uint64_t hash = std::strtoull(line.substr(0, 16).c_str(), &end, 16);
+		if (*end == '\0') {
+			_Manifest[line.substr(17)] = hash;
+		}
+	}
+}
+
+bool AssetBaker::WriteManifest() const
+{
+	// Failed outputs are left out to be baked again, as are those no longer in the scene
+	std::map<std::string, uint64_t> manifest;
+	for (const auto &job : _Jobs) {
+		if (job.Status == BAKED || job.Status == UP_TO_DATE) {
+			manifest[job.Output] = job.Hash;
+		}
+	}
+
+	std::ofstream file(GetManifestPath(_Root), std::ios::trunc);
+	for (const auto &entry : manifest) {
+		file << std::hex << std::setw(16) << std::setfill('0') << entry.second << ' ' << entry.first << '\n';
+	}
+
+	return static_cast<bool>(file);
+}
+
+bool AssetBaker::ParseFormat(const std::string &name, vk::Format &format)
+{
+	static const std::map<std::string, vk::Format> formats = {
+		{ "auto", vk::Format::eUndefined },
+		{ "bc1", vk::Format::eBc1RgbUnormBlock },
+		{ "bc3", vk::Format::eBc3UnormBlock },
+		{ "bc4", vk::Format::eBc4UnormBlock },
+		{ "bc5", vk::Format::eBc5UnormBlock }
+	};
+
+	auto found = formats.find(name);
+	if (found == formats.end()) {
+		return false;
+	}
+
+	format = found->second;
+	return true;
+}
+
+bool AssetBaker::FileExists(const std::string &filename)
+{
+	return std::ifstream(filename).good();
+}
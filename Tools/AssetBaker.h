@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <mutex>
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+// Turn the sources a scene's info.yaml refers to into the files the engine loads: mesh caches,
+// block compressed KTX2 textures and SPIR-V shaders. Each output is recorded in a manifest with a
+// hash of its sources and bake settings, only the outputs whose hash changed are baked again.
+class AssetBaker {
+public:
+	struct Options {
+		// 0 uses every core
+		uint32_t NbThreads = 0;
+
+		// Ignore the manifest and bake everything
+		bool Force = false;
+
+		std::string ShaderCompiler = "glslangValidator";
+	};
+
+	AssetBaker(const std::string &sceneDirectory, const Options &options);
+
+	// Bake what changed since the last run, return the number of outputs that failed
+	size_t Bake();
+
+	static std::string GetManifestPath(const std::string &sceneDirectory) {
+		return sceneDirectory + "bake.manifest";
+	}
+
+	// Increase whenever the texture or shader baking changes, the mesh caches follow MeshCache::VERSION
+	static const uint32_t VERSION = 1;
+
+private:
+	enum E_ASSET_TYPE {
+		MESH,
+		TEXTURE,
+		SHADER
+	};
+
+	enum E_JOB_STATUS {
+		PENDING,
+		UP_TO_DATE,
+		BAKED,
+		FAILED
+	};
+
+	struct Job {
+		E_ASSET_TYPE Type;
+
+		// Relative to the scene directory
+		std::vector<std::string> Sources;
+		std::string Output;
+
+		// Textures only, eUndefined picks BC1 or BC3 from the alpha channel
+		vk::Format Format = vk::Format::eUndefined;
+		bool Mips = true;
+
+		uint64_t Hash = 0;
+		E_JOB_STATUS Status = PENDING;
+	};
+
+	void CollectJobs();
+
+	void Run(Job &job);
+	// What the mesh processing reports goes to log, printed with the result of the job
+	bool BakeMesh(const Job &job, std::ostream &log, std::string &message) const;
+	bool BakeTexture(const Job &job, std::string &message) const;
+	bool BakeShader(const Job &job, std::string &message) const;
+
+	// Hash of the sources and settings, 0 if a source cannot be read
+	uint64_t HashJob(const Job &job) const;
+
+	void ReadManifest();
+	bool WriteManifest() const;
+
+	static bool ParseFormat(const std::string &name, vk::Format &format);
+	static bool FileExists(const std::string &filename);
+
+private:
+	std::string _Root;
+	Options _Options;
+
+	std::vector<Job> _Jobs;
+
+	// Output to the hash of what it was baked from
+	std::map<std::string, uint64_t> _Manifest;
+
+	std::mutex _LogMutex;
+};
@@ -0,0 +1,84 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include "Engine/MeshData.h"
+#include "Engine/MeshCache.h"
+// After the headers including it, the implementation part has no include guard
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+static double Milliseconds(const std::chrono::high_resolution_clock::time_point &start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+	// Compare loading an OBJ file without and with its mesh cache
+	if (argc < 2) {
+		std::cout << "Usage: " << argv[0] << " <file.obj> [iterations]" << std::endl;
+		return 1;
+	}
+
+	const std::string filename = argv[1];
+	const int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+	const std::string path = MeshCache::GetCachePath(filename);
+
+	// Serial: no cache and a single thread, the baseline of the parallel loading
+	std::vector<MeshData> serial;
+	double single = 1e9;
+	for (int i = 0; i < std::max(1, iterations / 5); ++i) {
+		auto start = std::chrono::high_resolution_clock::now();
+		serial = MeshData::LoadObj(filename, 1);
+		single = std::min(single, Milliseconds(start));
+	}
+
+	// Cold: no cache, parse and process everything
+	std::vector<MeshData> reference;
+	double cold = 1e9;
+	for (int i = 0; i < std::max(1, iterations / 5); ++i) {
+		std::remove(path.c_str());
+
+		auto start = std::chrono::high_resolution_clock::now();
+		reference = MeshCache::Load(filename);
+		cold = std::min(cold, Milliseconds(start));
+	}
+
+	// Warm: the cache written by the cold run is used
+	std::vector<MeshData> cached;
+	double warm = 1e9;
+	for (int i = 0; i < iterations; ++i) {
+		auto start = std::chrono::high_resolution_clock::now();
+		cached = MeshCache::Load(filename);
+		warm = std::min(warm, Milliseconds(start));
+	}
+
+	bool identical = reference.size() == cached.size() && reference.size() == serial.size();
+	size_t nbVertices = 0, nbIndices = 0;
+	for (size_t i = 0; identical && i < reference.size(); ++i) {
+		identical = reference[i]._Name == cached[i]._Name
+			&& reference[i]._Vertices.size() == cached[i]._Vertices.size()
+			&& reference[i]._Indices == cached[i]._Indices
+			&& std::memcmp(reference[i]._Vertices.data(), cached[i]._Vertices.data(), reference[i]._Vertices.size() * sizeof(Vertex)) == 0
+			&& reference[i]._Meshlets.size() == cached[i]._Meshlets.size()
+			&& std::memcmp(reference[i]._Meshlets.data(), cached[i]._Meshlets.data(), reference[i]._Meshlets.size() * sizeof(Meshlet)) == 0
+			&& reference[i]._Vertices.size() == serial[i]._Vertices.size()
+			&& reference[i]._Indices == serial[i]._Indices
+			&& std::memcmp(reference[i]._Vertices.data(), serial[i]._Vertices.data(), reference[i]._Vertices.size() * sizeof(Vertex)) == 0;
+
+		nbVertices += reference[i]._Vertices.size();
+		nbIndices += reference[i]._Indices.size();
+	}
+
+	std::cout << reference.size() << " meshes, " << nbVertices << " vertices, " << nbIndices << " indices" << std::endl;
+	std::cout << "Single thread: " << single << " ms" << std::endl;
+	std::cout << "Cold cache: " << cold << " ms (" << std::thread::hardware_concurrency() << " threads)" << std::endl;
+	std::cout << "Warm cache: " << warm << " ms" << std::endl;
+	std::cout << "Cached data " << (identical ? "matches" : "DIFFERS FROM") << " the parsed data" << std::endl;
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,351 @@
+#include "TextureCompressor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace {
+	const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	// Khronos data format values describing the block formats
+	const uint8_t KHR_DF_MODEL_BC1A = 128;
+	const uint8_t KHR_DF_MODEL_BC3 = 130;
+	const uint8_t KHR_DF_MODEL_BC4 = 131;
+	const uint8_t KHR_DF_MODEL_BC5 = 132;
+	const uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+	const uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+	const uint8_t KHR_DF_CHANNEL_BC3_ALPHA = 15;
+
+	template <typename T>
+	void Append(std::vector<char> &stream, const T &value)
+	{
+		const char *bytes = reinterpret_cast<const char*>(&value);
+		stream.insert(stream.end(), bytes, bytes + sizeof(T));
+	}
+
+	uint16_t Pack565(const int color[3])
+	{
+		return uint16_t(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+	}
+
+	void Unpack565(const uint16_t packed, int color[3])
+	{
+		const int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	void WriteLittleEndian(char *output, uint64_t value, const size_t nbBytes)
+	{
+		for (size_t i = 0; i < nbBytes; ++i) {
+			output[i] = static_cast<char>(value & 0xFF);
+			value >>= 8;
+		}
+	}
+
+	// One sample of the data format descriptor, covering 64 bits of the block
+	void AppendSample(std::vector<char> &dfd, const uint16_t bitOffset, const uint8_t channel)
+	{
+		Append(dfd, bitOffset);
+		Append(dfd, uint8_t(63));
+		Append(dfd, channel);
+		Append(dfd, uint32_t(0));
+		Append(dfd, uint32_t(0));
+		Append(dfd, uint32_t(0xFFFFFFFF));
+	}
+
+	std::vector<char> BuildDataFormatDescriptor(const vk::Format format)
+	{
+		uint8_t model = KHR_DF_MODEL_BC1A;
+		std::vector<std::pair<uint16_t, uint8_t>> samples;
+		switch (format) {
+		case vk::Format::eBc3UnormBlock:
+			model = KHR_DF_MODEL_BC3;
+			samples = { { 0, KHR_DF_CHANNEL_BC3_ALPHA }, { 64, 0 } };
+			break;
+		case vk::Format::eBc4UnormBlock:
+			model = KHR_DF_MODEL_BC4;
+			samples = { { 0, 0 } };
+			break;
+		case vk::Format::eBc5UnormBlock:
+			model = KHR_DF_MODEL_BC5;
+			samples = { { 0, 0 }, { 64, 1 } };
+			break;
+		default:
+			samples = { { 0, 0 } };
+			break;
+		}
+
+		const uint16_t blockSize = uint16_t(24 + 16 * samples.size());
+
+		std::vector<char> dfd;
+		Append(dfd, uint32_t(4 + blockSize));
+		Append(dfd, uint32_t(0));
+		Append(dfd, uint16_t(2));
+		Append(dfd, blockSize);
+		Append(dfd, model);
+		Append(dfd, KHR_DF_PRIMARIES_BT709);
+		Append(dfd, KHR_DF_TRANSFER_LINEAR);
+		Append(dfd, uint8_t(0));
+
+		// 4x4 texels in a single plane
+		const uint8_t dimensions[4] = { 3, 3, 0, 0 };
+		dfd.insert(dfd.end(), dimensions, dimensions + 4);
+		uint8_t planes[8] = {};
+		planes[0] = static_cast<uint8_t>(samples.size() * 8);
+		dfd.insert(dfd.end(), planes, planes + 8);
+
+		for (const auto &sample : samples) {
+			AppendSample(dfd, sample.first, sample.second);
+		}
+
+		return dfd;
+	}
+}
+
+std::vector<TextureCompressor::Image> TextureCompressor::GenerateMips(Image image)
+{
+	std::vector<Image> mips;
+	mips.push_back(std::move(image));
+
+	while (mips.back().Width > 1 || mips.back().Height > 1) {
+		const Image &source = mips.back();
+
+		Image level;
+		level.Width = std::max(source.Width / 2, 1u);
+		level.Height = std::max(source.Height / 2, 1u);
+		level.Pixels.resize(size_t(level.Width) * level.Height * 4);
+
+		// An odd row or column is folded into its neighbour
+		for (uint32_t y = 0; y < level.Height; ++y) {
+			const uint32_t y0 = std::min(2 * y, source.Height - 1), y1 = std::min(2 * y + 1, source.Height - 1);
+			for (uint32_t x = 0; x < level.Width; ++x) {
+				const uint32_t x0 = std::min(2 * x, source.Width - 1), x1 = std::min(2 * x + 1, source.Width - 1);
+				for (uint32_t c = 0; c < 4; ++c) {
+					const uint32_t sum = source.Pixels[(size_t(y0) * source.Width + x0) * 4 + c] + source.Pixels[(size_t(y0) * source.Width + x1) * 4 + c]
+						+ source.Pixels[(size_t(y1) * source.Width + x0) * 4 + c] + source.Pixels[(size_t(y1) * source.Width + x1) * 4 + c];
+					level.Pixels[(size_t(y) * level.Width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+
+		mips.push_back(std::move(level));
+	}
+
+	return mips;
+}
+
+bool TextureCompressor::IsSupported(const vk::Format format)
+{
+	return format == vk::Format::eBc1RgbUnormBlock || format == vk::Format::eBc3UnormBlock
+		|| format == vk::Format::eBc4UnormBlock || format == vk::Format::eBc5UnormBlock;
+}
+
+std::vector<char> TextureCompressor::Compress(const Image &image, const vk::Format format)
+{
+	const uint32_t nbBlocksX = (image.Width + 3) / 4;
+	const uint32_t nbBlocksY = (image.Height + 3) / 4;
+	const size_t blockSize = format == vk::Format::eBc1RgbUnormBlock || format == vk::Format::eBc4UnormBlock ? 8 : 16;
+
+	std::vector<char> output(size_t(nbBlocksX) * nbBlocksY * blockSize);
+
+	uint8_t block[16][4];
+	for (uint32_t by = 0; by < nbBlocksY; ++by) {
+		for (uint32_t bx = 0; bx < nbBlocksX; ++bx) {
+			// Blocks over the edge repeat the last row and column
+			for (uint32_t i = 0; i < 16; ++i) {
+				const uint32_t x = std::min(bx * 4 + i % 4, image.Width - 1);
+				const uint32_t y = std::min(by * 4 + i / 4, image.Height - 1);
+				std::memcpy(block[i], &image.Pixels[(size_t(y) * image.Width + x) * 4], 4);
+			}
+
+			char *destination = &output[(size_t(by) * nbBlocksX + bx) * blockSize];
+			switch (format) {
+			case vk::Format::eBc3UnormBlock:
+				CompressChannelBlock(block, 3, destination);
+				CompressColorBlock(block, destination + 8);
+				break;
+			case vk::Format::eBc4UnormBlock:
+				CompressChannelBlock(block, 0, destination);
+				break;
+			case vk::Format::eBc5UnormBlock:
+				CompressChannelBlock(block, 0, destination);
+				CompressChannelBlock(block, 1, destination + 8);
+				break;
+			default:
+				CompressColorBlock(block, destination);
+				break;
+			}
+		}
+	}
+
+	return output;
+}
+
+void TextureCompressor::CompressColorBlock(const uint8_t block[16][4], char *output)
+{
+	int min[3] = { 255, 255, 255 }, max[3] = { 0, 0, 0 }, sum[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			min[c] = std::min<int>(min[c], block[i][c]);
+			max[c] = std::max<int>(max[c], block[i][c]);
+			sum[c] += block[i][c];
+		}
+	}
+
+	// Take the diagonal of the box that follows the colours: a channel going down while the widest goes up is flipped
+	int reference = 0;
+	for (int c = 1; c < 3; ++c) {
+		if (max[c] - min[c] > max[reference] - min[reference]) {
+			reference = c;
+		}
+	}
+	for (int c = 0; c < 3; ++c) {
+		int64_t covariance = 0;
+		for (int i = 0; i < 16; ++i) {
+			covariance += int64_t(block[i][reference] * 16 - sum[reference]) * (block[i][c] * 16 - sum[c]);
+		}
+		if (covariance < 0) {
+			std::swap(min[c], max[c]);
+		}
+	}
+
+	// Pull the ends in by a sixteenth so the outliers do not stretch the palette
+	for (int c = 0; c < 3; ++c) {
+		const int inset = (max[c] - min[c]) / 16;
+		max[c] -= inset;
+		min[c] += inset;
+	}
+
+	uint16_t color0 = Pack565(max), color1 = Pack565(min);
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	// color0 > color1 selects the four colour mode
+	int palette[4][3];
+	Unpack565(color0, palette[0]);
+	Unpack565(color1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1) {
+		for (int i = 0; i < 16; ++i) {
+			int best = 0, bestDistance = 0x7FFFFFFF;
+			for (int p = 0; p < 4; ++p) {
+				int distance = 0;
+				for (int c = 0; c < 3; ++c) {
+					const int delta = block[i][c] - palette[p][c];
+					distance += delta * delta;
+				}
+				if (distance < bestDistance) {
+					best = p;
+					bestDistance = distance;
+				}
+			}
+			indices |= uint32_t(best) << (2 * i);
+		}
+	}
+
+	WriteLittleEndian(output, color0, 2);
+	WriteLittleEndian(output + 2, color1, 2);
+	WriteLittleEndian(output + 4, indices, 4);
+}
+
+void TextureCompressor::CompressChannelBlock(const uint8_t block[16][4], const int channel, char *output)
+{
+	int low = 255, high = 0;
+	for (int i = 0; i < 16; ++i) {
+		low = std::min<int>(low, block[i][channel]);
+		high = std::max<int>(high, block[i][channel]);
+	}
+
+	// The first value above the second selects the eight value mode
+	int values[8] = { high, low };
+	for (int i = 2; i < 8; ++i) {
+		values[i] = ((8 - i) * high + (i - 1) * low + 3) / 7;
+	}
+
+	uint64_t indices = 0;
+	if (high != low) {
+		for (int i = 0; i < 16; ++i) {
+			int best = 0, bestDistance = 256;
+			for (int v = 0; v < 8; ++v) {
+				const int distance = std::abs(block[i][channel] - values[v]);
+				if (distance < bestDistance) {
+					best = v;
+					bestDistance = distance;
+				}
+			}
+			indices |= uint64_t(best) << (3 * i);
+		}
+	}
+
+	output[0] = static_cast<char>(high);
+	output[1] = static_cast<char>(low);
+	WriteLittleEndian(output + 2, indices, 6);
+}
+
+bool TextureCompressor::WriteKtx2(const std::string &filename, const vk::Format format, const uint32_t width, const uint32_t height, const std::vector<std::vector<char>> &levels)
+{
+	const std::vector<char> dfd = BuildDataFormatDescriptor(format);
+
+	const uint32_t nbLevels = static_cast<uint32_t>(levels.size());
+	const size_t levelIndexOffset = sizeof(KTX2_IDENTIFIER) + 17 * sizeof(uint32_t);
+	const size_t dfdOffset = levelIndexOffset + nbLevels * 3 * sizeof(uint64_t);
+
+	std::vector<char> header(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	Append(header, static_cast<uint32_t>(format));
+	Append(header, uint32_t(1));
+	Append(header, width);
+	Append(header, height);
+	Append(header, uint32_t(0));
+	Append(header, uint32_t(0));
+	Append(header, uint32_t(1));
+	Append(header, nbLevels);
+	Append(header, uint32_t(0));
+	Append(header, static_cast<uint32_t>(dfdOffset));
+	Append(header, static_cast<uint32_t>(dfd.size()));
+	Append(header, uint32_t(0));
+	Append(header, uint32_t(0));
+	Append(header, uint64_t(0));
+	Append(header, uint64_t(0));
+
+	// The smallest level is stored first, each aligned on a block
+	const size_t alignment = format == vk::Format::eBc1RgbUnormBlock || format == vk::Format::eBc4UnormBlock ? 8 : 16;
+	std::vector<uint64_t> offsets(nbLevels);
+	size_t offset = dfdOffset + dfd.size();
+	for (uint32_t i = nbLevels; i-- > 0;) {
+		offset = (offset + alignment - 1) / alignment * alignment;
+		offsets[i] = offset;
+		offset += levels[i].size();
+	}
+
+	for (uint32_t i = 0; i < nbLevels; ++i) {
+		Append(header, offsets[i]);
+		Append(header, uint64_t(levels[i].size()));
+		Append(header, uint64_t(levels[i].size()));
+	}
+	header.insert(header.end(), dfd.begin(), dfd.end());
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	file.write(header.data(), header.size());
+	size_t position = header.size();
+	for (uint32_t i = nbLevels; i-- > 0;) {
+		const std::vector<char> padding(offsets[i] - position, 0);
+		file.write(padding.data(), padding.size());
+		file.write(levels[i].data(), levels[i].size());
+		position = offsets[i] + levels[i].size();
+	}
+
+	return static_cast<bool>(file);
+}
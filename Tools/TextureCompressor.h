@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+// Block compression of RGBA8 images for the baker, written as KTX2 files TextureContainer reads back.
+// The encoder fits each block's endpoints to its bounding box, quick rather than best quality.
+class TextureCompressor {
+public:
+	struct Image {
+		std::vector<uint8_t> Pixels;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+	};
+
+	// The image and its mips down to 1x1, halved with a box filter
+	static std::vector<Image> GenerateMips(Image image);
+
+	// BC1 (opaque), BC3, BC4 and BC5, all unsigned normalized. BC4 reads the red channel, BC5 red and green.
+	static std::vector<char> Compress(const Image &image, const vk::Format format);
+
+	// True if Compress handles the format
+	static bool IsSupported(const vk::Format format);
+
+	// The levels must hold the full size image first, each compressed in the given format
+	static bool WriteKtx2(const std::string &filename, const vk::Format format, const uint32_t width, const uint32_t height, const std::vector<std::vector<char>> &levels);
+
+private:
+	static void CompressColorBlock(const uint8_t block[16][4], char *output);
+	static void CompressChannelBlock(const uint8_t block[16][4], const int channel, char *output);
+};
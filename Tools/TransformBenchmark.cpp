@@ -0,0 +1,97 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Engine/TransformSystem.h"
+#include "Engine/WorkerPool.h"
+
+// Reference composition, same as Object::GetModelMatrix
+static glm::mat4 Reference(const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale)
+{
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+	model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	return glm::scale(model, scale);
+}
+
+static double Run(TransformSystem &transforms, std::vector<char> &output, const size_t stride, const uint32_t nbThreads, const int iterations)
+{
+	double best = 1e9;
+	for (int i = 0; i < iterations; ++i) {
+		auto start = std::chrono::high_resolution_clock::now();
+		transforms.ComposeAll(output.data(), stride, nbThreads);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	return best;
+}
+
+int main(int argc, char **argv) {
+	// Compose the world matrices of a large amount of moving objects
+	const size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+	// Same stride as Scene::CreateDynamic, a matrix padded to minUniformBufferOffsetAlignment.
+	// 256 is the largest alignment a device can ask for and what most desktop drivers report.
+	const size_t alignment = argc > 2 ? std::max<size_t>(std::stoul(argv[2]), 1) : 256;
+	const size_t stride = (sizeof(glm::mat4) + alignment - 1) / alignment * alignment;
+	const int iterations = 50;
+
+	std::vector<glm::vec3> positions(count), rotations(count), scales(count);
+
+	TransformSystem transforms;
+	for (size_t i = 0; i < count; ++i) {
+		float f = static_cast<float>(i);
+		positions[i] = glm::vec3(std::sin(f), f * 0.01f, std::cos(f));
+		rotations[i] = glm::vec3(std::fmod(f * 0.3f, 360.0f), std::fmod(f * 0.7f, 360.0f), std::fmod(f * 1.1f, 360.0f));
+		scales[i] = glm::vec3(1.0f + std::fmod(f, 3.0f), 0.5f, 2.0f);
+
+		transforms.Add(positions[i], TransformSystem::FromEuler(rotations[i]), scales[i]);
+	}
+
+	std::vector<char> output(count * stride);
+
+	// Check against the scalar path before timing anything
+	transforms.ComposeAll(output.data(), stride, 1);
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i += 97) {
+		glm::mat4 expected = Reference(positions[i], rotations[i], scales[i]);
+		const float *result = reinterpret_cast<const float*>(output.data() + i * stride);
+
+		for (int c = 0; c < 4; ++c) {
+			for (int r = 0; r < 4; ++r) {
+				maxError = std::max(maxError, std::abs(expected[c][r] - result[c * 4 + r]));
+			}
+		}
+	}
+	std::cout << count << " objects, " << stride << " bytes apart" << std::endl;
+	std::cout << "Max error against glm: " << maxError << std::endl;
+
+	// Baseline, what Scene::Update used to do for every object
+	{
+		double best = 1e9;
+		for (int i = 0; i < iterations / 10; ++i) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t j = 0; j < count; ++j) {
+				*reinterpret_cast<glm::mat4*>(output.data() + j * stride) = Reference(positions[j], rotations[j], scales[j]);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		std::cout << "Euler matrices, 1 thread: " << best << " ms" << std::endl;
+	}
+
+	std::cout << "SoA composition, 1 thread: " << Run(transforms, output, stride, 1, iterations) << " ms" << std::endl;
+
+	// The workers of the shared pool and the calling thread
+	uint32_t nbThreads = WorkerPool::GetShared().GetThreadCount() + 1;
+	std::cout << "SoA composition, " << nbThreads << " threads: " << Run(transforms, output, stride, nbThreads, iterations) << " ms" << std::endl;
+
+	return maxError < 1e-4f ? 0 : 1;
+}
@@ -1,26 +1,58 @@
 #include <string>
 #include <iostream>
-#include <assert.h>
-   #define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
 #include <fstream>
+#include <vector>
+#include <stdexcept>
+#include "Engine/MeshOptimizer.h"
+#include "AssetBaker.h"
+// After the headers including it, the implementation part has no include guard
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#define STB_IMAGE_IMPLEMENTATION
+// The failure strings are a global written by every load, images are decoded on several threads
+#define STBI_NO_FAILURE_STRINGS
+#include "stb_image.h"
 
-int main(int argc, char **argv) {
-	// Generate a scene file from the given obj
-	assert(argc > 1);
+// Report what the load time optimization gains on the positions of a shape
+static void ReportOptimization(const tinyobj::shape_t &shape, const tinyobj::attrib_t &attrib)
+{
+	std::vector<float> positions(attrib.vertices);
+	std::vector<uint32_t> indices;
+	indices.reserve(shape.mesh.indices.size());
+	for (const auto &index : shape.mesh.indices) {
+		indices.push_back(static_cast<uint32_t>(index.vertex_index));
+	}
 
-	std::cout << "Generating scene file for: " << argv[1] << std::endl;
+	const size_t nbVertices = MeshOptimizer::OptimizeVertexFetch(positions.data(), positions.size() / 3, 3 * sizeof(float), indices.data(), indices.size());
+	const MeshOptimizer::Statistics before = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), nbVertices);
 
-	std::ofstream file("scene.yaml");
+	MeshOptimizer::Optimize(positions.data(), nbVertices, 3 * sizeof(float), indices.data(), indices.size());
+	const MeshOptimizer::Statistics after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), nbVertices);
+
+	std::cout << shape.name << ": ACMR " << before.ACMR << " -> " << after.ACMR << ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
+}
+
+// Generate a scene file from the given obj
+static int GenerateScene(const std::string &filename, const std::string &materialDirectory, const bool reportOptimization)
+{
+	std::cout << "Generating scene file for: " << filename << std::endl;
 
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
 
 	std::string err;
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, argv[1], std::string(std::string(argv[2]) + "\\").c_str());
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename.c_str(), (materialDirectory + "/").c_str())) {
+		std::cerr << "Could not read " << filename << ": " << err << std::endl;
+		return 1;
+	}
+
+	std::ofstream file("scene.yaml");
 
 	for (size_t i = 0; i < shapes.size(); ++i) {
+		if (reportOptimization) {
+			ReportOptimization(shapes[i], attrib);
+		}
 
 		file << "  - name: " << shapes[i].name << "\n";
 		file << "    model: " << shapes[i].name << "\n";
@@ -71,5 +103,57 @@ int main(int argc, char **argv) {
 
 	file.close();
 
-	system("PAUSE");
-}
\ No newline at end of file
+	return 0;
+}
+
+static void PrintUsage(const char *name)
+{
+	std::cout << "Usage:" << std::endl;
+	std::cout << "  " << name << " bake <scene directory> [--threads N] [--force] [--glslang <compiler>]" << std::endl;
+	std::cout << "  " << name << " scene <file.obj> <material directory> [--mesh-stats]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	const std::string command = argv[1];
+
+	if (command == "scene" && argc > 3) {
+		return GenerateScene(argv[2], argv[3], argc > 4 && std::string(argv[4]) == "--mesh-stats");
+	}
+
+	if (command == "bake") {
+		AssetBaker::Options options;
+		for (int i = 3; i < argc; ++i) {
+			const std::string option = argv[i];
+			if (option == "--force") {
+				options.Force = true;
+			}
+			else if (option == "--threads" && i + 1 < argc) {
+				options.NbThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (option == "--glslang" && i + 1 < argc) {
+				options.ShaderCompiler = argv[++i];
+			}
+			else {
+				PrintUsage(argv[0]);
+				return 1;
+			}
+		}
+
+		try {
+			AssetBaker baker(argv[2], options);
+			return baker.Bake() == 0 ? 0 : 1;
+		}
+		catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	PrintUsage(argv[0]);
+	return 1;
+}
@@ -4,6 +4,8 @@
 #include "Ext/tiny_obj_loader.h"
 
 #define STB_IMAGE_IMPLEMENTATION
+// The failure strings are a global written by every load, images are decoded on several threads
+#define STBI_NO_FAILURE_STRINGS
 #include "Ext/stb_image.h"
 
 int main() {